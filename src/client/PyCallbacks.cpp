@@ -19,10 +19,7 @@
 
 #include "PyCallbacks.h"
 
-#include <pybind11/pybind11.h>
-#include <pybind11/stl.h>
-
-namespace py = pybind11;
+#include <algorithm>
 
 void PyCallbacks::addGeometry(const size_t initialShapeIndex, const double* vertexCoords,
                               const size_t vertexCoordsCount, const uint32_t* faceIndices,
@@ -40,25 +37,79 @@ void PyCallbacks::addGeometry(const size_t initialShapeIndex, const double* vert
 		currentModel.mFaces.insert(currentModel.mFaces.end(), faceCounts, faceCounts + faceCountsCount);
 }
 
+void PyCallbacks::addGeometryComponents(const size_t initialShapeIndex, const double* x, const double* y,
+                                        const double* z, const size_t vertexCount, const uint32_t* faceIndices,
+                                        const size_t faceIndicesCount, const uint32_t* faceCounts,
+                                        const size_t faceCountsCount) {
+	std::array<std::vector<double>, 3>& components = mModels[initialShapeIndex].mVertexComponents;
+	const double* src[3] = {x, y, z};
+	for (size_t c = 0; c < 3; c++) {
+		if (src[c] != nullptr)
+			components[c].insert(components[c].end(), src[c], src[c] + vertexCount);
+	}
+
+	addGeometry(initialShapeIndex, nullptr, 0, faceIndices, faceIndicesCount, faceCounts, faceCountsCount);
+}
+
+void PyCallbacks::addFaceClasses(const size_t initialShapeIndex, const uint8_t* faceClasses, const size_t faceCount,
+                                 const double* classAreas) {
+	Model& currentModel = mModels[initialShapeIndex];
+	currentModel.mFaceClasses.insert(currentModel.mFaceClasses.end(), faceClasses, faceClasses + faceCount);
+	for (size_t c = 0; c < FACE_CLASS_COUNT; c++)
+		currentModel.mFaceClassAreas[c] += classAreas[c];
+}
+
 void PyCallbacks::addReports(const size_t initialShapeIndex, const wchar_t** stringReportKeys,
                              const wchar_t** stringReportValues, size_t stringReportCount,
                              const wchar_t** floatReportKeys, const double* floatReportValues, size_t floatReportCount,
                              const wchar_t** boolReportKeys, const bool* boolReportValues, size_t boolReportCount) {
 
-	Model& currentModel = mModels[initialShapeIndex];
+	pcu::Reports& reports = mModels[initialShapeIndex].mCGAReport;
 
-	for (size_t i = 0; i < boolReportCount; i++) {
-		py::object pyKey = py::cast(boolReportKeys[i]);
-		currentModel.mCGAReport[pyKey] = boolReportValues[i];
-	}
+	reports.boolKeys.insert(reports.boolKeys.end(), boolReportKeys, boolReportKeys + boolReportCount);
+	reports.boolValues.insert(reports.boolValues.end(), boolReportValues, boolReportValues + boolReportCount);
 
-	for (size_t i = 0; i < floatReportCount; i++) {
-		py::object pyKey = py::cast(floatReportKeys[i]);
-		currentModel.mCGAReport[pyKey] = floatReportValues[i];
-	}
+	reports.floatKeys.insert(reports.floatKeys.end(), floatReportKeys, floatReportKeys + floatReportCount);
+	reports.floatValues.insert(reports.floatValues.end(), floatReportValues, floatReportValues + floatReportCount);
+
+	reports.stringKeys.insert(reports.stringKeys.end(), stringReportKeys, stringReportKeys + stringReportCount);
+	reports.stringValues.insert(reports.stringValues.end(), stringReportValues,
+	                            stringReportValues + stringReportCount);
+}
+
+void PyCallbacks::addLeafAttributes(const size_t initialShapeIndex, const wchar_t* const* keys, size_t keyCount,
+                                    const int32_t* boolShapeIDs, const uint32_t* boolKeyIndices, const bool* boolValues,
+                                    size_t boolCount, const int32_t* floatShapeIDs, const uint32_t* floatKeyIndices,
+                                    const double* floatValues, size_t floatCount, const int32_t* stringShapeIDs,
+                                    const uint32_t* stringKeyIndices, const wchar_t* const* stringValues,
+                                    size_t stringCount) {
 
-	for (size_t i = 0; i < stringReportCount; i++) {
-		py::object pyKey = py::cast(stringReportKeys[i]);
-		currentModel.mCGAReport[pyKey] = stringReportValues[i];
+	pcu::LeafAttributes& leafAttributes = mModels[initialShapeIndex].mLeafAttributes;
+
+	// key indices of later calls are remapped onto the keys already known
+	std::vector<uint32_t> keyMap(keyCount);
+	for (size_t k = 0; k < keyCount; k++) {
+		const auto it = std::find(leafAttributes.keys.begin(), leafAttributes.keys.end(), keys[k]);
+		keyMap[k] = static_cast<uint32_t>(it - leafAttributes.keys.begin());
+		if (it == leafAttributes.keys.end())
+			leafAttributes.keys.emplace_back(keys[k]);
 	}
+	auto appendKeyIndices = [&keyMap](std::vector<uint32_t>& dst, const uint32_t* src, size_t count) {
+		for (size_t i = 0; i < count; i++)
+			dst.push_back(keyMap[src[i]]);
+	};
+
+	leafAttributes.boolShapeIds.insert(leafAttributes.boolShapeIds.end(), boolShapeIDs, boolShapeIDs + boolCount);
+	appendKeyIndices(leafAttributes.boolKeyIndices, boolKeyIndices, boolCount);
+	leafAttributes.boolValues.insert(leafAttributes.boolValues.end(), boolValues, boolValues + boolCount);
+
+	leafAttributes.floatShapeIds.insert(leafAttributes.floatShapeIds.end(), floatShapeIDs,
+	                                    floatShapeIDs + floatCount);
+	appendKeyIndices(leafAttributes.floatKeyIndices, floatKeyIndices, floatCount);
+	leafAttributes.floatValues.insert(leafAttributes.floatValues.end(), floatValues, floatValues + floatCount);
+
+	leafAttributes.stringShapeIds.insert(leafAttributes.stringShapeIds.end(), stringShapeIDs,
+	                                     stringShapeIDs + stringCount);
+	appendKeyIndices(leafAttributes.stringKeyIndices, stringKeyIndices, stringCount);
+	leafAttributes.stringValues.insert(leafAttributes.stringValues.end(), stringValues, stringValues + stringCount);
 }
@@ -20,32 +20,58 @@
 #pragma once
 
 #include "IPyCallbacks.h"
+#include "attributeColumns.h"
+#include "reports.h"
 
 #include "prt/Callbacks.h"
 
-#include <pybind11/pybind11.h>
-#include <pybind11/stl.h>
-
+#include <array>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
-namespace py = pybind11;
-
 class PyCallbacks : public IPyCallbacks {
+public:
+	// receives the error and CGA print messages, may be called from PRT worker threads
+	using MessageHandler = std::function<void(const std::wstring&)>;
+
 private:
 	struct Model {
-		py::dict mCGAReport;
+		pcu::Reports mCGAReport;
 		std::vector<double> mVertices;
+		std::array<std::vector<double>, 3> mVertexComponents; // x, y and z with the "soa" vertex layout
 		std::vector<uint32_t> mIndices;
 		std::vector<uint32_t> mFaces;
+		std::vector<uint8_t> mFaceClasses;
+		std::array<double, FACE_CLASS_COUNT> mFaceClassAreas = {0.0, 0.0, 0.0};
+		pcu::AttributeValues mAttributes; // reported by the attribute evaluation
+		pcu::LeafAttributes mLeafAttributes;
 	};
 
 	std::vector<Model> mModels;
+	std::vector<double> mOffsets; // 3 per initial shape or empty
+	MessageHandler mMessageHandler;
+
+	// space separated like the Python print function
+	template <typename... Args>
+	void printMessage(const Args&... args) {
+		std::wostringstream out;
+		const wchar_t* separator = L"";
+		((out << separator << args, separator = L" "), ...);
+		if (mMessageHandler)
+			mMessageHandler(out.str());
+		else
+			std::wcout << out.str() << std::endl;
+	}
 
 public:
-	PyCallbacks(const size_t initialShapeCount) {
+	PyCallbacks(const size_t initialShapeCount, const std::vector<double>& offsets = {},
+	            MessageHandler messageHandler = {})
+	    : mOffsets(offsets), mMessageHandler(std::move(messageHandler)) {
 		mModels.resize(initialShapeCount);
 	}
 
@@ -55,11 +81,31 @@ public:
 	                 const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
 	                 const size_t faceCountsCount) override;
 
+	void addGeometryComponents(const size_t initialShapeIndex, const double* x, const double* y, const double* z,
+	                           const size_t vertexCount, const uint32_t* faceIndices, const size_t faceIndicesCount,
+	                           const uint32_t* faceCounts, const size_t faceCountsCount) override;
+
+	void addFaceClasses(const size_t initialShapeIndex, const uint8_t* faceClasses, const size_t faceCount,
+	                    const double* classAreas) override;
+
 	void addReports(const size_t initialShapeIndex, const wchar_t** stringReportKeys,
 	                const wchar_t** stringReportValues, size_t stringReportCount, const wchar_t** floatReportKeys,
 	                const double* floatReportValues, size_t floatReportCount, const wchar_t** boolReportKeys,
 	                const bool* boolReportValues, size_t boolReportCount) override;
 
+	void addLeafAttributes(const size_t initialShapeIndex, const wchar_t* const* keys, size_t keyCount,
+	                       const int32_t* boolShapeIDs, const uint32_t* boolKeyIndices, const bool* boolValues,
+	                       size_t boolCount, const int32_t* floatShapeIDs, const uint32_t* floatKeyIndices,
+	                       const double* floatValues, size_t floatCount, const int32_t* stringShapeIDs,
+	                       const uint32_t* stringKeyIndices, const wchar_t* const* stringValues,
+	                       size_t stringCount) override;
+
+	const double* getOffset(const size_t initialShapeIndex) const override {
+		if (3 * initialShapeIndex + 3 > mOffsets.size())
+			return nullptr;
+		return mOffsets.data() + 3 * initialShapeIndex;
+	}
+
 	size_t getInitialShapeCount() const {
 		return mModels.size();
 	}
@@ -71,6 +117,13 @@ public:
 		return mModels[initialShapeIdx].mVertices;
 	}
 
+	const std::array<std::vector<double>, 3>& getVertexComponents(const size_t initialShapeIdx) const {
+		if (initialShapeIdx >= mModels.size())
+			throw std::out_of_range("initial shape index is out of range.");
+
+		return mModels[initialShapeIdx].mVertexComponents;
+	}
+
 	const std::vector<uint32_t>& getIndices(const size_t initialShapeIdx) const {
 		if (initialShapeIdx >= mModels.size())
 			throw std::out_of_range("initial shape index is out of range.");
@@ -85,32 +138,60 @@ public:
 		return mModels[initialShapeIdx].mFaces;
 	}
 
-	const py::dict& getReport(const size_t initialShapeIdx) const {
+	const std::vector<uint8_t>& getFaceClasses(const size_t initialShapeIdx) const {
+		if (initialShapeIdx >= mModels.size())
+			throw std::out_of_range("initial shape index is out of range.");
+
+		return mModels[initialShapeIdx].mFaceClasses;
+	}
+
+	const std::array<double, FACE_CLASS_COUNT>& getFaceClassAreas(const size_t initialShapeIdx) const {
+		if (initialShapeIdx >= mModels.size())
+			throw std::out_of_range("initial shape index is out of range.");
+
+		return mModels[initialShapeIdx].mFaceClassAreas;
+	}
+
+	const pcu::Reports& getReport(const size_t initialShapeIdx) const {
 		if (initialShapeIdx >= mModels.size())
 			throw std::out_of_range("initial shape index is out of range.");
 
 		return mModels[initialShapeIdx].mCGAReport;
 	}
 
+	const pcu::LeafAttributes& getLeafAttributes(const size_t initialShapeIdx) const {
+		if (initialShapeIdx >= mModels.size())
+			throw std::out_of_range("initial shape index is out of range.");
+
+		return mModels[initialShapeIdx].mLeafAttributes;
+	}
+
+	const pcu::AttributeValues& getAttributes(const size_t initialShapeIdx) const {
+		if (initialShapeIdx >= mModels.size())
+			throw std::out_of_range("initial shape index is out of range.");
+
+		return mModels[initialShapeIdx].mAttributes;
+	}
+
 	prt::Status generateError(size_t isIndex, prt::Status status, const wchar_t* message) {
-		pybind11::print(L"GENERATE ERROR:", isIndex, status, message);
+		printMessage(L"GENERATE ERROR:", isIndex, status, message);
 		return prt::STATUS_OK;
 	}
 
 	prt::Status assetError(size_t isIndex, prt::CGAErrorLevel level, const wchar_t* key, const wchar_t* uri,
 	                       const wchar_t* message) {
-		pybind11::print(L"ASSET ERROR:", isIndex, level, key, uri, message);
+		printMessage(L"ASSET ERROR:", isIndex, level, key, uri, message);
 		return prt::STATUS_OK;
 	}
 
 	prt::Status cgaError(size_t isIndex, int32_t shapeID, prt::CGAErrorLevel level, int32_t methodId, int32_t pc,
 	                     const wchar_t* message) {
-		pybind11::print(L"CGA ERROR:", isIndex, shapeID, level, methodId, pc, message);
+		printMessage(L"CGA ERROR:", isIndex, shapeID, level, methodId, pc, message);
 		return prt::STATUS_OK;
 	}
 
 	prt::Status cgaPrint(size_t isIndex, int32_t shapeID, const wchar_t* txt) {
-		pybind11::print(L"CGA PRINT:", isIndex, shapeID, txt);
+		printMessage(L"CGA PRINT:", isIndex, shapeID, txt);
 		return prt::STATUS_OK;
 	}
 
@@ -127,30 +208,35 @@ public:
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrBool(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/, bool /*value*/) {
+	prt::Status attrBool(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, bool value) {
+		mModels[isIndex].mAttributes.addBool(key, value);
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrFloat(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/, double /*value*/) {
+	prt::Status attrFloat(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, double value) {
+		mModels[isIndex].mAttributes.addFloat(key, value);
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrString(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/, const wchar_t* /*value*/) {
+	prt::Status attrString(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, const wchar_t* value) {
+		mModels[isIndex].mAttributes.addString(key, value);
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrBoolArray(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/, const bool* /*ptr*/,
-	                          size_t /*size*/) {
+	prt::Status attrBoolArray(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, const bool* ptr, size_t size) {
+		mModels[isIndex].mAttributes.addBoolArray(key, ptr, size);
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrFloatArray(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/, const double* /*ptr*/,
-	                           size_t /*size*/) {
+	prt::Status attrFloatArray(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, const double* ptr,
+	                           size_t size) {
+		mModels[isIndex].mAttributes.addFloatArray(key, ptr, size);
 		return prt::STATUS_OK;
 	}
 
-	prt::Status attrStringArray(size_t /*isIndex*/, int32_t /*shapeID*/, const wchar_t* /*key*/,
-	                            const wchar_t* const* /*ptr*/, size_t /*size*/) {
+	prt::Status attrStringArray(size_t isIndex, int32_t /*shapeID*/, const wchar_t* key, const wchar_t* const* ptr,
+	                            size_t size) {
+		mModels[isIndex].mAttributes.addStringArray(key, ptr, size);
 		return prt::STATUS_OK;
 	}
 };
@@ -0,0 +1,693 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "arrowWriter.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * Minimal flatbuffers builder, sufficient for the Arrow IPC metadata (tables, strings, vectors of offsets and
+ * vectors of structs). Like the reference implementation, the buffer is built back to front: objects are referenced
+ * by their distance from the end of the buffer, which is what the returned offsets are.
+ */
+class FlatBufferBuilder {
+public:
+	using Offset = uint32_t;
+
+	Offset size() const {
+		return static_cast<Offset>(mReversed.size());
+	}
+
+	Offset createString(const std::string& s) {
+		prep(4, s.size() + 1);
+		mReversed.push_back(0);
+		pushBytes(s.data(), s.size());
+		push<uint32_t>(static_cast<uint32_t>(s.size()));
+		return size();
+	}
+
+	Offset createOffsetVector(const std::vector<Offset>& offsets) {
+		prep(4, 4 * offsets.size());
+		for (size_t i = offsets.size(); i > 0; i--)
+			pushOffset(offsets[i - 1]);
+		push<uint32_t>(static_cast<uint32_t>(offsets.size()));
+		return size();
+	}
+
+	Offset createStructVector(const void* data, size_t elementSize, size_t count, size_t alignment) {
+		prep(4, elementSize * count);
+		prep(alignment, elementSize * count);
+		pushBytes(data, elementSize * count);
+		push<uint32_t>(static_cast<uint32_t>(count));
+		return size();
+	}
+
+	void startTable() {
+		mFields.clear();
+		mTableStart = size();
+	}
+
+	template <typename T>
+	void addScalar(uint16_t id, T v) {
+		prep(sizeof(T), 0);
+		push<T>(v);
+		mFields.emplace_back(id, size());
+	}
+
+	void addOffset(uint16_t id, Offset target) {
+		pushOffset(target);
+		mFields.emplace_back(id, size());
+	}
+
+	Offset endTable() {
+		prep(4, 0);
+		push<int32_t>(0); // placeholder for the vtable offset
+		const Offset tableEnd = size();
+
+		uint16_t fieldCount = 0;
+		for (const auto& f : mFields)
+			fieldCount = std::max<uint16_t>(fieldCount, f.first + 1);
+		std::vector<uint16_t> fieldOffsets(fieldCount, 0);
+		for (const auto& f : mFields)
+			fieldOffsets[f.first] = static_cast<uint16_t>(tableEnd - f.second);
+
+		for (size_t i = fieldCount; i > 0; i--)
+			push<uint16_t>(fieldOffsets[i - 1]);
+		push<uint16_t>(static_cast<uint16_t>(tableEnd - mTableStart));
+		push<uint16_t>(static_cast<uint16_t>(4 + 2 * fieldCount));
+
+		patch<int32_t>(tableEnd, static_cast<int32_t>(size()) - static_cast<int32_t>(tableEnd));
+		return tableEnd;
+	}
+
+	std::string finish(Offset root) {
+		prep(mMinAlign, 4);
+		pushOffset(root);
+		return std::string(mReversed.rbegin(), mReversed.rend());
+	}
+
+private:
+	void prep(size_t alignment, size_t additionalBytes) {
+		mMinAlign = std::max(mMinAlign, alignment);
+		const size_t padding = (~(mReversed.size() + additionalBytes) + 1) & (alignment - 1);
+		mReversed.insert(mReversed.end(), padding, 0);
+	}
+
+	template <typename T>
+	void push(T v) {
+		pushBytes(&v, sizeof(T));
+	}
+
+	void pushBytes(const void* data, size_t count) {
+		const auto* bytes = static_cast<const char*>(data);
+		for (size_t i = count; i > 0; i--)
+			mReversed.push_back(bytes[i - 1]);
+	}
+
+	void pushOffset(Offset target) {
+		prep(4, 0);
+		push<uint32_t>(size() + 4 - target);
+	}
+
+	template <typename T>
+	void patch(Offset position, T v) {
+		char bytes[sizeof(T)];
+		std::memcpy(bytes, &v, sizeof(T));
+		for (size_t k = 0; k < sizeof(T); k++)
+			mReversed[position - 1 - k] = bytes[k];
+	}
+
+	std::vector<char> mReversed;
+	std::vector<std::pair<uint16_t, Offset>> mFields;
+	Offset mTableStart = 0;
+	size_t mMinAlign = 1;
+};
+
+// Arrow flatbuffer schema constants (Schema.fbs, Message.fbs, File.fbs)
+const int16_t METADATA_V5 = 4;
+const uint8_t HEADER_SCHEMA = 1;
+const uint8_t HEADER_RECORD_BATCH = 3;
+const uint8_t TYPE_INT = 2;
+const uint8_t TYPE_FLOATING_POINT = 3;
+const uint8_t TYPE_UTF8 = 5;
+const uint8_t TYPE_BOOL = 6;
+const uint8_t TYPE_LIST = 12;
+const int16_t PRECISION_DOUBLE = 2;
+
+const char ARROW_MAGIC[] = "ARROW1";
+const uint32_t CONTINUATION_MARKER = 0xFFFFFFFF;
+
+using ColumnType = pcu::ArrowWriter::ColumnType;
+using Column = pcu::ArrowWriter::Column;
+
+struct FieldNode {
+	int64_t length;
+	int64_t nullCount;
+};
+
+struct BufferSpec {
+	int64_t offset;
+	int64_t length;
+};
+
+size_t align8(size_t n) {
+	return (n + 7) & ~size_t(7);
+}
+
+std::string toUTF8(const std::wstring& s) {
+	std::string out;
+	out.reserve(s.size());
+	for (size_t i = 0; i < s.size(); i++) {
+		uint32_t cp = static_cast<uint32_t>(s[i]);
+		if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp <= 0xDBFF && i + 1 < s.size()) { // UTF-16 surrogate pair
+			const uint32_t low = static_cast<uint32_t>(s[i + 1]);
+			if (low >= 0xDC00 && low <= 0xDFFF) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+		if (cp < 0x80)
+			out += static_cast<char>(cp);
+		else if (cp < 0x800) {
+			out += static_cast<char>(0xC0 | (cp >> 6));
+			out += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000) {
+			out += static_cast<char>(0xE0 | (cp >> 12));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else {
+			out += static_cast<char>(0xF0 | (cp >> 18));
+			out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+	}
+	return out;
+}
+
+FlatBufferBuilder::Offset buildType(FlatBufferBuilder& fbb, ColumnType type, uint8_t& typeId) {
+	fbb.startTable();
+	switch (type) {
+		case ColumnType::UINT64:
+			typeId = TYPE_INT;
+			fbb.addScalar<int32_t>(0, 64);
+			fbb.addScalar<uint8_t>(1, 0);
+			break;
+		case ColumnType::FLOAT64:
+			typeId = TYPE_FLOATING_POINT;
+			fbb.addScalar<int16_t>(0, PRECISION_DOUBLE);
+			break;
+		case ColumnType::BOOL:
+			typeId = TYPE_BOOL;
+			break;
+		case ColumnType::UTF8:
+			typeId = TYPE_UTF8;
+			break;
+		case ColumnType::LIST_FLOAT64:
+		case ColumnType::LIST_UINT32:
+			typeId = TYPE_LIST;
+			break;
+	}
+	return fbb.endTable();
+}
+
+FlatBufferBuilder::Offset buildField(FlatBufferBuilder& fbb, const std::string& name, ColumnType type, bool nullable) {
+	std::vector<FlatBufferBuilder::Offset> children;
+	if (type == ColumnType::LIST_FLOAT64)
+		children.push_back(buildField(fbb, "item", ColumnType::FLOAT64, false));
+	else if (type == ColumnType::LIST_UINT32) {
+		// unsigned 32bit list items
+		const auto itemName = fbb.createString("item");
+		fbb.startTable();
+		fbb.addScalar<int32_t>(0, 32);
+		fbb.addScalar<uint8_t>(1, 0);
+		const auto itemType = fbb.endTable();
+		const auto itemChildren = fbb.createOffsetVector({});
+		fbb.startTable();
+		fbb.addOffset(0, itemName);
+		fbb.addScalar<uint8_t>(1, 0);
+		fbb.addScalar<uint8_t>(2, TYPE_INT);
+		fbb.addOffset(3, itemType);
+		fbb.addOffset(5, itemChildren);
+		children.push_back(fbb.endTable());
+	}
+
+	const auto nameOffset = fbb.createString(name);
+	uint8_t typeId = 0;
+	const auto typeOffset = buildType(fbb, type, typeId);
+	const auto childrenOffset = fbb.createOffsetVector(children);
+
+	fbb.startTable();
+	fbb.addOffset(0, nameOffset);
+	fbb.addScalar<uint8_t>(1, nullable ? 1 : 0);
+	fbb.addScalar<uint8_t>(2, typeId);
+	fbb.addOffset(3, typeOffset);
+	fbb.addOffset(5, childrenOffset);
+	return fbb.endTable();
+}
+
+FlatBufferBuilder::Offset buildSchema(FlatBufferBuilder& fbb, const std::vector<Column>& columns) {
+	std::vector<FlatBufferBuilder::Offset> fields;
+	fields.reserve(columns.size());
+	for (const Column& c : columns)
+		fields.push_back(buildField(fbb, c.name, c.type, c.nullable));
+	const auto fieldsOffset = fbb.createOffsetVector(fields);
+
+	fbb.startTable();
+	fbb.addScalar<int16_t>(0, 0); // little endian
+	fbb.addOffset(1, fieldsOffset);
+	return fbb.endTable();
+}
+
+std::string buildMessage(FlatBufferBuilder& fbb, uint8_t headerType, FlatBufferBuilder::Offset header,
+                         int64_t bodyLength) {
+	fbb.startTable();
+	fbb.addScalar<int64_t>(3, bodyLength);
+	fbb.addOffset(2, header);
+	fbb.addScalar<int16_t>(0, METADATA_V5);
+	fbb.addScalar<uint8_t>(1, headerType);
+	return fbb.finish(fbb.endTable());
+}
+
+/**
+ * collects the buffers of one record batch body, each buffer is padded to 8 bytes
+ */
+class BodyBuilder {
+public:
+	template <typename T>
+	void addBuffer(const std::vector<T>& data) {
+		addBuffer(data.data(), data.size() * sizeof(T));
+	}
+
+	void addBuffer(const void* data, size_t length) {
+		mBuffers.push_back({static_cast<int64_t>(mBody.size()), static_cast<int64_t>(length)});
+		mBody.append(static_cast<const char*>(data), length);
+		mBody.resize(align8(mBody.size()), 0);
+	}
+
+	void addEmptyBuffer() {
+		mBuffers.push_back({static_cast<int64_t>(mBody.size()), 0});
+	}
+
+	void addValidity(const std::vector<uint8_t>& validity, size_t nullCount) {
+		if (nullCount == 0)
+			addEmptyBuffer();
+		else
+			addBuffer(validity);
+	}
+
+	void addNode(size_t length, size_t nullCount) {
+		mNodes.push_back({static_cast<int64_t>(length), static_cast<int64_t>(nullCount)});
+	}
+
+	std::string mBody;
+	std::vector<FieldNode> mNodes;
+	std::vector<BufferSpec> mBuffers;
+};
+
+void setBit(std::vector<uint8_t>& bits, size_t i) {
+	bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+}
+
+// values and validity of a nullable report column within one batch
+struct ReportColumnData {
+	std::vector<double> floats;
+	std::vector<uint8_t> bools;
+	std::vector<std::string> strings;
+	std::vector<uint8_t> validity;
+	size_t validCount = 0;
+};
+
+template <typename T, typename F>
+void addListColumn(BodyBuilder& body, const pcu::ModelRecord* records, size_t count, F&& values) {
+	std::vector<int32_t> offsets(count + 1, 0);
+	for (size_t r = 0; r < count; r++) {
+		const size_t next = offsets[r] + values(records[r]).second;
+		if (next > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+			throw std::length_error("list column exceeds 32bit offsets, reduce the batch size.");
+		offsets[r + 1] = static_cast<int32_t>(next);
+	}
+
+	std::vector<T> items;
+	items.reserve(offsets[count]);
+	for (size_t r = 0; r < count; r++) {
+		const auto v = values(records[r]);
+		items.insert(items.end(), v.first, v.first + v.second);
+	}
+
+	body.addNode(count, 0);
+	body.addEmptyBuffer();
+	body.addBuffer(offsets);
+	body.addNode(items.size(), 0);
+	body.addEmptyBuffer();
+	body.addBuffer(items);
+}
+
+struct EncodedBatch {
+	std::string metadata;
+	std::string body;
+};
+
+EncodedBatch encodeBatch(const std::vector<Column>& columns, const pcu::ModelRecord* records, size_t count) {
+	// scatter the report values of all rows into the report columns
+	std::unordered_map<std::wstring, size_t> boolColumns, floatColumns, stringColumns;
+	for (size_t c = 0; c < columns.size(); c++) {
+		if (columns[c].reportKey.empty())
+			continue;
+		if (columns[c].type == ColumnType::BOOL)
+			boolColumns.emplace(columns[c].reportKey, c);
+		else if (columns[c].type == ColumnType::FLOAT64)
+			floatColumns.emplace(columns[c].reportKey, c);
+		else if (columns[c].type == ColumnType::UTF8)
+			stringColumns.emplace(columns[c].reportKey, c);
+	}
+
+	std::vector<ReportColumnData> reportData(columns.size());
+	for (size_t c = 0; c < columns.size(); c++) {
+		if (columns[c].reportKey.empty())
+			continue;
+		ReportColumnData& d = reportData[c];
+		d.validity.assign((count + 7) / 8, 0);
+		if (columns[c].type == ColumnType::BOOL)
+			d.bools.assign((count + 7) / 8, 0);
+		else if (columns[c].type == ColumnType::FLOAT64)
+			d.floats.assign(count, 0.0);
+		else
+			d.strings.resize(count);
+	}
+
+	auto markValid = [&](ReportColumnData& d, size_t r) {
+		if ((d.validity[r / 8] & (1u << (r % 8))) == 0) {
+			setBit(d.validity, r);
+			d.validCount++;
+		}
+	};
+
+	for (size_t r = 0; r < count; r++) {
+		const pcu::Reports* reports = records[r].reports;
+		if (reports == nullptr)
+			continue;
+		for (size_t i = 0; i < reports->boolKeys.size(); i++) {
+			const auto it = boolColumns.find(reports->boolKeys[i]);
+			if (it == boolColumns.end())
+				continue;
+			ReportColumnData& d = reportData[it->second];
+			markValid(d, r);
+			if (reports->boolValues[i])
+				setBit(d.bools, r);
+			else
+				d.bools[r / 8] &= static_cast<uint8_t>(~(1u << (r % 8)));
+		}
+		for (size_t i = 0; i < reports->floatKeys.size(); i++) {
+			const auto it = floatColumns.find(reports->floatKeys[i]);
+			if (it == floatColumns.end())
+				continue;
+			ReportColumnData& d = reportData[it->second];
+			markValid(d, r);
+			d.floats[r] = reports->floatValues[i];
+		}
+		for (size_t i = 0; i < reports->stringKeys.size(); i++) {
+			const auto it = stringColumns.find(reports->stringKeys[i]);
+			if (it == stringColumns.end())
+				continue;
+			ReportColumnData& d = reportData[it->second];
+			markValid(d, r);
+			d.strings[r] = toUTF8(reports->stringValues[i]);
+		}
+	}
+
+	std::vector<std::array<double, 6>> bounds(count);
+	for (size_t r = 0; r < count; r++) {
+		const pcu::MeshView& mesh = records[r].mesh;
+		if (mesh.getVertexCount() == 0)
+			bounds[r].fill(std::numeric_limits<double>::quiet_NaN());
+		else
+			pcu::computeBounds(mesh.vertices, mesh.getVertexCount(), bounds[r].data(), bounds[r].data() + 3);
+	}
+
+	BodyBuilder body;
+	size_t boundsColumn = 0;
+	for (size_t c = 0; c < columns.size(); c++) {
+		const Column& column = columns[c];
+
+		if (!column.reportKey.empty()) {
+			ReportColumnData& d = reportData[c];
+			const size_t nullCount = count - d.validCount;
+			body.addNode(count, nullCount);
+			body.addValidity(d.validity, nullCount);
+			if (column.type == ColumnType::BOOL)
+				body.addBuffer(d.bools);
+			else if (column.type == ColumnType::FLOAT64)
+				body.addBuffer(d.floats);
+			else {
+				std::vector<int32_t> offsets(count + 1, 0);
+				std::string data;
+				for (size_t r = 0; r < count; r++) {
+					data += d.strings[r];
+					offsets[r + 1] = static_cast<int32_t>(data.size());
+				}
+				body.addBuffer(offsets);
+				body.addBuffer(data.data(), data.size());
+			}
+			continue;
+		}
+
+		switch (column.type) {
+			case ColumnType::UINT64: {
+				std::vector<uint64_t> values(count);
+				if (column.name == "initial_shape_index")
+					for (size_t r = 0; r < count; r++)
+						values[r] = records[r].initialShapeIndex;
+				else if (column.name == "vertex_count")
+					for (size_t r = 0; r < count; r++)
+						values[r] = records[r].mesh.getVertexCount();
+				else if (column.name == "face_count")
+					for (size_t r = 0; r < count; r++)
+						values[r] = records[r].mesh.faceCount;
+				else
+					for (size_t r = 0; r < count; r++)
+						values[r] = records[r].mesh.indexCount;
+				body.addNode(count, 0);
+				body.addEmptyBuffer();
+				body.addBuffer(values);
+				break;
+			}
+			case ColumnType::FLOAT64: { // bounding box
+				std::vector<double> values(count);
+				for (size_t r = 0; r < count; r++)
+					values[r] = bounds[r][boundsColumn];
+				boundsColumn++;
+				body.addNode(count, 0);
+				body.addEmptyBuffer();
+				body.addBuffer(values);
+				break;
+			}
+			case ColumnType::LIST_FLOAT64:
+				addListColumn<double>(body, records, count, [](const pcu::ModelRecord& rec) {
+					return std::make_pair(rec.mesh.vertices, rec.mesh.vertexCoordCount);
+				});
+				break;
+			case ColumnType::LIST_UINT32:
+				if (column.name == "indices")
+					addListColumn<uint32_t>(body, records, count, [](const pcu::ModelRecord& rec) {
+						return std::make_pair(rec.mesh.indices, rec.mesh.indexCount);
+					});
+				else
+					addListColumn<uint32_t>(body, records, count, [](const pcu::ModelRecord& rec) {
+						return std::make_pair(rec.mesh.faceCounts, rec.mesh.faceCount);
+					});
+				break;
+			default:
+				throw std::logic_error("unexpected column type for column " + column.name);
+		}
+	}
+
+	FlatBufferBuilder fbb;
+	const auto nodes = fbb.createStructVector(body.mNodes.data(), sizeof(FieldNode), body.mNodes.size(), 8);
+	const auto buffers = fbb.createStructVector(body.mBuffers.data(), sizeof(BufferSpec), body.mBuffers.size(), 8);
+	fbb.startTable();
+	fbb.addScalar<int64_t>(0, static_cast<int64_t>(count));
+	fbb.addOffset(1, nodes);
+	fbb.addOffset(2, buffers);
+	const auto recordBatch = fbb.endTable();
+
+	EncodedBatch batch;
+	batch.metadata = buildMessage(fbb, HEADER_RECORD_BATCH, recordBatch, static_cast<int64_t>(body.mBody.size()));
+	batch.body = std::move(body.mBody);
+	return batch;
+}
+
+} // namespace
+
+namespace pcu {
+
+ArrowWriter::ArrowWriter(const std::string& path, const Options& options) : mPath(path), mOptions(options) {
+	mOut.open(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	if (!mOut)
+		throw std::runtime_error("could not open '" + path + "' for writing.");
+
+	const char header[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+	mOut.write(header, sizeof(header));
+	mPosition = sizeof(header);
+}
+
+ArrowWriter::~ArrowWriter() {
+	try {
+		close();
+	}
+	catch (...) {
+	}
+}
+
+void ArrowWriter::initSchema(const std::vector<ModelRecord>& records) {
+	mColumns = {{"initial_shape_index", ColumnType::UINT64, false, {}},
+	            {"vertex_count", ColumnType::UINT64, false, {}},
+	            {"face_count", ColumnType::UINT64, false, {}},
+	            {"index_count", ColumnType::UINT64, false, {}}};
+	for (const char* name : {"min_x", "min_y", "min_z", "max_x", "max_y", "max_z"})
+		mColumns.push_back({name, ColumnType::FLOAT64, false, {}});
+
+	// one column per distinct report key, in order of first appearance
+	std::unordered_map<std::string, ColumnType> seen;
+	auto addReportColumn = [&](const std::wstring& key, ColumnType type) {
+		std::string name = toUTF8(key);
+		const auto it = seen.find(name);
+		if (it != seen.end()) {
+			if (it->second == type)
+				return;
+			name += (type == ColumnType::BOOL) ? " (bool)" : (type == ColumnType::FLOAT64) ? " (float)" : " (string)";
+			if (seen.count(name) > 0)
+				return;
+		}
+		seen.emplace(name, type);
+		mColumns.push_back({name, type, true, key});
+	};
+	for (const ModelRecord& rec : records) {
+		if (rec.reports == nullptr)
+			continue;
+		for (const auto& key : rec.reports->boolKeys)
+			addReportColumn(key, ColumnType::BOOL);
+		for (const auto& key : rec.reports->floatKeys)
+			addReportColumn(key, ColumnType::FLOAT64);
+		for (const auto& key : rec.reports->stringKeys)
+			addReportColumn(key, ColumnType::UTF8);
+	}
+
+	if (mOptions.includeGeometry) {
+		mColumns.push_back({"vertices", ColumnType::LIST_FLOAT64, false, {}});
+		mColumns.push_back({"indices", ColumnType::LIST_UINT32, false, {}});
+		mColumns.push_back({"face_counts", ColumnType::LIST_UINT32, false, {}});
+	}
+
+	FlatBufferBuilder fbb;
+	const auto schema = buildSchema(fbb, mColumns);
+	writeMessage(buildMessage(fbb, HEADER_SCHEMA, schema, 0), {}, false);
+	mSchemaWritten = true;
+}
+
+void ArrowWriter::writeMessage(const std::string& metadata, const std::string& body, bool recordBlock) {
+	const size_t paddedLength = align8(metadata.size());
+	const int32_t metadataLength = static_cast<int32_t>(paddedLength);
+	const char padding[8] = {0};
+
+	if (recordBlock)
+		mBlocks.push_back({mPosition, metadataLength + 8, 0, static_cast<int64_t>(body.size())});
+
+	mOut.write(reinterpret_cast<const char*>(&CONTINUATION_MARKER), sizeof(CONTINUATION_MARKER));
+	mOut.write(reinterpret_cast<const char*>(&metadataLength), sizeof(metadataLength));
+	mOut.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+	mOut.write(padding, static_cast<std::streamsize>(paddedLength - metadata.size()));
+	mOut.write(body.data(), static_cast<std::streamsize>(body.size()));
+	if (!mOut)
+		throw std::runtime_error("failed to write '" + mPath + "'.");
+
+	mPosition += static_cast<int64_t>(8 + paddedLength + body.size());
+}
+
+void ArrowWriter::write(const std::vector<ModelRecord>& records) {
+	if (!mOut.is_open())
+		throw std::logic_error("the arrow writer for '" + mPath + "' is already closed.");
+
+	if (!mSchemaWritten)
+		initSchema(records);
+
+	const size_t batchSize = std::max<size_t>(1, mOptions.batchSize);
+	const size_t batchCount = (records.size() + batchSize - 1) / batchSize;
+	const size_t windowSize = getWorkerCount(batchCount);
+	std::vector<EncodedBatch> batches(windowSize);
+
+	for (size_t windowStart = 0; windowStart < batchCount; windowStart += windowSize) {
+		const size_t windowCount = std::min(windowSize, batchCount - windowStart);
+		parallelFor(windowCount, [&](size_t i) {
+			const size_t first = (windowStart + i) * batchSize;
+			const size_t count = std::min(batchSize, records.size() - first);
+			batches[i] = encodeBatch(mColumns, records.data() + first, count);
+		});
+		for (size_t i = 0; i < windowCount; i++) {
+			writeMessage(batches[i].metadata, batches[i].body, true);
+			batches[i] = EncodedBatch();
+		}
+	}
+
+	mRowCount += records.size();
+}
+
+void ArrowWriter::close() {
+	if (!mOut.is_open())
+		return;
+
+	if (!mSchemaWritten)
+		initSchema({});
+
+	const uint32_t endOfStream[2] = {CONTINUATION_MARKER, 0};
+	mOut.write(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream));
+
+	FlatBufferBuilder fbb;
+	const auto schema = buildSchema(fbb, mColumns);
+	const auto dictionaries = fbb.createStructVector(nullptr, sizeof(Block), 0, 8);
+	const auto recordBatches = fbb.createStructVector(mBlocks.data(), sizeof(Block), mBlocks.size(), 8);
+	fbb.startTable();
+	fbb.addOffset(1, schema);
+	fbb.addOffset(2, dictionaries);
+	fbb.addOffset(3, recordBatches);
+	fbb.addScalar<int16_t>(0, METADATA_V5);
+	const std::string footer = fbb.finish(fbb.endTable());
+
+	const int32_t footerLength = static_cast<int32_t>(footer.size());
+	mOut.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+	mOut.write(reinterpret_cast<const char*>(&footerLength), sizeof(footerLength));
+	mOut.write(ARROW_MAGIC, 6);
+	mOut.close();
+	if (!mOut)
+		throw std::runtime_error("failed to write '" + mPath + "'.");
+}
+
+} // namespace pcu
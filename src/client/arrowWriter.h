@@ -0,0 +1,103 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+#include "reports.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * one row of the exported table: the generated model of one initial shape
+ */
+struct ModelRecord {
+	size_t initialShapeIndex = 0;
+	MeshView mesh;
+	const Reports* reports = nullptr;
+};
+
+/**
+ * Writes generated models as Arrow IPC file (a.k.a. Feather V2), one row per model.
+ *
+ * Columns: initial_shape_index, vertex_count, face_count, index_count, bounding box (min_x ... max_z, NaN for empty
+ * models), one nullable column per CGA report key and optionally the geometry as list columns (vertices, indices,
+ * face_counts). The schema is fixed by the first write() call; report keys which only show up later are dropped.
+ *
+ * Each write() call appends its models as record batches of at most batchSize rows, the batches are encoded in
+ * parallel and streamed to the file in order. The file is only valid after close() has written the footer.
+ */
+class ArrowWriter {
+public:
+	struct Options {
+		bool includeGeometry = false;
+		size_t batchSize = 4096;
+	};
+
+	ArrowWriter(const std::string& path, const Options& options);
+	ArrowWriter(const ArrowWriter&) = delete;
+	ArrowWriter& operator=(const ArrowWriter&) = delete;
+	~ArrowWriter();
+
+	void write(const std::vector<ModelRecord>& records);
+	void close();
+
+	bool isOpen() const {
+		return mOut.is_open();
+	}
+	size_t getRowCount() const {
+		return mRowCount;
+	}
+
+	enum class ColumnType { UINT64, FLOAT64, BOOL, UTF8, LIST_FLOAT64, LIST_UINT32 };
+
+	struct Column {
+		std::string name;
+		ColumnType type;
+		bool nullable;
+		std::wstring reportKey; // empty for non-report columns
+	};
+
+	struct Block {
+		int64_t offset;
+		int32_t metaDataLength;
+		int32_t padding;
+		int64_t bodyLength;
+	};
+
+private:
+	void initSchema(const std::vector<ModelRecord>& records);
+	void writeMessage(const std::string& metadata, const std::string& body, bool recordBlock);
+
+	const std::string mPath;
+	const Options mOptions;
+	std::ofstream mOut;
+	int64_t mPosition = 0;
+	size_t mRowCount = 0;
+	bool mSchemaWritten = false;
+	std::vector<Column> mColumns;
+	std::vector<Block> mBlocks;
+};
+
+} // namespace pcu
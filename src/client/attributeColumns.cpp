@@ -0,0 +1,100 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "attributeColumns.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace pcu {
+
+size_t AttributeColumn::getInvalidCount() const {
+	return static_cast<size_t>(std::count(valid.begin(), valid.end(), 0));
+}
+
+std::vector<AttributeColumn> buildAttributeColumns(const std::vector<const AttributeValues*>& rows) {
+	const size_t rowCount = rows.size();
+	std::vector<AttributeColumn> columns;
+	std::unordered_map<std::wstring, size_t> columnIndices;
+
+	// array values are collected per row first as their offsets are only known once all rows are done
+	std::vector<std::vector<size_t>> arrayEntries; // per column: entry index per row (or max for none)
+
+	const size_t NONE = std::numeric_limits<size_t>::max();
+	for (size_t r = 0; r < rowCount; r++) {
+		if (rows[r] == nullptr)
+			continue;
+		const AttributeValues& values = *rows[r];
+		for (size_t e = 0; e < values.size(); e++) {
+			const auto inserted = columnIndices.emplace(values.keys[e], columns.size());
+			if (inserted.second) {
+				AttributeColumn column;
+				column.key = values.keys[e];
+				column.type = values.types[e];
+				column.valid.resize(rowCount, 0);
+				if (isString(column.type) && !isArray(column.type))
+					column.strings.resize(rowCount);
+				else if (!isArray(column.type))
+					column.floats.resize(rowCount, column.type == ValueType::FLOAT ? std::nan("") : 0.0);
+				arrayEntries.emplace_back(isArray(column.type) ? rowCount : 0, NONE);
+				columns.push_back(std::move(column));
+			}
+
+			const size_t c = inserted.first->second;
+			AttributeColumn& column = columns[c];
+			if (column.type != values.types[e])
+				continue;
+			column.valid[r] = 1;
+			if (isArray(column.type))
+				arrayEntries[c][r] = e;
+			else if (isString(column.type))
+				column.strings[r] = values.strings[values.offsets[e]];
+			else
+				column.floats[r] = values.floats[values.offsets[e]];
+		}
+	}
+
+	for (size_t c = 0; c < columns.size(); c++) {
+		AttributeColumn& column = columns[c];
+		if (!isArray(column.type))
+			continue;
+		column.offsets.assign(rowCount + 1, 0);
+		for (size_t r = 0; r < rowCount; r++) {
+			const size_t e = arrayEntries[c][r];
+			column.offsets[r + 1] = column.offsets[r];
+			if (e == NONE)
+				continue;
+			const AttributeValues& values = *rows[r];
+			const size_t begin = values.offsets[e];
+			const size_t count = values.counts[e];
+			if (isString(column.type))
+				column.strings.insert(column.strings.end(), values.strings.begin() + begin,
+				                      values.strings.begin() + begin + count);
+			else
+				column.floats.insert(column.floats.end(), values.floats.begin() + begin,
+				                     values.floats.begin() + begin + count);
+			column.offsets[r + 1] += count;
+		}
+	}
+	return columns;
+}
+
+} // namespace pcu
@@ -0,0 +1,135 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+enum class ValueType : uint8_t { BOOL, FLOAT, STRING, BOOL_ARRAY, FLOAT_ARRAY, STRING_ARRAY };
+
+inline bool isArray(ValueType type) {
+	return type == ValueType::BOOL_ARRAY || type == ValueType::FLOAT_ARRAY || type == ValueType::STRING_ARRAY;
+}
+
+inline bool isString(ValueType type) {
+	return type == ValueType::STRING || type == ValueType::STRING_ARRAY;
+}
+
+/**
+ * Evaluated attribute values of one initial shape in the order they were reported. Bools are stored as 0/1 in the
+ * float buffer, each value (or array) is a range of the float or string buffer.
+ */
+struct AttributeValues {
+	std::vector<std::wstring> keys;
+	std::vector<ValueType> types;
+	std::vector<size_t> offsets;
+	std::vector<size_t> counts;
+	std::vector<double> floats;
+	std::vector<std::wstring> strings;
+
+	size_t size() const {
+		return keys.size();
+	}
+
+	void addBool(const wchar_t* key, bool value) {
+		addFloats(key, ValueType::BOOL, &value, 1);
+	}
+	void addFloat(const wchar_t* key, double value) {
+		addFloats(key, ValueType::FLOAT, &value, 1);
+	}
+	void addString(const wchar_t* key, const wchar_t* value) {
+		addStrings(key, ValueType::STRING, &value, 1);
+	}
+	void addBoolArray(const wchar_t* key, const bool* values, size_t count) {
+		addFloats(key, ValueType::BOOL_ARRAY, values, count);
+	}
+	void addFloatArray(const wchar_t* key, const double* values, size_t count) {
+		addFloats(key, ValueType::FLOAT_ARRAY, values, count);
+	}
+	void addStringArray(const wchar_t* key, const wchar_t* const* values, size_t count) {
+		addStrings(key, ValueType::STRING_ARRAY, values, count);
+	}
+
+private:
+	template <typename T>
+	void addFloats(const wchar_t* key, ValueType type, const T* values, size_t count) {
+		add(key, type, floats.size(), count);
+		floats.insert(floats.end(), values, values + count);
+	}
+	void addStrings(const wchar_t* key, ValueType type, const wchar_t* const* values, size_t count) {
+		add(key, type, strings.size(), count);
+		strings.insert(strings.end(), values, values + count);
+	}
+	void add(const wchar_t* key, ValueType type, size_t offset, size_t count) {
+		keys.emplace_back(key);
+		types.push_back(type);
+		offsets.push_back(offset);
+		counts.push_back(count);
+	}
+};
+
+/**
+ * Attribute values of the leaf shapes of one initial shape as (shape ID, key index, value) tuples, stored as one set
+ * of columns per value type. Key indices refer to keys.
+ */
+struct LeafAttributes {
+	std::vector<std::wstring> keys;
+	std::vector<int32_t> boolShapeIds;
+	std::vector<uint32_t> boolKeyIndices;
+	std::vector<uint8_t> boolValues;
+	std::vector<int32_t> floatShapeIds;
+	std::vector<uint32_t> floatKeyIndices;
+	std::vector<double> floatValues;
+	std::vector<int32_t> stringShapeIds;
+	std::vector<uint32_t> stringKeyIndices;
+	std::vector<std::wstring> stringValues;
+
+	bool empty() const {
+		return boolValues.empty() && floatValues.empty() && stringValues.empty();
+	}
+};
+
+/**
+ * One attribute over all rows (initial shapes). Scalars have one entry per row in floats or strings, arrays are
+ * flattened with rows + 1 offsets. Rows without a value for the key (or with a value of another type) are marked
+ * invalid and hold NaN, false or an empty string/array.
+ */
+struct AttributeColumn {
+	std::wstring key;
+	ValueType type = ValueType::FLOAT;
+	std::vector<uint8_t> valid;
+	std::vector<double> floats;
+	std::vector<std::wstring> strings;
+	std::vector<size_t> offsets; // only for array types
+
+	size_t getInvalidCount() const;
+};
+
+/**
+ * Transposes the per shape values into columns, one per key in order of first appearance. The type of a column is
+ * the type of its first value. If a key is reported more than once for a row, the last value is kept.
+ */
+std::vector<AttributeColumn> buildAttributeColumns(const std::vector<const AttributeValues*>& rows);
+
+} // namespace pcu
@@ -0,0 +1,318 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "arrowWriter.h"
+#include "generator.h"
+#include "meshWriters.h"
+#include "objFootprints.h"
+#include "utils.h"
+#include "wellKnownGeometry.h"
+
+#include "prt/API.h"
+#include "prt/LogLevel.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * pyprt-batch: generates the initial shapes of an OBJ or WKT file with a rule package and writes the models, without
+ * Python. Attributes are given on the command line (for all shapes) and/or as CSV with one row per initial shape.
+ */
+
+namespace {
+
+const std::wstring ENCODER_ID_PYTHON = L"com.esri.pyprt.PyEncoder";
+
+const char* USAGE = R"(usage: pyprt-batch --rpk <rule package> (--obj <file> [--split-groups] | --wkt <file>)
+                   [--attr <key>=<value>]... [--attributes <csv file>]
+                   [--encoder <encoder id> [--encoder-option <key>=<value>]...]
+                   --output <file or directory> [--verbose]
+
+  --obj <file>             initial shapes from the faces of an OBJ file (one shape per object/group with --split-groups)
+  --wkt <file>             initial shapes from a text file with one WKT polygon per line
+  --attr <key>=<value>     shape attribute of all initial shapes, e.g. ruleFile, startRule, seed or rule attributes
+  --attributes <csv file>  shape attributes per initial shape: a header row with the keys, then one row per shape
+                           (values must not contain commas), precedes the values given with --attr
+  --encoder <encoder id>   file encoder writing into the --output directory, e.g. com.esri.prt.codecs.OBJEncoder
+  --output <path>          without --encoder: models as .obj, .ply, .stl or .arrow (reports) file
+)";
+
+struct Arguments {
+	std::string rulePackage;
+	std::string objPath;
+	bool splitGroups = false;
+	std::string wktPath;
+	std::vector<std::pair<std::string, std::string>> attributes;
+	std::string attributesPath;
+	std::string encoder;
+	std::vector<std::pair<std::string, std::string>> encoderOptions;
+	std::string output;
+	bool verbose = false;
+};
+
+bool splitKeyValue(const std::string& arg, std::vector<std::pair<std::string, std::string>>& pairs) {
+	const size_t p = arg.find('=');
+	if (p == 0 || p == std::string::npos)
+		return false;
+	pairs.emplace_back(arg.substr(0, p), arg.substr(p + 1));
+	return true;
+}
+
+pcu::RunStatus parseArguments(int argc, char* argv[], Arguments& args) {
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			std::cout << USAGE;
+			return pcu::RunStatus::DONE;
+		}
+		if (arg == "--split-groups") {
+			args.splitGroups = true;
+			continue;
+		}
+		if (arg == "--verbose") {
+			args.verbose = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cerr << "missing value for " << arg << std::endl;
+			return pcu::RunStatus::FAILED;
+		}
+		const std::string value = argv[++i];
+		if (arg == "--rpk")
+			args.rulePackage = value;
+		else if (arg == "--obj")
+			args.objPath = value;
+		else if (arg == "--wkt")
+			args.wktPath = value;
+		else if (arg == "--attributes")
+			args.attributesPath = value;
+		else if (arg == "--encoder")
+			args.encoder = value;
+		else if (arg == "--output")
+			args.output = value;
+		else if ((arg == "--attr" && splitKeyValue(value, args.attributes)) ||
+		         (arg == "--encoder-option" && splitKeyValue(value, args.encoderOptions)))
+			continue;
+		else {
+			std::cerr << "invalid argument " << arg << " " << value << std::endl;
+			return pcu::RunStatus::FAILED;
+		}
+	}
+
+	if (args.rulePackage.empty() || args.output.empty() || (args.objPath.empty() == args.wktPath.empty())) {
+		std::cerr << USAGE;
+		return pcu::RunStatus::FAILED;
+	}
+	return pcu::RunStatus::CONTINUE;
+}
+
+/**
+ * attribute values are typed like in Python: true/false are bools, numbers are floats (integers for the seed) and
+ * everything else is a string
+ */
+void setAttribute(prt::AttributeMapBuilder& builder, const std::string& key, const std::string& value) {
+	const std::wstring wKey = pcu::toUTF16FromUTF8(key);
+	if (value == "true" || value == "false") {
+		builder.setBool(wKey.c_str(), value == "true");
+		return;
+	}
+
+	char* end = nullptr;
+	const double number = std::strtod(value.c_str(), &end);
+	if (!value.empty() && end == value.c_str() + value.size()) {
+		if (key == "seed")
+			builder.setInt(wKey.c_str(), static_cast<int32_t>(number));
+		else
+			builder.setFloat(wKey.c_str(), number);
+	}
+	else
+		builder.setString(wKey.c_str(), pcu::toUTF16FromUTF8(value).c_str());
+}
+
+std::vector<std::string> splitCSVLine(const std::string& line) {
+	std::vector<std::string> fields;
+	std::istringstream in(line);
+	std::string field;
+	while (std::getline(in, field, ','))
+		fields.push_back(field);
+	if (!line.empty() && line.back() == ',')
+		fields.emplace_back();
+	return fields;
+}
+
+std::vector<std::string> readLines(const std::string& path) {
+	std::ifstream in(path);
+	if (!in)
+		throw std::runtime_error("cannot open " + path);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			lines.push_back(line);
+	}
+	return lines;
+}
+
+std::vector<pcu::AttributeMapPtr> createShapeAttributes(const Arguments& args, size_t shapeCount,
+                                                        const std::vector<size_t>& sourceIndices) {
+	const pcu::AttributeMapBuilderPtr builder{prt::AttributeMapBuilder::create()};
+	std::vector<pcu::AttributeMapPtr> shapeAttributes;
+	if (args.attributesPath.empty()) {
+		for (const auto& a : args.attributes)
+			setAttribute(*builder, a.first, a.second);
+		shapeAttributes.emplace_back(builder->createAttributeMap());
+		return shapeAttributes;
+	}
+
+	// rows refer to the shapes of the input file, also to the ones which could not be read
+	const std::vector<std::string> lines = readLines(args.attributesPath);
+	if (lines.empty())
+		throw std::runtime_error(args.attributesPath + " has no header row");
+	const std::vector<std::string> keys = splitCSVLine(lines[0]);
+	for (size_t s = 0; s < shapeCount; s++) {
+		const size_t row = sourceIndices[s] + 1;
+		if (row >= lines.size())
+			throw std::runtime_error(args.attributesPath + " has no row for initial shape " +
+			                         std::to_string(sourceIndices[s]));
+		const std::vector<std::string> values = splitCSVLine(lines[row]);
+		for (const auto& a : args.attributes)
+			setAttribute(*builder, a.first, a.second);
+		for (size_t k = 0; k < keys.size() && k < values.size(); k++) {
+			if (!values[k].empty())
+				setAttribute(*builder, keys[k], values[k]);
+		}
+		shapeAttributes.emplace_back(builder->createAttributeMapAndReset());
+	}
+	return shapeAttributes;
+}
+
+void writeModels(const std::string& path, const std::vector<GeneratedModel>& models) {
+	std::vector<pcu::MeshView> meshes;
+	std::vector<std::string> names;
+	std::vector<pcu::ModelRecord> records(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		meshes.push_back(models[i].getMeshView());
+		names.push_back("shape_" + std::to_string(models[i].getInitialShapeIndex()));
+		records[i].initialShapeIndex = models[i].getInitialShapeIndex();
+		records[i].mesh = meshes.back();
+		records[i].reports = &models[i].getReports();
+	}
+
+	const std::string extension = std::filesystem::path(path).extension().string();
+	if (extension == ".obj")
+		pcu::writeOBJ(path, meshes, names, 6);
+	else if (extension == ".ply")
+		pcu::writePLY(path, meshes);
+	else if (extension == ".stl")
+		pcu::writeSTL(path, meshes);
+	else if (extension == ".arrow") {
+		pcu::ArrowWriter::Options options;
+		options.includeGeometry = true;
+		pcu::ArrowWriter writer(path, options);
+		writer.write(records);
+		writer.close();
+	}
+	else
+		throw std::runtime_error("unknown output format " + extension + ", expected .obj, .ply, .stl or .arrow");
+}
+
+pcu::RunStatus run(const Arguments& args) {
+	std::vector<pcu::ParsedShape> parsedShapes;
+	if (!args.objPath.empty())
+		parsedShapes = pcu::parseOBJFile(args.objPath, args.splitGroups);
+	else
+		parsedShapes = pcu::parseWKT(readLines(args.wktPath));
+	const InitialShapeBatch batch(std::move(parsedShapes));
+	for (const auto& e : batch.getErrors())
+		std::cerr << "skipping initial shape " << e.first << ": " << e.second << std::endl;
+	if (batch.size() == 0) {
+		std::cerr << "no valid initial shapes" << std::endl;
+		return pcu::RunStatus::FAILED;
+	}
+
+	const std::vector<pcu::AttributeMapPtr> shapeAttributes =
+	        createShapeAttributes(args, batch.size(), batch.getSourceIndices());
+
+	Generator generator(batch);
+	if (!generator.isValid())
+		return pcu::RunStatus::FAILED;
+
+	if (!args.encoder.empty()) {
+		std::filesystem::create_directories(args.output);
+		const pcu::AttributeMapBuilderPtr builder{prt::AttributeMapBuilder::create()};
+		for (const auto& o : args.encoderOptions)
+			setAttribute(*builder, o.first, o.second);
+		builder->setString(L"outputPath", pcu::toUTF16FromOSNarrow(args.output).c_str());
+		const pcu::AttributeMapPtr encoderOptions{builder->createAttributeMap()};
+		prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+		generator.generateModel(shapeAttributes, args.rulePackage, pcu::toUTF16FromUTF8(args.encoder),
+		                        encoderOptions.get(), &status);
+		if (status != prt::STATUS_OK) {
+			std::cerr << "generating into " << args.output << " failed" << std::endl;
+			return pcu::RunStatus::FAILED;
+		}
+		std::cout << "generated " << batch.size() << " initial shapes into " << args.output << std::endl;
+		return pcu::RunStatus::DONE;
+	}
+
+	const pcu::AttributeMapBuilderPtr builder{prt::AttributeMapBuilder::create()};
+	const pcu::AttributeMapPtr encoderOptions{builder->createAttributeMap()};
+	prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+	const std::vector<GeneratedModel> models = generator.generateModel(
+	        shapeAttributes, args.rulePackage, ENCODER_ID_PYTHON, encoderOptions.get(), &status);
+	if (status != prt::STATUS_OK)
+		return pcu::RunStatus::FAILED;
+
+	writeModels(args.output, models);
+	std::cout << "wrote " << models.size() << " models to " << args.output << std::endl;
+	return pcu::RunStatus::DONE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	Arguments args;
+	const pcu::RunStatus status = parseArguments(argc, argv, args);
+	if (status != pcu::RunStatus::CONTINUE)
+		return static_cast<int>(status);
+
+	const pcu::ConsoleLogHandlerPtr logHandler{
+	        prt::ConsoleLogHandler::create(prt::LogHandler::ALL, prt::LogHandler::ALL_COUNT)};
+	const pcu::PRTContext prtCtx(args.verbose ? prt::LOG_INFO : prt::LOG_WARNING, logHandler.get());
+	if (!prtCtx) {
+		std::cerr << "failed to initialize PRT" << std::endl;
+		return static_cast<int>(pcu::RunStatus::FAILED);
+	}
+
+	try {
+		return static_cast<int>(run(args));
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return static_cast<int>(pcu::RunStatus::FAILED);
+	}
+}
@@ -0,0 +1,820 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "generator.h"
+#include "logging.h"
+#include "ruleInfo.h"
+#include "spatialContext.h"
+
+#include "prt/ContentType.h"
+#include "prt/prt.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <set>
+
+/**
+ * commonly used constants
+ */
+const wchar_t* FILE_CGA_REPORT = L"CGAReport.txt";
+const wchar_t* ENCODER_OPT_NAME = L"name";
+
+const std::wstring ENCODER_ID_CGA_REPORT = L"com.esri.prt.core.CGAReportEncoder";
+const std::wstring ENCODER_ID_CGA_PRINT = L"com.esri.prt.core.CGAPrintEncoder";
+const std::wstring ENCODER_ID_PYTHON = L"com.esri.pyprt.PyEncoder";
+const std::wstring ENCODER_ID_ATTR_EVAL = L"com.esri.prt.core.AttributeEvalEncoder";
+
+const std::wstring CONTEXT_ATTR_NEAREST_NEIGHBOR_DISTANCE = L"nearestNeighborDistance";
+const std::wstring CONTEXT_ATTR_NEIGHBOR_COUNT = L"neighborCount";
+const std::wstring CONTEXT_ATTR_STREET_FRONTAGE = L"streetFrontage";
+
+namespace pcu {
+
+PRTContext::PRTContext(prt::LogLevel minimalLogLevel, prt::LogHandler* logHandler) : mLogHandler(logHandler) {
+	if (mLogHandler)
+		prt::addLogHandler(mLogHandler);
+
+	// setup path for PRT extension libraries
+	const std::filesystem::path moduleRoot = getModuleDirectory().parent_path();
+	const auto prtExtensionPath = moduleRoot / "lib";
+
+	// initialize PRT with the path to its extension libraries, the default log
+	// level
+	const std::wstring wExtPath = prtExtensionPath.wstring();
+	const std::array<const wchar_t*, 1> extPaths = {wExtPath.c_str()};
+	mPRTHandle.reset(prt::init(extPaths.data(), extPaths.size(), minimalLogLevel));
+}
+
+PRTContext::~PRTContext() {
+	// shutdown PRT
+	mPRTHandle.reset();
+
+	// remove loggers
+	if (mLogHandler)
+		prt::removeLogHandler(mLogHandler);
+}
+
+} // namespace pcu
+
+InitialShape::InitialShape(const std::vector<double>& vert) : mVertices(vert), mPathFlag(false) {
+	mIndices.resize(vert.size() / 3);
+	std::iota(std::begin(mIndices), std::end(mIndices), 0);
+	mFaceCounts.resize(1, (uint32_t)mIndices.size());
+}
+
+InitialShape::InitialShape(const std::vector<double>& vert, const std::vector<uint32_t>& ind,
+                           const std::vector<uint32_t>& faceCnt)
+    : mVertices(vert), mIndices(ind), mFaceCounts(faceCnt), mPathFlag(false) {}
+
+InitialShape::InitialShape(const std::string& initShapePath) : mPath(initShapePath), mPathFlag(true) {}
+
+pcu::MeshView InitialShape::getMeshView() const {
+	pcu::MeshView view;
+	if (!mPathFlag) {
+		view.vertices = mVertices.data();
+		view.vertexCoordCount = mVertices.size();
+		view.indices = mIndices.data();
+		view.indexCount = mIndices.size();
+		view.faceCounts = mFaceCounts.data();
+		view.faceCount = mFaceCounts.size();
+	}
+	return view;
+}
+
+InitialShape::InitialShape(pcu::ShapeGeometry&& geometry)
+    : mVertices(std::move(geometry.vertices)), mIndices(std::move(geometry.indices)),
+      mFaceCounts(std::move(geometry.faceCounts)), mPathFlag(false) {}
+
+InitialShapeBatch::InitialShapeBatch(std::vector<pcu::ParsedShape>&& shapes) {
+	mShapes.reserve(shapes.size());
+	for (size_t i = 0; i < shapes.size(); i++) {
+		mDroppedHoles += shapes[i].droppedHoles;
+		if (shapes[i].error.empty()) {
+			mShapes.emplace_back(std::move(shapes[i].geometry));
+			mSourceIndices.push_back(i);
+			mNames.push_back(std::move(shapes[i].name));
+		}
+		else
+			mErrors.emplace_back(i, std::move(shapes[i].error));
+	}
+}
+
+GeneratedModel::GeneratedModel(const size_t& initShapeIdx, const std::vector<double>& vert,
+                               const pcu::VertexComponents& vertexComponents, const std::vector<uint32_t>& indices,
+                               const std::vector<uint32_t>& face, const std::vector<uint8_t>& faceClasses,
+                               const std::array<double, FACE_CLASS_COUNT>& faceClassAreas, const pcu::Reports& rep,
+                               const std::array<double, 3>& offset, const pcu::LeafAttributes& leafAttributes)
+    : mInitialShapeIndex(initShapeIdx), mVertices(vert), mVertexComponents(vertexComponents), mIndices(indices),
+      mFaces(face), mFaceClasses(faceClasses), mFaceClassAreas(faceClassAreas), mReports(rep), mOffset(offset),
+      mLeafAttributes(leafAttributes) {}
+
+const std::vector<double>& GeneratedModel::getVertices() const {
+	if (mVertices.empty() && !mVertexComponents[0].empty()) {
+		const size_t vertexCount = mVertexComponents[0].size();
+		mVertices.resize(3 * vertexCount);
+		pcu::interleaveVertices(mVertexComponents[0].data(), mVertexComponents[1].data(),
+		                        mVertexComponents[2].data(), vertexCount, mVertices.data());
+	}
+	return mVertices;
+}
+
+const pcu::VertexComponents& GeneratedModel::getVertexComponents() const {
+	if (mVertexComponents[0].empty() && !mVertices.empty()) {
+		const size_t vertexCount = mVertices.size() / 3;
+		for (auto& c : mVertexComponents)
+			c.resize(vertexCount);
+		pcu::deinterleaveVertices(mVertices.data(), vertexCount, mVertexComponents[0].data(),
+		                          mVertexComponents[1].data(), mVertexComponents[2].data());
+	}
+	return mVertexComponents;
+}
+
+const std::vector<uint32_t>& GeneratedModel::getFaceOffsets() const {
+	if (mFaceOffsets.size() != mFaces.size() + 1) {
+		mFaceOffsets.resize(mFaces.size() + 1);
+		pcu::computeFaceOffsets(mFaces.data(), mFaces.size(), mFaceOffsets.data());
+	}
+	return mFaceOffsets;
+}
+
+pcu::MeshView GeneratedModel::getMeshView() const {
+	pcu::MeshView view = getTopologyView();
+	view.vertices = getVertices().data();
+	return view;
+}
+
+pcu::MeshView GeneratedModel::getTopologyView() const {
+	pcu::MeshView view;
+	view.vertexCoordCount = 3 * getVertexCount();
+	view.indices = mIndices.data();
+	view.indexCount = mIndices.size();
+	view.faceCounts = mFaces.data();
+	view.faceCount = mFaces.size();
+	return view;
+}
+
+namespace {
+
+void extractMainShapeAttributes(const prt::AttributeMap* shapeAttr, std::wstring& ruleFile, std::wstring& startRule,
+                                int32_t& seed, std::wstring& shapeName) {
+	if (shapeAttr) {
+		if (shapeAttr->hasKey(L"ruleFile") && shapeAttr->getType(L"ruleFile") == prt::AttributeMap::PT_STRING)
+			ruleFile = shapeAttr->getString(L"ruleFile");
+		if (shapeAttr->hasKey(L"startRule") && shapeAttr->getType(L"startRule") == prt::AttributeMap::PT_STRING)
+			startRule = shapeAttr->getString(L"startRule");
+		if (shapeAttr->hasKey(L"seed") && shapeAttr->getType(L"seed") == prt::AttributeMap::PT_INT)
+			seed = shapeAttr->getInt(L"seed");
+		if (shapeAttr->hasKey(L"shapeName") && shapeAttr->getType(L"shapeName") == prt::AttributeMap::PT_STRING)
+			shapeName = shapeAttr->getString(L"shapeName");
+	}
+}
+
+bool getBoolOption(const prt::AttributeMap* options, const wchar_t* key, bool defaultValue) {
+	if (options && options->hasKey(key) && options->getType(key) == prt::AttributeMap::PT_BOOL)
+		return options->getBool(key);
+	return defaultValue;
+}
+
+double getFloatOption(const prt::AttributeMap* options, const wchar_t* key, double defaultValue) {
+	if (options && options->hasKey(key)) {
+		if (options->getType(key) == prt::AttributeMap::PT_FLOAT)
+			return options->getFloat(key);
+		if (options->getType(key) == prt::AttributeMap::PT_INT)
+			return options->getInt(key);
+	}
+	return defaultValue;
+}
+
+// row-major 3x4 or 4x4 matrix given as float or int list
+bool getTransformOption(const prt::AttributeMap* options, const wchar_t* key, std::array<double, 12>& matrix) {
+	if (!options || !options->hasKey(key))
+		return false;
+
+	std::vector<double> values;
+	size_t count = 0;
+	if (options->getType(key) == prt::AttributeMap::PT_FLOAT_ARRAY) {
+		const double* v = options->getFloatArray(key, &count);
+		values.assign(v, v + count);
+	}
+	else if (options->getType(key) == prt::AttributeMap::PT_INT_ARRAY) {
+		const int32_t* v = options->getIntArray(key, &count);
+		values.assign(v, v + count);
+	}
+
+	if (values.size() != 12 && values.size() != 16) {
+		LOG_ERR << "ignoring transform: expected a row-major 3x4 or 4x4 matrix (12 or 16 values)";
+		return false;
+	}
+	std::copy_n(values.begin(), 12, matrix.begin());
+	return true;
+}
+
+pcu::PreparationOptions getPreparationOptions(const prt::AttributeMap* optionMap) {
+	pcu::PreparationOptions options;
+	options.repair = getBoolOption(optionMap, L"repair", options.repair);
+	options.validate = getBoolOption(optionMap, L"validate", options.validate) || options.repair;
+	options.tolerance = getFloatOption(optionMap, L"tolerance", options.tolerance);
+	options.simplifyTolerance = getFloatOption(optionMap, L"simplifyTolerance", options.simplifyTolerance);
+	options.hasTransform = getTransformOption(optionMap, L"transform", options.transform);
+
+	if (optionMap && optionMap->hasKey(L"recenter") &&
+	    optionMap->getType(L"recenter") == prt::AttributeMap::PT_STRING) {
+		const std::wstring recenter = optionMap->getString(L"recenter");
+		if (recenter == L"batch")
+			options.recenter = pcu::Recentering::BATCH;
+		else if (recenter == L"shape")
+			options.recenter = pcu::Recentering::SHAPE;
+		else if (recenter != L"none")
+			LOG_ERR << "unknown recenter mode, expected 'none', 'batch' or 'shape'";
+	}
+	return options;
+}
+
+pcu::SpatialContextOptions getSpatialContextOptions(const prt::AttributeMap* optionMap) {
+	pcu::SpatialContextOptions options;
+	if (!optionMap || !optionMap->hasKey(L"contextAttributes"))
+		return options;
+
+	size_t count = 0;
+	const wchar_t* const* names = nullptr;
+	if (optionMap->getType(L"contextAttributes") == prt::AttributeMap::PT_STRING_ARRAY)
+		names = optionMap->getStringArray(L"contextAttributes", &count);
+	for (size_t i = 0; i < count; i++) {
+		const std::wstring name = names[i];
+		if (name == CONTEXT_ATTR_NEAREST_NEIGHBOR_DISTANCE)
+			options.nearestNeighborDistance = true;
+		else if (name == CONTEXT_ATTR_NEIGHBOR_COUNT)
+			options.neighborCount = true;
+		else if (name == CONTEXT_ATTR_STREET_FRONTAGE)
+			options.streetFrontage = true;
+		else
+			LOG_ERR << "ignoring unknown context attribute " << pcu::toOSNarrowFromUTF16(name);
+	}
+	options.neighborRadius = getFloatOption(optionMap, L"neighborRadius", options.neighborRadius);
+	options.streetTolerance = getFloatOption(optionMap, L"streetTolerance", options.streetTolerance);
+	return options;
+}
+
+} // namespace
+
+Generator::Generator(const std::vector<InitialShape>& myGeo, const prt::AttributeMap* optionMap) {
+	mInitialShapesBuilders.resize(myGeo.size());
+
+	mCache = (pcu::CachePtr)prt::CacheObject::create(prt::CacheObject::CACHE_TYPE_DEFAULT);
+
+	const pcu::PreparationOptions options = getPreparationOptions(optionMap);
+	const pcu::SpatialContextOptions contextOptions = getSpatialContextOptions(optionMap);
+
+	std::vector<pcu::MeshView> shapeViews;
+	if (options.isEnabled() || contextOptions.isEnabled()) {
+		shapeViews.reserve(myGeo.size());
+		for (const auto& shape : myGeo)
+			shapeViews.push_back(shape.getMeshView());
+	}
+
+	// Native validation/repair, simplification and transformation of the initial shape geometry
+	pcu::PreparedShapes prepared;
+	if (options.isEnabled())
+		prepared = pcu::prepareShapes(shapeViews, options);
+
+	// Neighborhood metrics on the final geometry, recentering offsets are added back to keep the true distances
+	if (contextOptions.isEnabled()) {
+		for (size_t ind = 0; ind < shapeViews.size(); ind++) {
+			if (prepared.isModified(ind))
+				shapeViews[ind] = prepared.geometries[ind].getMeshView();
+		}
+		const double* offsets = prepared.offsets.empty() ? nullptr : prepared.offsets.data();
+
+		pcu::SpatialContext context = pcu::computeSpatialContext(shapeViews, offsets, contextOptions);
+
+		std::wstring prefix = L"Default$";
+		if (optionMap->hasKey(L"contextAttributePrefix") &&
+		    optionMap->getType(L"contextAttributePrefix") == prt::AttributeMap::PT_STRING)
+			prefix = optionMap->getString(L"contextAttributePrefix");
+		if (contextOptions.nearestNeighborDistance)
+			mContextAttributes.emplace_back(prefix + CONTEXT_ATTR_NEAREST_NEIGHBOR_DISTANCE,
+			                                std::move(context.nearestNeighborDistance));
+		if (contextOptions.neighborCount)
+			mContextAttributes.emplace_back(prefix + CONTEXT_ATTR_NEIGHBOR_COUNT, std::move(context.neighborCount));
+		if (contextOptions.streetFrontage)
+			mContextAttributes.emplace_back(prefix + CONTEXT_ATTR_STREET_FRONTAGE, std::move(context.streetFrontage));
+	}
+	mShapeDiagnostics = std::move(prepared.diagnostics);
+	mShapeDiagnostics.resize(myGeo.size());
+	mPreparationStats = prepared.stats;
+	mShapeOffsets = std::move(prepared.offsets);
+	if (options.simplifyTolerance > 0.0)
+		LOG_INF << "simplification reduced " << mPreparationStats.inputVertexCount << " face vertices to "
+		        << mPreparationStats.outputVertexCount;
+
+	size_t invalidShapes = 0;
+	for (const auto& d : mShapeDiagnostics)
+		invalidShapes += (d.checked && !d.isValid()) ? 1 : 0;
+	if (invalidShapes > 0)
+		LOG_WRN << invalidShapes << " of " << myGeo.size() << " initial shapes have unresolved geometry issues";
+
+	// Initial shapes initializing
+	for (size_t ind = 0; ind < myGeo.size(); ind++) {
+
+		pcu::InitialShapeBuilderPtr isb{prt::InitialShapeBuilder::create()};
+
+		if (myGeo[ind].getPathFlag()) {
+			if (!pcu::toFileURI(myGeo[ind].getPath()).empty()) {
+				LOG_DBG << "trying to read initial shape geometry from " << pcu::toFileURI(myGeo[ind].getPath())
+				        << std::endl;
+				const prt::Status s =
+				        isb->resolveGeometry(pcu::toUTF16FromOSNarrow(pcu::toFileURI(myGeo[ind].getPath())).c_str(),
+				                             nullptr, mCache.get());
+				if (s != prt::STATUS_OK) {
+					LOG_ERR << "could not resolve geometry from " << pcu::toFileURI(myGeo[ind].getPath());
+					mValid = false;
+				}
+			}
+			else {
+				LOG_ERR << "could not read initial shape geometry, unvalid path";
+				mValid = false;
+			}
+		}
+		else if (prepared.isModified(ind)) {
+			const pcu::ShapeGeometry& g = prepared.geometries[ind];
+			if (isb->setGeometry(g.vertices.data(), g.vertices.size(), g.indices.data(), g.indices.size(),
+			                     g.faceCounts.data(), g.faceCounts.size()) != prt::STATUS_OK) {
+
+				LOG_ERR << "invalid initial geometry";
+				mValid = false;
+			}
+		}
+		else {
+			if (isb->setGeometry(myGeo[ind].getVertices(), myGeo[ind].getVertexCount(), myGeo[ind].getIndices(),
+			                     myGeo[ind].getIndexCount(), myGeo[ind].getFaceCounts(),
+			                     myGeo[ind].getFaceCountsCount()) != prt::STATUS_OK) {
+
+				LOG_ERR << "invalid initial geometry";
+				mValid = false;
+			}
+		}
+
+		if (mValid)
+			mInitialShapesBuilders[ind] = std::move(isb);
+	}
+}
+
+Generator::Generator(const InitialShapeBatch& batch, const prt::AttributeMap* preparationOptions)
+    : Generator(batch.getShapes(), preparationOptions) {}
+
+void Generator::setAndCreateInitialShape(const pcu::RulePackageVersion* rulePackage,
+                                         const std::vector<pcu::AttributeMapPtr>& shapesAttr,
+                                         std::vector<const prt::InitialShape*>& initShapes,
+                                         std::vector<pcu::InitialShapePtr>& initShapePtrs,
+                                         std::vector<pcu::AttributeMapPtr>& convertedShapeAttr) {
+	const prt::ResolveMap* resolveMap = rulePackage ? rulePackage->resolveMap.get() : nullptr;
+	pcu::RuleInfoPtr ruleInfo;
+	std::wstring ruleInfoFile; // rule file of the last lookup, also if it failed
+	std::set<std::wstring> mismatches;
+	for (size_t ind = 0; ind < mInitialShapesBuilders.size(); ind++) {
+		// the given attributes are only copied if they have to be converted or extended
+		const prt::AttributeMap* shapeAttr = (shapesAttr.size() > ind) ? shapesAttr[ind].get() : shapesAttr[0].get();
+
+		std::wstring ruleF = mRuleFile;
+		std::wstring startR = mStartRule;
+		int32_t randomS = mSeed;
+		std::wstring shapeN = mShapeName;
+		extractMainShapeAttributes(shapeAttr, ruleF, startR, randomS, shapeN);
+
+		// convert the values to the attribute types declared by the rule (e.g. python ints for float attributes)
+		if (resolveMap && ruleInfoFile != ruleF) {
+			ruleInfo = pcu::getRuleInfoCache().get(rulePackage->path, ruleF, resolveMap, mCache.get());
+			ruleInfoFile = ruleF;
+		}
+		if (ruleInfo && shapeAttr) {
+			std::vector<std::wstring> shapeMismatches;
+			convertedShapeAttr[ind] = pcu::coerceAttributeTypes(*shapeAttr, *ruleInfo, shapeMismatches);
+			shapeAttr = convertedShapeAttr[ind].get();
+			mismatches.insert(shapeMismatches.begin(), shapeMismatches.end());
+		}
+		if (!mContextAttributes.empty() || !mCategoricalAttributes.empty())
+			addColumnAttributes(ind, shapeAttr, convertedShapeAttr[ind]);
+
+		mInitialShapesBuilders[ind]->setAttributes(ruleF.c_str(), startR.c_str(), randomS, shapeN.c_str(), shapeAttr,
+		                                           resolveMap);
+
+		initShapePtrs[ind].reset(mInitialShapesBuilders[ind]->createInitialShape());
+		initShapes[ind] = initShapePtrs[ind].get();
+	}
+
+	for (const std::wstring& key : mismatches)
+		LOG_WRN << "value of attribute " << key << " does not match the type declared by the rule";
+}
+
+// explicitly passed shape attributes take precedence over the computed and categorical ones, shapes without a value
+// are skipped
+void Generator::addColumnAttributes(size_t initialShapeIndex, const prt::AttributeMap*& shapeAttr,
+                                    pcu::AttributeMapPtr& ownedShapeAttr) const {
+	const pcu::AttributeMapBuilderPtr builder{shapeAttr ? prt::AttributeMapBuilder::createFromAttributeMap(shapeAttr)
+	                                                    : prt::AttributeMapBuilder::create()};
+	for (const auto& attribute : mContextAttributes) {
+		const double value = attribute.second[initialShapeIndex];
+		if (std::isfinite(value) && !(shapeAttr && shapeAttr->hasKey(attribute.first.c_str())))
+			builder->setFloat(attribute.first.c_str(), value);
+	}
+	for (const auto& attribute : mCategoricalAttributes) {
+		const int32_t code = attribute.codes[initialShapeIndex];
+		if (code >= 0 && !(shapeAttr && shapeAttr->hasKey(attribute.key.c_str())))
+			builder->setString(attribute.key.c_str(), attribute.categories[code].c_str());
+	}
+	ownedShapeAttr.reset(builder->createAttributeMap());
+	shapeAttr = ownedShapeAttr.get();
+}
+
+bool Generator::setCategoricalAttributes(std::vector<CategoricalAttribute>&& attributes) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (const auto& attribute : attributes) {
+		if (attribute.codes.size() != mInitialShapesBuilders.size()) {
+			LOG_ERR << "categorical attribute " << attribute.key << " has " << attribute.codes.size()
+			        << " codes for " << mInitialShapesBuilders.size() << " initial shapes";
+			return false;
+		}
+		const int32_t categoryCount = static_cast<int32_t>(attribute.categories.size());
+		if (std::any_of(attribute.codes.begin(), attribute.codes.end(),
+		                [categoryCount](int32_t c) { return c < -1 || c >= categoryCount; })) {
+			LOG_ERR << "categorical attribute " << attribute.key << " has codes outside of its " << categoryCount
+			        << " categories";
+			return false;
+		}
+	}
+	mCategoricalAttributes = std::move(attributes);
+	return true;
+}
+
+void Generator::initializeEncoderData(const std::wstring& encName, const prt::AttributeMap* encOpt) {
+	mEncodersNames.clear();
+	mEncodersOptionsPtr.clear();
+	mOutputPath.clear();
+
+	mEncodersNames.push_back(encName);
+	mEncodersOptionsPtr.push_back(pcu::createValidatedOptions(encName.c_str(), encOpt));
+
+	if (encName != ENCODER_ID_PYTHON) {
+		if (encOpt && encOpt->hasKey(L"outputPath") && encOpt->getType(L"outputPath") == prt::AttributeMap::PT_STRING)
+			mOutputPath = pcu::toOSNarrowFromUTF16(encOpt->getString(L"outputPath"));
+
+		mEncodersNames.push_back(ENCODER_ID_CGA_REPORT);
+		mEncodersNames.push_back(ENCODER_ID_CGA_PRINT);
+
+		const pcu::AttributeMapBuilderPtr optionsBuilder{prt::AttributeMapBuilder::create()};
+		optionsBuilder->setString(ENCODER_OPT_NAME, FILE_CGA_REPORT);
+		const pcu::AttributeMapPtr reportOptions{optionsBuilder->createAttributeMapAndReset()};
+		const pcu::AttributeMapPtr printOptions{optionsBuilder->createAttributeMapAndReset()};
+
+		mEncodersOptionsPtr.push_back(pcu::createValidatedOptions(ENCODER_ID_CGA_REPORT, reportOptions.get()));
+		mEncodersOptionsPtr.push_back(pcu::createValidatedOptions(ENCODER_ID_CGA_PRINT, printOptions.get()));
+	}
+}
+
+void Generator::getRawEncoderDataPointers(std::vector<const wchar_t*>& allEnc,
+                                          std::vector<const prt::AttributeMap*>& allEncOpt) {
+	if (mEncodersNames[0] == ENCODER_ID_PYTHON) {
+		allEnc.clear();
+		allEncOpt.clear();
+
+		allEnc.push_back(mEncodersNames[0].c_str());
+		allEncOpt.push_back(mEncodersOptionsPtr[0].get());
+	}
+	else {
+		allEnc.clear();
+		allEnc.push_back(mEncodersNames[0].c_str());
+		allEnc.push_back(mEncodersNames[1].c_str()); // an encoder to redirect CGA report to CGAReport.txt
+		allEnc.push_back(mEncodersNames[2].c_str()); // redirects CGA print output to the callback
+
+		allEncOpt.clear();
+		allEncOpt.push_back(mEncodersOptionsPtr[0].get());
+		allEncOpt.push_back(mEncodersOptionsPtr[1].get());
+		allEncOpt.push_back(mEncodersOptionsPtr[2].get());
+	}
+}
+
+std::vector<GeneratedModel> Generator::generateModel(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+                                                     const std::string& rulePackagePath,
+                                                     const std::wstring& geometryEncoderName,
+                                                     const prt::AttributeMap* geometryEncoderOptions,
+                                                     prt::Status* status) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return generate(shapeAttributes, rulePackagePath, geometryEncoderName, geometryEncoderOptions, status);
+}
+
+std::vector<GeneratedModel> Generator::generate(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+                                                const std::string& rulePackagePath,
+                                                const std::wstring& geometryEncoderName,
+                                                const prt::AttributeMap* geometryEncoderOptions, prt::Status* status) {
+	if (status != nullptr)
+		*status = prt::STATUS_UNSPECIFIED_ERROR;
+
+	if (!mValid) {
+		LOG_ERR << "invalid ModelGenerator instance.";
+		return {};
+	}
+
+	if (!checkShapeAttributes(shapeAttributes))
+		return {};
+
+	if (geometryEncoderName.empty() && mEncodersNames.empty()) {
+		LOG_ERR << "generate model with a geometry encoder";
+		return {};
+	}
+
+	std::vector<GeneratedModel> newGeneratedGeo;
+	newGeneratedGeo.reserve(mInitialShapesBuilders.size());
+
+	try {
+		// Resolve Map
+		if (!rulePackagePath.empty()) {
+			if (!loadRulePackage(rulePackagePath))
+				return {};
+		}
+		else if (mWatchRulePackage && mRulePackage)
+			refreshRulePackage(false);
+
+		// Initial shapes
+		std::vector<const prt::InitialShape*> initialShapes(mInitialShapesBuilders.size());
+		std::vector<pcu::InitialShapePtr> initialShapePtrs(mInitialShapesBuilders.size());
+		std::vector<pcu::AttributeMapPtr> convertedShapeAttrVec(mInitialShapesBuilders.size());
+		setAndCreateInitialShape(mRulePackage.get(), shapeAttributes, initialShapes, initialShapePtrs,
+		                         convertedShapeAttrVec);
+
+		// Encoder info, encoder options
+		if (!geometryEncoderName.empty())
+			initializeEncoderData(geometryEncoderName, geometryEncoderOptions);
+
+		std::vector<const wchar_t*> encoders;
+		encoders.reserve(3);
+		std::vector<const prt::AttributeMap*> encodersOptions;
+		encodersOptions.reserve(3);
+
+		getRawEncoderDataPointers(encoders, encodersOptions);
+
+		if (mEncodersNames[0] == ENCODER_ID_PYTHON) {
+
+			pcu::PyCallbacksPtr foc{
+			        std::make_unique<PyCallbacks>(mInitialShapesBuilders.size(), mShapeOffsets, mMessageHandler)};
+
+			// Generate
+			const prt::Status genStat =
+			        prt::generate(initialShapes.data(), initialShapes.size(), nullptr, encoders.data(), encoders.size(),
+			                      encodersOptions.data(), foc.get(), mCache.get(), nullptr);
+
+			if (status != nullptr)
+				*status = genStat;
+			if (genStat != prt::STATUS_OK) {
+				LOG_ERR << "prt::generate() failed with status: '" << prt::getStatusDescription(genStat) << "' ("
+				        << genStat << ")";
+				return {};
+			}
+
+			// offsets are either added back by the encoder or stored on the models
+			const prt::AttributeMap* pyEncoderOptions = mEncodersOptionsPtr[0].get();
+			const bool offsetsRestored = pyEncoderOptions->hasKey(L"restoreOffsets") &&
+			                             pyEncoderOptions->getBool(L"restoreOffsets");
+
+			for (size_t idx = 0; idx < mInitialShapesBuilders.size(); idx++) {
+				std::array<double, 3> offset = {0.0, 0.0, 0.0};
+				if (!offsetsRestored && !mShapeOffsets.empty())
+					std::copy_n(mShapeOffsets.begin() + 3 * idx, 3, offset.begin());
+
+				newGeneratedGeo.emplace_back(idx, foc->getVertices(idx), foc->getVertexComponents(idx),
+				                             foc->getIndices(idx), foc->getFaces(idx), foc->getFaceClasses(idx),
+				                             foc->getFaceClassAreas(idx), foc->getReport(idx), offset,
+				                             foc->getLeafAttributes(idx));
+			}
+		}
+		else {
+			const std::filesystem::path outputPath = mOutputPath;
+			LOG_DBG << "got outputPath = " << outputPath;
+
+			pcu::FileOutputCallbacksPtr foc;
+			if (std::filesystem::is_directory(outputPath) && std::filesystem::exists(outputPath)) {
+				foc.reset(prt::FileOutputCallbacks::create(outputPath.wstring().c_str()));
+			}
+			else {
+				LOG_ERR << "The directory specified by 'outputPath' is not valid or does not exist: " << outputPath
+				        << std::endl;
+				return {};
+			}
+
+			// Generate
+			const prt::Status genStat =
+			        prt::generate(initialShapes.data(), initialShapes.size(), nullptr, encoders.data(), encoders.size(),
+			                      encodersOptions.data(), foc.get(), mCache.get(), nullptr);
+
+			if (status != nullptr)
+				*status = genStat;
+			if (genStat != prt::STATUS_OK) {
+				LOG_ERR << "prt::generate() failed with status: '" << prt::getStatusDescription(genStat) << "' ("
+				        << genStat << ")";
+				return {};
+			}
+
+			return {};
+		}
+	}
+	catch (const std::exception& e) {
+		if (status != nullptr)
+			*status = prt::STATUS_UNSPECIFIED_ERROR;
+		LOG_ERR << "caught exception: " << e.what();
+		return {};
+	}
+	catch (...) {
+		if (status != nullptr)
+			*status = prt::STATUS_UNSPECIFIED_ERROR;
+		LOG_ERR << "caught unknown exception.";
+		return {};
+	}
+
+	return newGeneratedGeo;
+}
+
+bool Generator::checkShapeAttributes(const std::vector<pcu::AttributeMapPtr>& shapeAttributes) const {
+	if ((shapeAttributes.size() != 1) &&
+	    (shapeAttributes.size() <
+	     mInitialShapesBuilders.size())) { // if one shape attribute dictionary, same apply to all initial shapes.
+		LOG_ERR << "not enough shape attributes dictionaries defined.";
+		return false;
+	}
+	else if (shapeAttributes.size() > mInitialShapesBuilders.size()) {
+		LOG_WRN << "number of shape attributes dictionaries defined greater than number of initial shapes given."
+		        << std::endl;
+	}
+	return true;
+}
+
+bool Generator::loadRulePackage(const std::string& rulePackagePath) {
+	// the loaded rule package is kept as long as its content does not change
+	if (mRulePackage && mRulePackage->path == rulePackagePath) {
+		refreshRulePackage(false);
+		return true;
+	}
+
+	LOG_INF << "using rule package " << rulePackagePath << std::endl;
+
+	prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+	pcu::RulePackageVersionPtr rulePackage;
+	try {
+		rulePackage = pcu::loadRulePackageVersion(rulePackagePath, &status);
+	}
+	catch (std::exception& e) {
+		LOG_ERR << "caught exception: " << e.what();
+	}
+
+	if (rulePackage && (status == prt::STATUS_OK)) {
+		LOG_DBG << "resolve map = " << pcu::objectToXML(rulePackage->resolveMap.get()) << std::endl;
+		mRulePackage = std::move(rulePackage);
+		return true;
+	}
+	else {
+		LOG_ERR << "getting resolve map from '" << rulePackagePath << "' failed, aborting.";
+		return false;
+	}
+}
+
+std::vector<pcu::AttributeColumn>
+Generator::evaluateAttributes(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+                              const std::string& rulePackagePath) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mValid) {
+		LOG_ERR << "invalid ModelGenerator instance.";
+		return {};
+	}
+
+	if (!checkShapeAttributes(shapeAttributes))
+		return {};
+
+	try {
+		if (!rulePackagePath.empty()) {
+			if (!loadRulePackage(rulePackagePath))
+				return {};
+		}
+		else if (mWatchRulePackage && mRulePackage)
+			refreshRulePackage(false);
+		const pcu::RulePackageVersionPtr rulePackage = mRulePackage;
+		if (!rulePackage) {
+			LOG_ERR << "evaluate attributes with a rule package path";
+			return {};
+		}
+
+		std::vector<const prt::InitialShape*> initialShapes(mInitialShapesBuilders.size());
+		std::vector<pcu::InitialShapePtr> initialShapePtrs(mInitialShapesBuilders.size());
+		std::vector<pcu::AttributeMapPtr> convertedShapeAttrVec(mInitialShapesBuilders.size());
+		setAndCreateInitialShape(rulePackage.get(), shapeAttributes, initialShapes, initialShapePtrs,
+		                         convertedShapeAttrVec);
+
+		// the attribute evaluation encoder reports the evaluated rule attributes of each initial shape without
+		// generating any geometry
+		const pcu::AttributeMapBuilderPtr optionsBuilder{prt::AttributeMapBuilder::create()};
+		const pcu::AttributeMapPtr evalOptions{optionsBuilder->createAttributeMap()};
+		const pcu::AttributeMapPtr validatedOptions =
+		        pcu::createValidatedOptions(ENCODER_ID_ATTR_EVAL, evalOptions.get());
+		const wchar_t* encoders[] = {ENCODER_ID_ATTR_EVAL.c_str()};
+		const prt::AttributeMap* encodersOptions[] = {validatedOptions.get()};
+
+		const pcu::PyCallbacksPtr foc{
+		        std::make_unique<PyCallbacks>(mInitialShapesBuilders.size(), std::vector<double>(), mMessageHandler)};
+		const prt::Status genStat = prt::generate(initialShapes.data(), initialShapes.size(), nullptr, encoders, 1,
+		                                          encodersOptions, foc.get(), mCache.get(), nullptr);
+		if (genStat != prt::STATUS_OK) {
+			LOG_ERR << "prt::generate() failed with status: '" << prt::getStatusDescription(genStat) << "' ("
+			        << genStat << ")";
+			return {};
+		}
+
+		std::vector<const pcu::AttributeValues*> rows(mInitialShapesBuilders.size());
+		for (size_t idx = 0; idx < rows.size(); idx++)
+			rows[idx] = &foc->getAttributes(idx);
+
+		return pcu::buildAttributeColumns(rows);
+	}
+	catch (const std::exception& e) {
+		LOG_ERR << "caught exception: " << e.what();
+		return {};
+	}
+	catch (...) {
+		LOG_ERR << "caught unknown exception.";
+		return {};
+	}
+}
+
+bool Generator::prefetchAssets(const std::string& rulePackagePath, pcu::AssetPrefetchStats& stats) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!rulePackagePath.empty() && !loadRulePackage(rulePackagePath))
+		return false;
+	const pcu::RulePackageVersionPtr rulePackage = mRulePackage;
+	if (!rulePackage) {
+		LOG_ERR << "prefetch assets with a rule package path";
+		return false;
+	}
+
+	stats = pcu::prefetchAssets(*rulePackage->resolveMap, *mCache);
+	for (const auto& e : stats.errors)
+		LOG_WRN << "asset error: " << e.first << ": " << e.second;
+	return true;
+}
+
+bool Generator::reloadRulePackage(bool force) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return refreshRulePackage(force);
+}
+
+bool Generator::refreshRulePackage(bool force) {
+	if (!mRulePackage) {
+		LOG_ERR << "no rule package has been loaded yet";
+		return false;
+	}
+	if (!force && !pcu::isRulePackageModified(*mRulePackage))
+		return false;
+
+	const std::string& path = mRulePackage->path;
+	prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+	pcu::RulePackageVersionPtr rulePackage = pcu::loadRulePackageVersion(path, &status);
+	if (!rulePackage || status != prt::STATUS_OK) {
+		LOG_ERR << "reloading rule package " << path << " failed, keeping the loaded version";
+		return false;
+	}
+
+	// only the entries of the old version are dropped, no generation uses it while the mutex is held
+	pcu::flushCacheEntries(*mCache, *mRulePackage->resolveMap);
+	pcu::getRuleInfoCache().invalidate(path);
+	LOG_INF << "reloaded rule package " << path << " (content hash " << mRulePackage->contentHash << " -> "
+	        << rulePackage->contentHash << ")";
+	mRulePackage = std::move(rulePackage);
+	return true;
+}
+
+std::vector<GeneratedModel> Generator::generateAnotherModel(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+                                                            prt::Status* status) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mRulePackage) {
+		if (status != nullptr)
+			*status = prt::STATUS_UNSPECIFIED_ERROR;
+		LOG_ERR << "generate model with all required parameters";
+		return {};
+	}
+	else
+		return generate(shapeAttributes, "", L"", nullptr, status);
+}
+
@@ -0,0 +1,329 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "PyCallbacks.h"
+#include "attributeColumns.h"
+#include "meshUtils.h"
+#include "reports.h"
+#include "rulePackage.h"
+#include "shapePreparation.h"
+#include "utils.h"
+
+#include "prt/API.h"
+#include "prt/LogHandler.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Native generation API of pyprt (no Python dependency), used by the Python bindings and the batch command line tool.
+ */
+
+namespace pcu {
+
+/**
+ * Helper struct to manage PRT lifetime (e.g. the prt::init() call), the log handler is registered while PRT is
+ * initialized and must outlive the context
+ */
+struct PRTContext {
+	PRTContext(prt::LogLevel minimalLogLevel, prt::LogHandler* logHandler = nullptr);
+	~PRTContext();
+
+	explicit operator bool() const {
+		return (bool)mPRTHandle;
+	}
+
+	prt::LogHandler* mLogHandler;
+	ObjectPtr mPRTHandle;
+};
+
+} // namespace pcu
+
+class InitialShape {
+public:
+	InitialShape(const std::vector<double>& vert);
+	InitialShape(const std::vector<double>& vert, const std::vector<uint32_t>& ind,
+	             const std::vector<uint32_t>& faceCnt);
+	InitialShape(const std::string& path);
+	InitialShape(pcu::ShapeGeometry&& geometry);
+	~InitialShape() {}
+
+	const double* getVertices() const {
+		return mVertices.data();
+	}
+	size_t getVertexCount() const {
+		return mVertices.size();
+	}
+	const uint32_t* getIndices() const {
+		return mIndices.data();
+	}
+	size_t getIndexCount() const {
+		return mIndices.size();
+	}
+	const uint32_t* getFaceCounts() const {
+		return mFaceCounts.data();
+	}
+	size_t getFaceCountsCount() const {
+		return mFaceCounts.size();
+	}
+	const std::string& getPath() const {
+		return mPath;
+	}
+	bool getPathFlag() const {
+		return mPathFlag;
+	}
+
+	// empty view for path based shapes
+	pcu::MeshView getMeshView() const;
+
+protected:
+	std::vector<double> mVertices;
+	std::vector<uint32_t> mIndices;
+	std::vector<uint32_t> mFaceCounts;
+	std::string mPath;
+	bool mPathFlag;
+};
+
+/**
+ * initial shapes created natively in bulk (e.g. from WKB/WKT or OBJ objects), only valid geometries are included
+ */
+class InitialShapeBatch {
+public:
+	InitialShapeBatch(std::vector<pcu::ParsedShape>&& shapes);
+
+	const std::vector<InitialShape>& getShapes() const {
+		return mShapes;
+	}
+	size_t size() const {
+		return mShapes.size();
+	}
+	// index into the parsed input sequence for each initial shape
+	const std::vector<size_t>& getSourceIndices() const {
+		return mSourceIndices;
+	}
+	// source object name for each initial shape (empty if the input format has no names)
+	const std::vector<std::string>& getNames() const {
+		return mNames;
+	}
+	// input index and reason of the geometries which were skipped
+	const std::vector<std::pair<size_t, std::string>>& getErrors() const {
+		return mErrors;
+	}
+	size_t getDroppedHoleCount() const {
+		return mDroppedHoles;
+	}
+
+private:
+	std::vector<InitialShape> mShapes;
+	std::vector<size_t> mSourceIndices;
+	std::vector<std::string> mNames;
+	std::vector<std::pair<size_t, std::string>> mErrors;
+	size_t mDroppedHoles = 0;
+};
+
+class GeneratedModel {
+public:
+	GeneratedModel(const size_t& initialShapeIdx, const std::vector<double>& vert,
+	               const pcu::VertexComponents& vertexComponents, const std::vector<uint32_t>& indices,
+	               const std::vector<uint32_t>& face, const std::vector<uint8_t>& faceClasses,
+	               const std::array<double, FACE_CLASS_COUNT>& faceClassAreas, const pcu::Reports& rep,
+	               const std::array<double, 3>& offset, const pcu::LeafAttributes& leafAttributes);
+	GeneratedModel() {}
+	~GeneratedModel() {}
+
+	size_t getInitialShapeIndex() const {
+		return mInitialShapeIndex;
+	}
+	// the vertices are stored in the layout they were encoded with, the other layout is computed on first access
+	// the lazy getters (vertices, vertex components, face offsets and mesh view) are not thread-safe, in the
+	// Python module call them with the GIL held and only hand the results to code running without it
+	const std::vector<double>& getVertices() const;
+	const pcu::VertexComponents& getVertexComponents() const;
+	size_t getVertexCount() const {
+		return mVertices.empty() ? mVertexComponents[0].size() : mVertices.size() / 3;
+	}
+	const std::vector<uint32_t>& getIndices() const {
+		return mIndices;
+	}
+	const std::vector<uint32_t>& getFaces() const {
+		return mFaces;
+	}
+	// FaceClass per face and total area per class, empty and zero without the faceClasses encoder option
+	const std::vector<uint8_t>& getFaceClasses() const {
+		return mFaceClasses;
+	}
+	const std::array<double, FACE_CLASS_COUNT>& getFaceClassAreas() const {
+		return mFaceClassAreas;
+	}
+	const pcu::Reports& getReports() const {
+		return mReports;
+	}
+	const pcu::LeafAttributes& getLeafAttributes() const {
+		return mLeafAttributes;
+	}
+	// add to the vertices to get back to the input coordinates (non-zero if recentered and not restored)
+	const std::array<double, 3>& getOffset() const {
+		return mOffset;
+	}
+
+	// start of each face in the index buffer (faces + 1 entries), computed on first access
+	const std::vector<uint32_t>& getFaceOffsets() const;
+
+	pcu::MeshView getMeshView() const;
+
+	// view onto indices and faces only (no vertices), e.g. for merging the vertex components
+	pcu::MeshView getTopologyView() const;
+
+private:
+	size_t mInitialShapeIndex;
+	mutable std::vector<double> mVertices;
+	mutable pcu::VertexComponents mVertexComponents;
+	std::vector<uint32_t> mIndices;
+	std::vector<uint32_t> mFaces;
+	mutable std::vector<uint32_t> mFaceOffsets;
+	std::vector<uint8_t> mFaceClasses;
+	std::array<double, FACE_CLASS_COUNT> mFaceClassAreas = {0.0, 0.0, 0.0};
+	pcu::Reports mReports;
+	std::array<double, 3> mOffset = {0.0, 0.0, 0.0};
+	pcu::LeafAttributes mLeafAttributes;
+};
+
+// string attribute given as one code per initial shape into a table of distinct values, -1 for no value
+struct CategoricalAttribute {
+	std::wstring key;
+	std::vector<int32_t> codes;
+	std::vector<std::wstring> categories;
+};
+
+/**
+ * Prepares the initial shapes once and generates them with changing rule packages, attributes and encoders. Errors
+ * are logged and reported as empty results. PRT must be initialized while generating. The public calls are serialized
+ * by a mutex, so one generator can be shared between threads.
+ */
+class Generator {
+public:
+	Generator(const std::vector<InitialShape>& myGeo, const prt::AttributeMap* preparationOptions = nullptr);
+	Generator(const InitialShapeBatch& batch, const prt::AttributeMap* preparationOptions = nullptr);
+	~Generator() {}
+
+	/**
+	 * One attribute map per initial shape or a single one for all of them. The keys ruleFile, startRule, seed and
+	 * shapeName select the rule. An empty rule package path reuses the loaded rule package and an empty encoder name
+	 * the encoder of the previous call. Other encoders than the Python encoder write files into the directory given by
+	 * their outputPath option and return no models, status tells whether the generation succeeded.
+	 */
+	std::vector<GeneratedModel> generateModel(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+	                                          const std::string& rulePackagePath,
+	                                          const std::wstring& geometryEncoderName,
+	                                          const prt::AttributeMap* geometryEncoderOptions,
+	                                          prt::Status* status = nullptr);
+	std::vector<GeneratedModel> generateAnotherModel(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+	                                                 prt::Status* status = nullptr);
+
+	// evaluated rule attributes per initial shape as columns (no geometry is generated)
+	std::vector<pcu::AttributeColumn> evaluateAttributes(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+	                                                     const std::string& rulePackagePath);
+
+	// resolves the assets of the rule package into the cache before generating, false if there is no rule package
+	bool prefetchAssets(const std::string& rulePackagePath, pcu::AssetPrefetchStats& stats);
+
+	// loads the current content of the rule package if it changed (or always if forced), true if a new version is used
+	// (waits for a running generation, which finishes with the version it started with)
+	bool reloadRulePackage(bool force);
+	// check for a changed rule package before each generation which reuses the loaded one
+	void watchRulePackage(bool enabled) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mWatchRulePackage = enabled;
+	}
+
+	// string attributes given as codes per initial shape, applied to all following generations
+	bool setCategoricalAttributes(std::vector<CategoricalAttribute>&& attributes);
+
+	// receives the messages of the generate callbacks (errors and CGA print output), the default writes to std::wcout
+	void setMessageHandler(PyCallbacks::MessageHandler handler) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mMessageHandler = std::move(handler);
+	}
+
+	bool isValid() const {
+		return mValid;
+	}
+	size_t getInitialShapeCount() const {
+		return mInitialShapesBuilders.size();
+	}
+	const std::vector<pcu::ShapeDiagnostics>& getShapeDiagnostics() const {
+		return mShapeDiagnostics;
+	}
+	// face vertex counts before and after the preparation stages
+	const pcu::PreparationStats& getPreparationStats() const {
+		return mPreparationStats;
+	}
+	// computed neighborhood metrics as (attribute name, value per shape), NaN for shapes without geometry
+	const std::vector<std::pair<std::wstring, std::vector<double>>>& getContextAttributes() const {
+		return mContextAttributes;
+	}
+
+private:
+	std::mutex mMutex; // held by the public calls which use or change the state below
+	pcu::RulePackageVersionPtr mRulePackage; // replaced on reload, never while a generation is running
+	pcu::CachePtr mCache;
+	bool mWatchRulePackage = false;
+
+	std::vector<pcu::AttributeMapPtr> mEncodersOptionsPtr;
+	std::vector<std::wstring> mEncodersNames;
+	std::string mOutputPath; // of file based encoders
+	std::vector<pcu::InitialShapeBuilderPtr> mInitialShapesBuilders;
+	std::vector<pcu::ShapeDiagnostics> mShapeDiagnostics;
+	pcu::PreparationStats mPreparationStats;
+	std::vector<double> mShapeOffsets; // recentering offset, 3 per initial shape or empty
+	std::vector<std::pair<std::wstring, std::vector<double>>> mContextAttributes; // name, value per shape
+	std::vector<CategoricalAttribute> mCategoricalAttributes;
+	PyCallbacks::MessageHandler mMessageHandler;
+
+	std::wstring mRuleFile = L"bin/rule.cgb";
+	std::wstring mStartRule = L"default$init";
+	int32_t mSeed = 666;
+	std::wstring mShapeName = L"InitialShape";
+
+	bool mValid = true;
+
+	bool checkShapeAttributes(const std::vector<pcu::AttributeMapPtr>& shapeAttributes) const;
+	bool loadRulePackage(const std::string& rulePackagePath);
+	// the private parts of generateModel and reloadRulePackage, called with the mutex held
+	std::vector<GeneratedModel> generate(const std::vector<pcu::AttributeMapPtr>& shapeAttributes,
+	                                     const std::string& rulePackagePath, const std::wstring& geometryEncoderName,
+	                                     const prt::AttributeMap* geometryEncoderOptions, prt::Status* status);
+	bool refreshRulePackage(bool force);
+	void setAndCreateInitialShape(const pcu::RulePackageVersion* rulePackage,
+	                              const std::vector<pcu::AttributeMapPtr>& shapeAttr,
+	                              std::vector<const prt::InitialShape*>& initShapes,
+	                              std::vector<pcu::InitialShapePtr>& initShapesPtrs,
+	                              std::vector<pcu::AttributeMapPtr>& convertShapeAttr);
+	void addColumnAttributes(size_t initialShapeIndex, const prt::AttributeMap*& shapeAttr,
+	                         pcu::AttributeMapPtr& ownedShapeAttr) const;
+	void initializeEncoderData(const std::wstring& encName, const prt::AttributeMap* encOpt);
+	void getRawEncoderDataPointers(std::vector<const wchar_t*>& allEnc,
+	                               std::vector<const prt::AttributeMap*>& allEncOpt);
+};
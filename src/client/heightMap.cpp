@@ -0,0 +1,161 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "heightMap.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const size_t TILE_SIZE = 256; // cells per tile side
+
+struct Bounds2D {
+	double minX = std::numeric_limits<double>::max();
+	double maxX = std::numeric_limits<double>::lowest();
+	double minZ = std::numeric_limits<double>::max();
+	double maxZ = std::numeric_limits<double>::lowest();
+};
+
+Bounds2D getBounds(const pcu::MeshView& mesh) {
+	Bounds2D b;
+	for (size_t v = 0; v < mesh.getVertexCount(); v++) {
+		const double* p = mesh.vertices + 3 * v;
+		b.minX = std::min(b.minX, p[0]);
+		b.maxX = std::max(b.maxX, p[0]);
+		b.minZ = std::min(b.minZ, p[2]);
+		b.maxZ = std::max(b.maxZ, p[2]);
+	}
+	return b;
+}
+
+// cells [first, last) of the range [begin, end) whose centers are inside [lo, hi], false if there are none
+bool getCellRange(double lo, double hi, double origin, double cellSize, size_t begin, size_t end, size_t& first,
+                  size_t& last) {
+	const double f = std::max(std::ceil((lo - origin) / cellSize - 0.5), static_cast<double>(begin));
+	const double l = std::min(std::floor((hi - origin) / cellSize - 0.5) + 1.0, static_cast<double>(end));
+	if (!(f < l))
+		return false;
+	first = static_cast<size_t>(f);
+	last = static_cast<size_t>(l);
+	return true;
+}
+
+/**
+ * Rasterizes the triangles of the mesh faces (see triangulateFace, concave roofs do not cover the cells outside of
+ * them) into the cells [rowBegin, rowEnd) x [columnBegin, columnEnd), faces parallel to y (walls) cover no cell center
+ * and are skipped.
+ */
+void rasterizeMesh(const pcu::MeshView& mesh, int32_t id, const pcu::HeightMapSpec& spec, size_t rowBegin,
+                   size_t rowEnd, size_t columnBegin, size_t columnEnd, float* heights, int32_t* ids) {
+	const double s = spec.cellSize;
+	std::vector<uint32_t> triangles;
+	size_t corner = 0;
+	for (size_t f = 0; f < mesh.faceCount; f++) {
+		const uint32_t count = mesh.faceCounts[f];
+		triangles.clear();
+		pcu::triangulateFace(mesh.vertices, mesh.indices + corner, count, triangles);
+		corner += count;
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			const double* a = mesh.vertices + 3 * triangles[i];
+			const double* b = mesh.vertices + 3 * triangles[i + 1];
+			const double* c = mesh.vertices + 3 * triangles[i + 2];
+			double area2 = (b[0] - a[0]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[0] - a[0]);
+			if (area2 == 0.0)
+				continue;
+			if (area2 < 0.0) {
+				std::swap(b, c);
+				area2 = -area2;
+			}
+
+			size_t c0, c1, r0, r1;
+			if (!getCellRange(std::min({a[0], b[0], c[0]}), std::max({a[0], b[0], c[0]}), spec.origin[0], s,
+			                  columnBegin, columnEnd, c0, c1) ||
+			    !getCellRange(std::min({a[2], b[2], c[2]}), std::max({a[2], b[2], c[2]}), spec.origin[1], s, rowBegin,
+			                  rowEnd, r0, r1))
+				continue;
+
+			for (size_t r = r0; r < r1; r++) {
+				const double pz = spec.origin[1] + (r + 0.5) * s;
+				for (size_t col = c0; col < c1; col++) {
+					const double px = spec.origin[0] + (col + 0.5) * s;
+					// edge functions, points on the edges count as inside (the maximum does not mind duplicates)
+					const double wa = (c[0] - b[0]) * (pz - b[2]) - (c[2] - b[2]) * (px - b[0]);
+					const double wb = (a[0] - c[0]) * (pz - c[2]) - (a[2] - c[2]) * (px - c[0]);
+					const double wc = (b[0] - a[0]) * (pz - a[2]) - (b[2] - a[2]) * (px - a[0]);
+					if (wa < 0.0 || wb < 0.0 || wc < 0.0)
+						continue;
+					const float y = static_cast<float>((wa * a[1] + wb * b[1] + wc * c[1]) / area2);
+					float& height = heights[r * spec.columns + col];
+					if (std::isnan(height) || y > height) {
+						height = y;
+						if (ids != nullptr)
+							ids[r * spec.columns + col] = id;
+					}
+				}
+			}
+		}
+	}
+}
+
+} // namespace
+
+namespace pcu {
+
+void rasterizeHeightMap(const std::vector<MeshView>& meshes, const std::vector<int32_t>& meshIds,
+                        const HeightMapSpec& spec, float* heights, int32_t* ids) {
+	if (!(spec.cellSize > 0.0))
+		throw std::invalid_argument("cell size must be positive.");
+
+	std::vector<Bounds2D> bounds(meshes.size());
+	parallelFor(meshes.size(), [&](size_t m) { bounds[m] = getBounds(meshes[m]); });
+
+	const size_t tileRows = (spec.rows + TILE_SIZE - 1) / TILE_SIZE;
+	const size_t tileColumns = (spec.columns + TILE_SIZE - 1) / TILE_SIZE;
+	parallelFor(tileRows * tileColumns, [&](size_t t) {
+		const size_t rowBegin = (t / tileColumns) * TILE_SIZE;
+		const size_t rowEnd = std::min(rowBegin + TILE_SIZE, spec.rows);
+		const size_t columnBegin = (t % tileColumns) * TILE_SIZE;
+		const size_t columnEnd = std::min(columnBegin + TILE_SIZE, spec.columns);
+
+		for (size_t r = rowBegin; r < rowEnd; r++) {
+			std::fill(heights + r * spec.columns + columnBegin, heights + r * spec.columns + columnEnd,
+			          std::numeric_limits<float>::quiet_NaN());
+			if (ids != nullptr)
+				std::fill(ids + r * spec.columns + columnBegin, ids + r * spec.columns + columnEnd, -1);
+		}
+
+		// extent of the cell centers of the tile
+		const double minX = spec.origin[0] + (columnBegin + 0.5) * spec.cellSize;
+		const double maxX = spec.origin[0] + (columnEnd - 0.5) * spec.cellSize;
+		const double minZ = spec.origin[1] + (rowBegin + 0.5) * spec.cellSize;
+		const double maxZ = spec.origin[1] + (rowEnd - 0.5) * spec.cellSize;
+		for (size_t m = 0; m < meshes.size(); m++) {
+			const Bounds2D& b = bounds[m];
+			if (b.maxX < minX || b.minX > maxX || b.maxZ < minZ || b.minZ > maxZ)
+				continue;
+			rasterizeMesh(meshes[m], meshIds[m], spec, rowBegin, rowEnd, columnBegin, columnEnd, heights, ids);
+		}
+	});
+}
+
+} // namespace pcu
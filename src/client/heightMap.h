@@ -0,0 +1,51 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Horizontal raster in the xz plane (y is up). Cell (row r, column c) has its center at
+ * (origin[0] + (c + 0.5) * cellSize, origin[1] + (r + 0.5) * cellSize), rows run along z.
+ */
+struct HeightMapSpec {
+	std::array<double, 2> origin = {0.0, 0.0}; // x and z of the grid corner
+	double cellSize = 1.0;
+	size_t rows = 0;
+	size_t columns = 0;
+};
+
+/**
+ * Digital surface model of the meshes: the maximum y of the geometry at each cell center, NaN where there is none.
+ * heights and the optional ids have rows * columns entries (row major), ids receives meshIds[m] of the mesh that
+ * defines the height of a cell and -1 for empty cells. The raster is processed in tiles on a pool of worker threads,
+ * each tile only visits the meshes whose bounds overlap it.
+ */
+void rasterizeHeightMap(const std::vector<MeshView>& meshes, const std::vector<int32_t>& meshIds,
+                        const HeightMapSpec& spec, float* heights, int32_t* ids);
+
+} // namespace pcu
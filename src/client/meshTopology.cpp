@@ -0,0 +1,165 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "meshTopology.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// splitmix64 finalizer, spreads the packed keys over the table
+inline uint64_t mixBits(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+// power of two with at least twice the slots of the expected entries, keeps the probe sequences short
+size_t getTableCapacity(size_t entryCount) {
+	size_t capacity = 16;
+	while (capacity < 2 * entryCount)
+		capacity *= 2;
+	return capacity;
+}
+
+const uint32_t EMPTY_SLOT = UINT32_MAX;
+
+/**
+ * Maps each vertex to the first vertex with bitwise identical coordinates (-0.0 and 0.0 are treated as equal). The
+ * table holds vertex indices only and compares the coordinates on collision.
+ */
+std::vector<uint32_t> weldVertices(const double* vertices, size_t vertexCount) {
+	std::vector<uint32_t> welded(vertexCount);
+	const size_t capacity = getTableCapacity(vertexCount);
+	const size_t mask = capacity - 1;
+	std::vector<uint32_t> slots(capacity, EMPTY_SLOT);
+
+	for (size_t v = 0; v < vertexCount; v++) {
+		const double* p = vertices + 3 * v;
+		uint64_t hash = 0;
+		for (size_t c = 0; c < 3; c++) {
+			const double coord = p[c] + 0.0; // -0.0 becomes 0.0
+			uint64_t bits;
+			std::memcpy(&bits, &coord, sizeof(bits));
+			hash = mixBits(hash ^ bits);
+		}
+
+		for (size_t s = hash & mask;; s = (s + 1) & mask) {
+			const uint32_t other = slots[s];
+			if (other == EMPTY_SLOT) {
+				slots[s] = static_cast<uint32_t>(v);
+				welded[v] = static_cast<uint32_t>(v);
+				break;
+			}
+			const double* q = vertices + 3 * other;
+			if (p[0] == q[0] && p[1] == q[1] && p[2] == q[2]) {
+				welded[v] = other;
+				break;
+			}
+		}
+	}
+	return welded;
+}
+
+} // namespace
+
+namespace pcu {
+
+size_t EdgeAdjacency::getBoundaryEdgeCount() const {
+	size_t count = 0;
+	for (size_t e = 0; e < getEdgeCount(); e++) {
+		if (edgeFaces[2 * e + 1] < 0)
+			count++;
+	}
+	return count;
+}
+
+EdgeAdjacency buildEdgeAdjacency(const MeshView& mesh, bool weld) {
+	EdgeAdjacency adjacency;
+	if (weld)
+		adjacency.weldedVertices = weldVertices(mesh.vertices, mesh.getVertexCount());
+	const uint32_t* welded = weld ? adjacency.weldedVertices.data() : nullptr;
+
+	adjacency.halfEdgeEdges.assign(mesh.indexCount, -1);
+
+	// open addressing table from the packed vertex pair to the edge index, there are at most as many edges as indices
+	const size_t capacity = getTableCapacity(mesh.indexCount);
+	const size_t mask = capacity - 1;
+	std::vector<uint64_t> slotKeys(capacity);
+	std::vector<uint32_t> slotEdges(capacity, EMPTY_SLOT);
+	std::vector<uint8_t> incidentFaces; // per edge, saturates at 3
+
+	size_t corner = 0;
+	for (size_t f = 0; f < mesh.faceCount; f++) {
+		const uint32_t count = mesh.faceCounts[f];
+		const uint32_t* face = mesh.indices + corner;
+		for (uint32_t i = 0; i < count; i++, corner++) {
+			uint32_t a = face[i];
+			uint32_t b = face[i + 1 == count ? 0 : i + 1];
+			if (welded != nullptr) {
+				a = welded[a];
+				b = welded[b];
+			}
+			if (a == b)
+				continue;
+			if (a > b)
+				std::swap(a, b);
+
+			const uint64_t key = (static_cast<uint64_t>(a) << 32) | b;
+			size_t s = mixBits(key) & mask;
+			while (slotEdges[s] != EMPTY_SLOT && slotKeys[s] != key)
+				s = (s + 1) & mask;
+
+			uint32_t e = slotEdges[s];
+			if (e == EMPTY_SLOT) {
+				e = static_cast<uint32_t>(adjacency.getEdgeCount());
+				slotKeys[s] = key;
+				slotEdges[s] = e;
+				adjacency.edgeVertices.push_back(a);
+				adjacency.edgeVertices.push_back(b);
+				adjacency.edgeFaces.push_back(static_cast<int32_t>(f));
+				adjacency.edgeFaces.push_back(-1);
+				incidentFaces.push_back(1);
+			}
+			else if (adjacency.edgeFaces[2 * e] != static_cast<int32_t>(f) &&
+			         adjacency.edgeFaces[2 * e + 1] != static_cast<int32_t>(f)) {
+				if (adjacency.edgeFaces[2 * e + 1] < 0)
+					adjacency.edgeFaces[2 * e + 1] = static_cast<int32_t>(f);
+				if (incidentFaces[e] == 2)
+					adjacency.nonManifoldEdgeCount++;
+				incidentFaces[e] = static_cast<uint8_t>(std::min(incidentFaces[e] + 1, 3));
+			}
+			adjacency.halfEdgeEdges[corner] = static_cast<int32_t>(e);
+		}
+	}
+	return adjacency;
+}
+
+std::vector<EdgeAdjacency> buildEdgeAdjacencies(const std::vector<MeshView>& meshes, bool weld) {
+	std::vector<EdgeAdjacency> adjacencies(meshes.size());
+	parallelFor(meshes.size(), [&](size_t m) { adjacencies[m] = buildEdgeAdjacency(meshes[m], weld); });
+	return adjacencies;
+}
+
+} // namespace pcu
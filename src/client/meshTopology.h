@@ -0,0 +1,60 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Edge adjacency of a polygon mesh. Face corner i (position in the index buffer) starts the half-edge to the next
+ * corner of its face, halfEdgeEdges[i] is the undirected edge it lies on (-1 for degenerate half-edges). Each edge
+ * stores its end vertices and the first two incident faces (-1 if the edge is on the boundary), edges with more than
+ * two incident faces are counted as non-manifold.
+ */
+struct EdgeAdjacency {
+	std::vector<uint32_t> edgeVertices;   // 2 per edge, smaller vertex index first
+	std::vector<int32_t> edgeFaces;       // 2 per edge
+	std::vector<int32_t> halfEdgeEdges;   // 1 per index
+	std::vector<uint32_t> weldedVertices; // first vertex at the same position per vertex, empty without welding
+	size_t nonManifoldEdgeCount = 0;
+
+	size_t getEdgeCount() const {
+		return edgeVertices.size() / 2;
+	}
+	size_t getBoundaryEdgeCount() const;
+};
+
+/**
+ * Builds the edge adjacency of the mesh. Without vertex merging in the encoder the faces do not share vertices, with
+ * weld the vertices at identical positions are identified first and the edges refer to the first vertex at each
+ * position. Edges are looked up in an open addressing hash table over the packed vertex pair, so building is one pass
+ * over the index buffer without per edge allocations.
+ */
+EdgeAdjacency buildEdgeAdjacency(const MeshView& mesh, bool weld);
+
+// one adjacency per mesh, the meshes are processed in parallel
+std::vector<EdgeAdjacency> buildEdgeAdjacencies(const std::vector<MeshView>& meshes, bool weld);
+
+} // namespace pcu
@@ -0,0 +1,246 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "meshUtils.h"
+#include "CpuDispatch.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+PYPRT_CPU_DISPATCH void rebaseIndices(const uint32_t* src, size_t count, uint32_t base, uint32_t* dst) {
+	for (size_t i = 0; i < count; i++)
+		dst[i] = src[i] + base;
+}
+
+// rebased indices and face offsets of mesh m in the merged buffers
+void mergeTopology(const pcu::MeshView& mesh, size_t m, const pcu::MergedMeshLayout& layout, uint32_t* indices,
+                   uint64_t* faceOffsets) {
+	const uint32_t vertexBase = static_cast<uint32_t>(layout.vertexOffsets[m]);
+	rebaseIndices(mesh.indices, mesh.indexCount, vertexBase, indices + layout.indexOffsets[m]);
+
+	uint64_t offset = layout.indexOffsets[m];
+	uint64_t* dstFaceOffsets = faceOffsets + layout.faceOffsets[m];
+	for (size_t f = 0; f < mesh.faceCount; f++) {
+		dstFaceOffsets[f] = offset;
+		offset += mesh.faceCounts[f];
+	}
+}
+
+// corner of a face projected into the plane of the face
+struct Point2D {
+	double u, v;
+};
+
+// twice the signed area of the triangle o, a, b (positive if counter-clockwise)
+inline double cross(const Point2D& o, const Point2D& a, const Point2D& b) {
+	return (a.u - o.u) * (b.v - o.v) - (a.v - o.v) * (b.u - o.u);
+}
+
+void appendTriangle(std::vector<uint32_t>& triangles, uint32_t a, uint32_t b, uint32_t c) {
+	triangles.push_back(a);
+	triangles.push_back(b);
+	triangles.push_back(c);
+}
+
+void appendFan(std::vector<uint32_t>& triangles, const uint32_t* face, const uint32_t* corners, size_t count) {
+	for (size_t i = 1; i + 1 < count; i++)
+		appendTriangle(triangles, face[corners[0]], face[corners[i]], face[corners[i + 1]]);
+}
+
+/**
+ * Ear clipping of the counter-clockwise projected polygon. A corner is an ear if it is not reflex and no other corner
+ * lies inside its triangle or on the diagonal cutting it off. Self-intersecting leftovers without an ear are fanned.
+ */
+void clipEars(const std::vector<Point2D>& points, const uint32_t* face, std::vector<uint32_t>& triangles) {
+	std::vector<uint32_t> corners(points.size());
+	std::iota(corners.begin(), corners.end(), 0u);
+	size_t i = 0;
+	size_t tested = 0; // corners tested since the last ear
+	while (corners.size() > 3 && tested < corners.size()) {
+		const size_t k = corners.size();
+		const uint32_t a = corners[(i + k - 1) % k], b = corners[i], c = corners[(i + 1) % k];
+		const Point2D &pa = points[a], &pb = points[b], &pc = points[c];
+		bool ear = cross(pa, pb, pc) >= 0.0;
+		for (size_t j = 0; ear && j < k; j++) {
+			const uint32_t r = corners[j];
+			if (r == a || r == b || r == c)
+				continue;
+			const Point2D& p = points[r];
+			ear = !(cross(pa, pb, p) > 0.0 && cross(pb, pc, p) > 0.0 && cross(pc, pa, p) >= 0.0);
+		}
+		if (ear) {
+			appendTriangle(triangles, face[a], face[b], face[c]);
+			corners.erase(corners.begin() + i);
+			i %= corners.size();
+			tested = 0;
+		}
+		else {
+			i = (i + 1) % k;
+			tested++;
+		}
+	}
+	appendFan(triangles, face, corners.data(), corners.size());
+}
+
+} // namespace
+
+namespace pcu {
+
+void computeFaceOffsets(const uint32_t* faceCounts, size_t faceCount, uint32_t* offsets) {
+	uint32_t offset = 0;
+	for (size_t f = 0; f < faceCount; f++) {
+		offsets[f] = offset;
+		offset += faceCounts[f];
+	}
+	offsets[faceCount] = offset;
+}
+
+PYPRT_CPU_DISPATCH void computeBounds(const double* vertices, size_t vertexCount, double* minXYZ, double* maxXYZ) {
+	double mn[3] = {vertices[0], vertices[1], vertices[2]};
+	double mx[3] = {vertices[0], vertices[1], vertices[2]};
+	for (size_t v = 1; v < vertexCount; v++) {
+		for (size_t c = 0; c < 3; c++) {
+			const double x = vertices[3 * v + c];
+			mn[c] = std::min(mn[c], x);
+			mx[c] = std::max(mx[c], x);
+		}
+	}
+	std::copy(mn, mn + 3, minXYZ);
+	std::copy(mx, mx + 3, maxXYZ);
+}
+
+void triangulateFace(const double* vertices, const uint32_t* face, uint32_t count, std::vector<uint32_t>& triangles) {
+	if (count < 3)
+		return;
+	if (count == 3) {
+		appendTriangle(triangles, face[0], face[1], face[2]);
+		return;
+	}
+
+	// Newell normal, the polygon is projected along its dominant axis and oriented counter-clockwise
+	double n[3] = {0.0, 0.0, 0.0};
+	for (uint32_t i = 0; i < count; i++) {
+		const double* p = vertices + 3 * face[i];
+		const double* q = vertices + 3 * face[(i + 1) % count];
+		n[0] += (p[1] - q[1]) * (p[2] + q[2]);
+		n[1] += (p[2] - q[2]) * (p[0] + q[0]);
+		n[2] += (p[0] - q[0]) * (p[1] + q[1]);
+	}
+	const size_t axis = (std::abs(n[0]) > std::abs(n[1]))
+	                            ? (std::abs(n[0]) > std::abs(n[2]) ? 0 : 2)
+	                            : (std::abs(n[1]) > std::abs(n[2]) ? 1 : 2);
+	size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+	if (n[axis] < 0.0)
+		std::swap(u, v);
+	auto project = [&](uint32_t i) {
+		const double* p = vertices + 3 * face[i];
+		return Point2D{p[u], p[v]};
+	};
+
+	bool convex = true;
+	for (uint32_t i = 0; convex && i < count; i++)
+		convex = cross(project((i + count - 1) % count), project(i), project((i + 1) % count)) >= 0.0;
+	if (convex || n[axis] == 0.0) { // degenerate polygons are fanned as well
+		for (uint32_t i = 1; i + 1 < count; i++)
+			appendTriangle(triangles, face[0], face[i], face[i + 1]);
+		return;
+	}
+
+	std::vector<Point2D> points(count);
+	for (uint32_t i = 0; i < count; i++)
+		points[i] = project(i);
+	clipEars(points, face, triangles);
+}
+
+PYPRT_CPU_DISPATCH void transformVertices(double* vertices, size_t vertexCount, const double* m) {
+	for (size_t v = 0; v < vertexCount; v++) {
+		double* p = vertices + 3 * v;
+		const double x = p[0], y = p[1], z = p[2];
+		p[0] = m[0] * x + m[1] * y + m[2] * z + m[3];
+		p[1] = m[4] * x + m[5] * y + m[6] * z + m[7];
+		p[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+	}
+}
+
+PYPRT_CPU_DISPATCH void interleaveVertices(const double* x, const double* y, const double* z, size_t vertexCount,
+                                           double* vertices) {
+	for (size_t v = 0; v < vertexCount; v++) {
+		vertices[3 * v] = x[v];
+		vertices[3 * v + 1] = y[v];
+		vertices[3 * v + 2] = z[v];
+	}
+}
+
+PYPRT_CPU_DISPATCH void deinterleaveVertices(const double* vertices, size_t vertexCount, double* x, double* y,
+                                             double* z) {
+	for (size_t v = 0; v < vertexCount; v++) {
+		x[v] = vertices[3 * v];
+		y[v] = vertices[3 * v + 1];
+		z[v] = vertices[3 * v + 2];
+	}
+}
+
+MergedMeshLayout computeMergedLayout(const std::vector<MeshView>& meshes) {
+	MergedMeshLayout layout;
+	layout.vertexOffsets.resize(meshes.size() + 1, 0);
+	layout.indexOffsets.resize(meshes.size() + 1, 0);
+	layout.faceOffsets.resize(meshes.size() + 1, 0);
+
+	for (size_t m = 0; m < meshes.size(); m++) {
+		layout.vertexOffsets[m + 1] = layout.vertexOffsets[m] + meshes[m].getVertexCount();
+		layout.indexOffsets[m + 1] = layout.indexOffsets[m] + meshes[m].indexCount;
+		layout.faceOffsets[m + 1] = layout.faceOffsets[m] + meshes[m].faceCount;
+	}
+
+	if (layout.getVertexCount() > std::numeric_limits<uint32_t>::max())
+		throw std::length_error("merged vertex count exceeds the range of 32bit indices.");
+
+	return layout;
+}
+
+void mergeMeshes(const std::vector<MeshView>& meshes, const MergedMeshLayout& layout, double* vertices,
+                 uint32_t* indices, uint64_t* faceOffsets) {
+	parallelFor(meshes.size(), [&](size_t m) {
+		const MeshView& mesh = meshes[m];
+
+		std::copy(mesh.vertices, mesh.vertices + mesh.vertexCoordCount, vertices + 3 * layout.vertexOffsets[m]);
+		mergeTopology(mesh, m, layout, indices, faceOffsets);
+	});
+	faceOffsets[layout.getFaceCount()] = layout.getIndexCount();
+}
+
+void mergeMeshes(const std::vector<MeshView>& meshes, const std::vector<const VertexComponents*>& vertexComponents,
+                 const MergedMeshLayout& layout, const std::array<double*, 3>& xyz, uint32_t* indices,
+                 uint64_t* faceOffsets) {
+	parallelFor(meshes.size(), [&](size_t m) {
+		const VertexComponents& components = *vertexComponents[m];
+		for (size_t c = 0; c < 3; c++)
+			std::copy(components[c].begin(), components[c].end(), xyz[c] + layout.vertexOffsets[m]);
+		mergeTopology(meshes[m], m, layout, indices, faceOffsets);
+	});
+	faceOffsets[layout.getFaceCount()] = layout.getIndexCount();
+}
+
+} // namespace pcu
@@ -0,0 +1,146 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "vertexTransforms.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * non-owning view onto the flat mesh buffers of a generated model
+ * (interleaved xyz vertex coordinates, face vertex indices and vertex count per face)
+ */
+struct MeshView {
+	const double* vertices = nullptr;
+	size_t vertexCoordCount = 0;
+	const uint32_t* indices = nullptr;
+	size_t indexCount = 0;
+	const uint32_t* faceCounts = nullptr;
+	size_t faceCount = 0;
+
+	size_t getVertexCount() const {
+		return vertexCoordCount / 3;
+	}
+};
+
+/**
+ * owning flat polygon mesh, e.g. the geometry of an initial shape created natively
+ */
+struct ShapeGeometry {
+	std::vector<double> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> faceCounts;
+
+	size_t getVertexCount() const {
+		return vertices.size() / 3;
+	}
+
+	MeshView getMeshView() const {
+		return {vertices.data(), vertices.size(), indices.data(), indices.size(), faceCounts.data(), faceCounts.size()};
+	}
+};
+
+/**
+ * result of a native initial shape parser for one input geometry
+ */
+struct ParsedShape {
+	ShapeGeometry geometry;
+	std::string name;  // source object name, if the format has one
+	std::string error; // empty if the geometry was parsed successfully
+	size_t droppedHoles = 0;
+};
+
+/**
+ * offsets[f] is the position of the first index of face f in the index buffer, offsets[faceCount] == indexCount
+ * (offsets must have space for faceCount + 1 entries)
+ */
+void computeFaceOffsets(const uint32_t* faceCounts, size_t faceCount, uint32_t* offsets);
+
+/**
+ * axis aligned bounding box of vertexCount interleaved xyz vertices (vertexCount must be > 0)
+ */
+void computeBounds(const double* vertices, size_t vertexCount, double* minXYZ, double* maxXYZ);
+
+/**
+ * Splits the polygon of count vertex indices into count - 2 triangles with the winding of the polygon and appends
+ * their vertex indices (three per triangle) to triangles. Convex polygons are fanned, concave ones (e.g. the roof of
+ * an L-shaped building, the encoder does not triangulate by default) are ear clipped in the plane of their normal, so
+ * no triangle leaves the polygon. Polygons with less than three vertices give no triangles.
+ */
+void triangulateFace(const double* vertices, const uint32_t* face, uint32_t count, std::vector<uint32_t>& triangles);
+
+/**
+ * In-place affine transform v' = M * v of vertexCount interleaved xyz vertices, the matrix is given row-major as 3x4
+ * (rotation/scale in the first three columns, translation in the last). Written as straight loops over the
+ * interleaved buffer so the compiler can vectorize them.
+ */
+void transformVertices(double* vertices, size_t vertexCount, const double* matrix3x4);
+
+// separate x, y and z arrays of vertexCount values each (structure-of-arrays layout)
+using VertexComponents = std::array<std::vector<double>, 3>;
+
+// interleaved xyz vertices (vertexCount * 3 values) from the separate components and back
+void interleaveVertices(const double* x, const double* y, const double* z, size_t vertexCount, double* vertices);
+void deinterleaveVertices(const double* vertices, size_t vertexCount, double* x, double* y, double* z);
+
+/**
+ * start positions of each mesh in the concatenated buffers of a batch, all vectors have meshes.size() + 1 entries
+ */
+struct MergedMeshLayout {
+	std::vector<size_t> vertexOffsets; // in vertices, not coordinates
+	std::vector<size_t> indexOffsets;
+	std::vector<size_t> faceOffsets;
+
+	size_t getVertexCount() const {
+		return vertexOffsets.back();
+	}
+	size_t getIndexCount() const {
+		return indexOffsets.back();
+	}
+	size_t getFaceCount() const {
+		return faceOffsets.back();
+	}
+};
+
+MergedMeshLayout computeMergedLayout(const std::vector<MeshView>& meshes);
+
+/**
+ * Concatenates all meshes into preallocated buffers sized according to the layout. Indices are rebased to the merged
+ * vertex buffer and faceOffsets (layout.getFaceCount() + 1 entries) receives the start of each face in the merged
+ * index buffer. Meshes are processed in parallel.
+ */
+void mergeMeshes(const std::vector<MeshView>& meshes, const MergedMeshLayout& layout, double* vertices,
+                 uint32_t* indices, uint64_t* faceOffsets);
+
+/**
+ * Same as above, but the vertices are taken from the separate components of each mesh and written into separate x, y
+ * and z buffers (layout.getVertexCount() entries each). The vertices of the mesh views are not read.
+ */
+void mergeMeshes(const std::vector<MeshView>& meshes, const std::vector<const VertexComponents*>& vertexComponents,
+                 const MergedMeshLayout& layout, const std::array<double*, 3>& xyz, uint32_t* indices,
+                 uint64_t* faceOffsets);
+
+} // namespace pcu
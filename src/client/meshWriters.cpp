@@ -0,0 +1,312 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "meshWriters.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const uint64_t POW10[] = {1ull,
+                          10ull,
+                          100ull,
+                          1000ull,
+                          10000ull,
+                          100000ull,
+                          1000000ull,
+                          10000000ull,
+                          100000000ull,
+                          1000000000ull,
+                          10000000000ull,
+                          100000000000ull,
+                          1000000000000ull,
+                          10000000000000ull,
+                          100000000000000ull,
+                          1000000000000000ull};
+const int MAX_PRECISION = 15;
+
+// number of meshes formatted per worker before the chunks are flushed to disk
+const size_t MESHES_PER_WORKER = 8;
+
+char* formatUInt(char* out, uint64_t v) {
+	char digits[20];
+	int n = 0;
+	do {
+		digits[n++] = static_cast<char>('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+	while (n > 0)
+		*out++ = digits[--n];
+	return out;
+}
+
+template <typename T>
+void appendBinary(std::string& out, const T& v) {
+	// all supported platforms are little endian, which is what PLY (as declared below) and STL expect
+	out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+/**
+ * Formats the meshes with format(meshIndex, chunk) in parallel and appends the chunks to the stream in mesh order.
+ * Only a window of meshes is kept in memory at once.
+ */
+template <typename F>
+void writeChunked(std::ofstream& out, const std::string& path, size_t meshCount, F&& format) {
+	const size_t windowSize = pcu::getWorkerCount(meshCount) * MESHES_PER_WORKER;
+	std::vector<std::string> chunks(windowSize);
+
+	for (size_t windowStart = 0; windowStart < meshCount; windowStart += windowSize) {
+		const size_t windowCount = std::min(windowSize, meshCount - windowStart);
+		pcu::parallelFor(windowCount, [&](size_t i) {
+			chunks[i].clear();
+			format(windowStart + i, chunks[i]);
+		});
+		for (size_t i = 0; i < windowCount; i++)
+			out.write(chunks[i].data(), static_cast<std::streamsize>(chunks[i].size()));
+		if (!out)
+			throw std::runtime_error("failed to write '" + path + "'.");
+	}
+}
+
+void openOutput(std::ofstream& out, const std::string& path) {
+	out.open(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	if (!out)
+		throw std::runtime_error("could not open '" + path + "' for writing.");
+}
+
+void closeOutput(std::ofstream& out, const std::string& path) {
+	out.close();
+	if (!out)
+		throw std::runtime_error("failed to write '" + path + "'.");
+}
+
+size_t countTriangles(const pcu::MeshView& mesh) {
+	size_t count = 0;
+	for (size_t f = 0; f < mesh.faceCount; f++)
+		count += (mesh.faceCounts[f] >= 3) ? mesh.faceCounts[f] - 2 : 0;
+	return count;
+}
+
+} // namespace
+
+namespace pcu {
+
+char* formatDouble(char* out, double v, int precision) {
+	precision = std::max(0, std::min(precision, MAX_PRECISION));
+	const uint64_t scale = POW10[precision];
+	const double scaled = std::fabs(v) * static_cast<double>(scale);
+
+	// fall back to the C library for values the integer path cannot represent exactly enough
+	if (!std::isfinite(v) || scaled >= 9.0e18)
+		return out + std::snprintf(out, 32, "%.17g", v);
+
+	const uint64_t s = static_cast<uint64_t>(std::llround(scaled));
+	const uint64_t integral = s / scale;
+	uint64_t fraction = s % scale;
+
+	if (v < 0.0 && s != 0)
+		*out++ = '-';
+	out = formatUInt(out, integral);
+
+	if (fraction != 0) {
+		int digits = precision;
+		while (fraction % 10 == 0) { // trim trailing zeros
+			fraction /= 10;
+			digits--;
+		}
+		*out++ = '.';
+		char* end = out + digits;
+		for (char* p = end - 1; p >= out; p--) {
+			*p = static_cast<char>('0' + fraction % 10);
+			fraction /= 10;
+		}
+		out = end;
+	}
+	return out;
+}
+
+void writeOBJ(const std::string& path, const std::vector<MeshView>& meshes, const std::vector<std::string>& names,
+              int precision) {
+	const MergedMeshLayout layout = computeMergedLayout(meshes);
+
+	std::ofstream out;
+	openOutput(out, path);
+	out << "# written by pyprt\n";
+
+	auto format = [&](size_t m, std::string& chunk) {
+		const MeshView& mesh = meshes[m];
+		chunk.reserve(mesh.vertexCoordCount * 12 + mesh.indexCount * 8 + mesh.faceCount * 3 + 64);
+
+		chunk += "o ";
+		chunk += (m < names.size()) ? names[m] : ("shape_" + std::to_string(m));
+		chunk += '\n';
+
+		std::array<char, 128> line;
+		for (size_t v = 0; v < mesh.getVertexCount(); v++) {
+			char* p = line.data();
+			*p++ = 'v';
+			for (size_t c = 0; c < 3; c++) {
+				*p++ = ' ';
+				p = formatDouble(p, mesh.vertices[3 * v + c], precision);
+			}
+			*p++ = '\n';
+			chunk.append(line.data(), p);
+		}
+
+		const uint64_t indexBase = layout.vertexOffsets[m] + 1; // OBJ indices are global and one-based
+		const uint32_t* idx = mesh.indices;
+		for (size_t f = 0; f < mesh.faceCount; f++) {
+			chunk += 'f';
+			for (uint32_t i = 0; i < mesh.faceCounts[f]; i++) {
+				char* p = line.data();
+				*p++ = ' ';
+				p = formatUInt(p, indexBase + idx[i]);
+				chunk.append(line.data(), p);
+			}
+			chunk += '\n';
+			idx += mesh.faceCounts[f];
+		}
+	};
+
+	writeChunked(out, path, meshes.size(), format);
+	closeOutput(out, path);
+}
+
+void writePLY(const std::string& path, const std::vector<MeshView>& meshes) {
+	const MergedMeshLayout layout = computeMergedLayout(meshes);
+
+	uint32_t maxFaceVertexCount = 0;
+	for (const MeshView& mesh : meshes)
+		for (size_t f = 0; f < mesh.faceCount; f++)
+			maxFaceVertexCount = std::max(maxFaceVertexCount, mesh.faceCounts[f]);
+	const bool smallFaces = maxFaceVertexCount <= std::numeric_limits<uint8_t>::max();
+
+	std::ofstream out;
+	openOutput(out, path);
+
+	out << "ply\n"
+	    << "format binary_little_endian 1.0\n"
+	    << "comment written by pyprt\n"
+	    << "element vertex " << layout.getVertexCount() << "\n"
+	    << "property double x\n"
+	    << "property double y\n"
+	    << "property double z\n"
+	    << "element face " << layout.getFaceCount() << "\n"
+	    << "property list " << (smallFaces ? "uchar" : "uint") << " uint vertex_indices\n"
+	    << "end_header\n";
+
+	// vertices of all meshes first, then all faces (PLY stores elements contiguously)
+	auto formatVertices = [&](size_t m, std::string& chunk) {
+		const MeshView& mesh = meshes[m];
+		chunk.assign(reinterpret_cast<const char*>(mesh.vertices), mesh.vertexCoordCount * sizeof(double));
+	};
+
+	auto formatFaces = [&](size_t m, std::string& chunk) {
+		const MeshView& mesh = meshes[m];
+		chunk.reserve(mesh.faceCount * (smallFaces ? 1 : 4) + mesh.indexCount * 4);
+		const uint32_t indexBase = static_cast<uint32_t>(layout.vertexOffsets[m]);
+		const uint32_t* idx = mesh.indices;
+		for (size_t f = 0; f < mesh.faceCount; f++) {
+			const uint32_t n = mesh.faceCounts[f];
+			if (smallFaces)
+				appendBinary(chunk, static_cast<uint8_t>(n));
+			else
+				appendBinary(chunk, n);
+			for (uint32_t i = 0; i < n; i++)
+				appendBinary(chunk, indexBase + idx[i]);
+			idx += n;
+		}
+	};
+
+	writeChunked(out, path, meshes.size(), formatVertices);
+	writeChunked(out, path, meshes.size(), formatFaces);
+	closeOutput(out, path);
+}
+
+void writeSTL(const std::string& path, const std::vector<MeshView>& meshes) {
+	size_t triangleCount = 0;
+	for (const MeshView& mesh : meshes)
+		triangleCount += countTriangles(mesh);
+	if (triangleCount > std::numeric_limits<uint32_t>::max())
+		throw std::length_error("too many triangles for binary STL: " + std::to_string(triangleCount));
+
+	std::ofstream out;
+	openOutput(out, path);
+
+	std::array<char, 80> header;
+	header.fill(' ');
+	const char* title = "binary STL written by pyprt";
+	std::copy(title, title + std::strlen(title), header.begin());
+	out.write(header.data(), header.size());
+	const uint32_t count = static_cast<uint32_t>(triangleCount);
+	out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+	auto format = [&](size_t m, std::string& chunk) {
+		const MeshView& mesh = meshes[m];
+		chunk.reserve(countTriangles(mesh) * 50);
+
+		auto vertex = [&](uint32_t i) {
+			const double* v = mesh.vertices + 3 * i;
+			return std::array<double, 3>{v[0], v[1], v[2]};
+		};
+
+		const uint32_t* idx = mesh.indices;
+		std::vector<uint32_t> triangles;
+		for (size_t f = 0; f < mesh.faceCount; f++) {
+			const uint32_t n = mesh.faceCounts[f];
+			triangles.clear();
+			triangulateFace(mesh.vertices, idx, n, triangles);
+			for (size_t t = 0; t < triangles.size(); t += 3) {
+				const auto a = vertex(triangles[t]);
+				const auto b = vertex(triangles[t + 1]);
+				const auto c = vertex(triangles[t + 2]);
+
+				const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+				const double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+				double nrm[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2],
+				                 ab[0] * ac[1] - ab[1] * ac[0]};
+				const double len = std::sqrt(nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2]);
+				for (double& x : nrm)
+					x = (len > 0.0) ? x / len : 0.0;
+
+				for (double x : nrm)
+					appendBinary(chunk, static_cast<float>(x));
+				for (const auto& p : {a, b, c})
+					for (double x : p)
+						appendBinary(chunk, static_cast<float>(x));
+				appendBinary(chunk, static_cast<uint16_t>(0));
+			}
+			idx += n;
+		}
+	};
+
+	writeChunked(out, path, meshes.size(), format);
+	closeOutput(out, path);
+}
+
+} // namespace pcu
@@ -0,0 +1,52 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Writers for the flat mesh buffers collected by the PyEncoder. Formatting runs in parallel over the meshes, the
+ * formatted chunks are written sequentially in mesh order. Polygons are triangulated (see triangulateFace) where the
+ * format requires triangles (STL). All writers throw std::runtime_error if the file cannot be written. They do not
+ * touch Python or PRT state and can run with the GIL released.
+ */
+
+// one "o" group per mesh, named after the corresponding entry in names
+void writeOBJ(const std::string& path, const std::vector<MeshView>& meshes, const std::vector<std::string>& names,
+              int precision);
+
+// binary little endian PLY with double precision vertices and polygonal faces
+void writePLY(const std::string& path, const std::vector<MeshView>& meshes);
+
+// binary STL, single precision as mandated by the format
+void writeSTL(const std::string& path, const std::vector<MeshView>& meshes);
+
+/**
+ * Formats v in fixed notation with at most precision fractional digits (trailing zeros are removed) and returns a
+ * pointer past the last written char. out must have space for 32 chars.
+ */
+char* formatDouble(char* out, double v, int precision);
+
+} // namespace pcu
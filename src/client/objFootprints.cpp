@@ -0,0 +1,363 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "objFootprints.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace pcu {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                    FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE) {
+		mFile = nullptr;
+		throw std::runtime_error("could not open " + path);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize)) {
+		CloseHandle(mFile);
+		throw std::runtime_error("could not get size of " + path);
+	}
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+	if (mSize == 0)
+		return;
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping != nullptr)
+		mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr) {
+		if (mMapping != nullptr)
+			CloseHandle(mMapping);
+		CloseHandle(mFile);
+		throw std::runtime_error("could not map " + path);
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+	if (mFile != nullptr)
+		CloseHandle(mFile);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("could not open " + path);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("could not get size of " + path);
+	}
+	mSize = static_cast<size_t>(st.st_size);
+
+	if (mSize > 0) {
+		void* p = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("could not map " + path);
+		}
+		madvise(p, mSize, MADV_WILLNEED);
+		mData = static_cast<const char*>(p);
+	}
+	close(fd); // the mapping stays valid
+}
+
+MappedFile::~MappedFile() {
+	if (mData != nullptr)
+		munmap(const_cast<char*>(mData), mSize);
+}
+
+#endif
+
+} // namespace pcu
+
+namespace {
+
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+inline bool isBlank(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+	while (p < end && isBlank(*p))
+		p++;
+	return p;
+}
+
+// true if the line starts with the given one-character statement keyword
+inline bool isStatement(const char* p, const char* end, char keyword) {
+	return p < end && *p == keyword && (p + 1 == end || isBlank(p[1]));
+}
+
+// copies the token into a terminated buffer because the mapped data is not null-terminated
+bool readDouble(const char*& p, const char* end, double& value) {
+	p = skipBlanks(p, end);
+	char buffer[64];
+	size_t n = 0;
+	while (p + n < end && !isBlank(p[n]) && n < sizeof(buffer) - 1) {
+		buffer[n] = p[n];
+		n++;
+	}
+	if (n == 0)
+		return false;
+	buffer[n] = 0;
+	char* parsedEnd = nullptr;
+	value = std::strtod(buffer, &parsedEnd);
+	p += n;
+	return parsedEnd == buffer + n;
+}
+
+/**
+ * reads the vertex index of a face token "v", "v/vt", "v//vn" or "v/vt/vn" and skips the rest of the token
+ */
+bool readFaceIndex(const char*& p, const char* end, int64_t& index) {
+	p = skipBlanks(p, end);
+	if (p == end)
+		return false;
+	bool negative = false;
+	if (*p == '-' || *p == '+')
+		negative = (*p++ == '-');
+	const char* digits = p;
+	int64_t v = 0;
+	while (p < end && *p >= '0' && *p <= '9' && v < (int64_t(1) << 40))
+		v = v * 10 + (*p++ - '0');
+	const bool valid = (p != digits);
+	while (p < end && !isBlank(*p))
+		p++;
+	index = negative ? -v : v;
+	return valid;
+}
+
+struct ObjectStart {
+	size_t faceIndex; // first face of the object in the chunk
+	std::string name;
+};
+
+struct Chunk {
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	size_t vertexCount = 0;
+	size_t vertexOffset = 0; // number of vertices in all preceding chunks
+
+	std::vector<uint32_t> indices; // file-wide, zero-based vertex indices
+	std::vector<uint32_t> faceCounts;
+	std::vector<size_t> faceOffsets; // start of each face in indices
+	std::vector<ObjectStart> objects;
+};
+
+struct ObjectSegment {
+	size_t chunk;
+	size_t faceBegin;
+	size_t faceEnd;
+};
+
+struct ObjectDef {
+	std::string name;
+	std::vector<ObjectSegment> segments;
+};
+
+template <typename F>
+void forEachLine(const char* begin, const char* end, F&& func) {
+	const char* p = begin;
+	while (p < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		func(skipBlanks(p, lineEnd), lineEnd);
+		p = lineEnd + 1;
+	}
+}
+
+std::vector<Chunk> splitChunks(const char* data, size_t size) {
+	const size_t targetChunks = 4 * pcu::getWorkerCount(size / MIN_CHUNK_SIZE + 1);
+	const size_t chunkSize = std::max(MIN_CHUNK_SIZE, size / targetChunks + 1);
+
+	std::vector<Chunk> chunks;
+	const char* end = data + size;
+	for (const char* p = data; p < end;) {
+		const char* chunkEnd = p + std::min(chunkSize, static_cast<size_t>(end - p));
+		if (chunkEnd < end) { // extend to the end of the line
+			const char* nl = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+			chunkEnd = (nl != nullptr) ? nl + 1 : end;
+		}
+		chunks.emplace_back();
+		chunks.back().begin = p;
+		chunks.back().end = chunkEnd;
+		p = chunkEnd;
+	}
+	return chunks;
+}
+
+void parseChunk(Chunk& chunk, double* vertices, size_t totalVertexCount, bool splitGroups) {
+	size_t vertexIndex = chunk.vertexOffset;
+
+	forEachLine(chunk.begin, chunk.end, [&](const char* p, const char* lineEnd) {
+		if (isStatement(p, lineEnd, 'v')) {
+			p++;
+			double* v = vertices + 3 * vertexIndex++;
+			for (int i = 0; i < 3; i++) {
+				if (!readDouble(p, lineEnd, v[i]))
+					throw std::runtime_error("invalid vertex in line '" + std::string(p, lineEnd) + "'");
+			}
+		}
+		else if (isStatement(p, lineEnd, 'f')) {
+			p++;
+			chunk.faceOffsets.push_back(chunk.indices.size());
+			int64_t index;
+			uint32_t count = 0;
+			while (readFaceIndex(p, lineEnd, index)) {
+				// relative indices refer to the vertices defined so far
+				const int64_t resolved = (index < 0) ? static_cast<int64_t>(vertexIndex) + index : index - 1;
+				const bool valid = index != 0 && resolved >= 0 && resolved < static_cast<int64_t>(totalVertexCount);
+				chunk.indices.push_back(valid ? static_cast<uint32_t>(resolved) : INVALID_INDEX);
+				count++;
+			}
+			chunk.faceCounts.push_back(count);
+		}
+		else if (isStatement(p, lineEnd, 'o') || (splitGroups && isStatement(p, lineEnd, 'g'))) {
+			const char* nameBegin = skipBlanks(p + 1, lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > nameBegin && isBlank(nameEnd[-1]))
+				nameEnd--;
+			chunk.objects.push_back({chunk.faceCounts.size(), std::string(nameBegin, nameEnd)});
+		}
+	});
+}
+
+std::vector<ObjectDef> collectObjects(const std::vector<Chunk>& chunks) {
+	std::vector<ObjectDef> objects(1); // unnamed object for faces before the first statement
+	for (size_t c = 0; c < chunks.size(); c++) {
+		const Chunk& chunk = chunks[c];
+		size_t faceBegin = 0;
+		for (size_t o = 0; o <= chunk.objects.size(); o++) {
+			const size_t faceEnd = (o < chunk.objects.size()) ? chunk.objects[o].faceIndex : chunk.faceCounts.size();
+			if (faceEnd > faceBegin)
+				objects.back().segments.push_back({c, faceBegin, faceEnd});
+			if (o < chunk.objects.size()) {
+				objects.emplace_back();
+				objects.back().name = chunk.objects[o].name;
+			}
+			faceBegin = faceEnd;
+		}
+	}
+	objects.erase(std::remove_if(objects.begin(), objects.end(),
+	                             [](const ObjectDef& o) { return o.segments.empty(); }),
+	              objects.end());
+	return objects;
+}
+
+void buildObject(const ObjectDef& object, const std::vector<Chunk>& chunks, const double* vertices,
+                 pcu::ParsedShape& shape) {
+	shape.name = object.name;
+	pcu::ShapeGeometry& g = shape.geometry;
+	std::unordered_map<uint32_t, uint32_t> localIndices;
+
+	for (const ObjectSegment& s : object.segments) {
+		const Chunk& chunk = chunks[s.chunk];
+		const size_t indexBegin = chunk.faceOffsets[s.faceBegin];
+		const size_t indexEnd = (s.faceEnd < chunk.faceOffsets.size()) ? chunk.faceOffsets[s.faceEnd]
+		                                                                 : chunk.indices.size();
+		g.faceCounts.insert(g.faceCounts.end(), chunk.faceCounts.begin() + s.faceBegin,
+		                    chunk.faceCounts.begin() + s.faceEnd);
+
+		for (size_t i = indexBegin; i < indexEnd; i++) {
+			const uint32_t globalIndex = chunk.indices[i];
+			if (globalIndex == INVALID_INDEX) {
+				shape.geometry = pcu::ShapeGeometry();
+				shape.error = "face refers to an invalid vertex index";
+				return;
+			}
+			const auto inserted = localIndices.emplace(globalIndex, static_cast<uint32_t>(localIndices.size()));
+			if (inserted.second)
+				g.vertices.insert(g.vertices.end(), vertices + 3 * size_t(globalIndex),
+				                  vertices + 3 * size_t(globalIndex) + 3);
+			g.indices.push_back(inserted.first->second);
+		}
+	}
+}
+
+} // namespace
+
+namespace pcu {
+
+std::vector<ParsedShape> parseOBJ(const char* data, size_t size, bool splitGroups) {
+	std::vector<Chunk> chunks = splitChunks(data, size);
+
+	// pass 1: count vertices to know the file-wide index of the first vertex in each chunk
+	parallelFor(chunks.size(), [&](size_t c) {
+		size_t count = 0;
+		forEachLine(chunks[c].begin, chunks[c].end, [&](const char* p, const char* lineEnd) {
+			if (isStatement(p, lineEnd, 'v'))
+				count++;
+		});
+		chunks[c].vertexCount = count;
+	});
+	size_t vertexCount = 0;
+	for (Chunk& c : chunks) {
+		c.vertexOffset = vertexCount;
+		vertexCount += c.vertexCount;
+	}
+	if (vertexCount >= INVALID_INDEX)
+		throw std::runtime_error("OBJ file has too many vertices");
+
+	// pass 2: parse vertices into their final position and faces with resolved indices
+	std::vector<double> vertices(3 * vertexCount);
+	parallelFor(chunks.size(), [&](size_t c) { parseChunk(chunks[c], vertices.data(), vertexCount, splitGroups); });
+
+	// pass 3: assemble objects, each with its own compact vertex list
+	const std::vector<ObjectDef> objects = collectObjects(chunks);
+	std::vector<ParsedShape> shapes(objects.size());
+	parallelFor(objects.size(), [&](size_t o) { buildObject(objects[o], chunks, vertices.data(), shapes[o]); });
+	return shapes;
+}
+
+std::vector<ParsedShape> parseOBJFile(const std::string& path, bool splitGroups) {
+	const MappedFile file(path);
+	return parseOBJ(file.data(), file.size(), splitGroups);
+}
+
+} // namespace pcu
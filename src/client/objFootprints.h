@@ -0,0 +1,69 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * read-only memory mapping of a whole file, throws std::runtime_error if the file cannot be mapped
+ */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const char* data() const {
+		return mData;
+	}
+	size_t size() const {
+		return mSize;
+	}
+
+private:
+	const char* mData = nullptr;
+	size_t mSize = 0;
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+};
+
+/**
+ * Splits a Wavefront OBJ file into one initial shape per object ("o" statement, optionally also per "g" group).
+ * Only vertex positions and faces are read, vertex indices (absolute or relative) refer to the file-wide vertex
+ * list and are compacted per object. Faces before the first object statement form an unnamed object, objects without
+ * faces are omitted.
+ *
+ * The buffer is split into line-aligned chunks which are parsed in parallel, the objects are then assembled in
+ * parallel as well. Objects with invalid face indices are returned with an error and without geometry.
+ */
+std::vector<ParsedShape> parseOBJ(const char* data, size_t size, bool splitGroups);
+
+std::vector<ParsedShape> parseOBJFile(const std::string& path, bool splitGroups);
+
+} // namespace pcu
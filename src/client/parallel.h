@@ -0,0 +1,92 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * number of worker threads used by the native batch kernels
+ */
+inline size_t getWorkerCount(size_t workItems) {
+	const size_t hwThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	return std::max<size_t>(1, std::min(hwThreads, workItems));
+}
+
+/**
+ * Calls func(i) for every i in [0, count) on a pool of worker threads. Work items are handed out dynamically in
+ * blocks of grainSize to balance uneven per-item cost (e.g. models of very different size). The first exception
+ * thrown by a worker is rethrown in the calling thread.
+ */
+template <typename F>
+void parallelFor(size_t count, F&& func, size_t grainSize = 1) {
+	if (count == 0)
+		return;
+
+	grainSize = std::max<size_t>(1, grainSize);
+	const size_t blockCount = (count + grainSize - 1) / grainSize;
+	const size_t workerCount = getWorkerCount(blockCount);
+
+	if (workerCount == 1) {
+		for (size_t i = 0; i < count; i++)
+			func(i);
+		return;
+	}
+
+	std::atomic<size_t> nextBlock{0};
+	std::exception_ptr firstError;
+	std::mutex errorMutex;
+
+	auto worker = [&]() {
+		try {
+			for (size_t b = nextBlock++; b < blockCount; b = nextBlock++) {
+				const size_t end = std::min(count, (b + 1) * grainSize);
+				for (size_t i = b * grainSize; i < end; i++)
+					func(i);
+			}
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!firstError)
+				firstError = std::current_exception();
+			nextBlock = blockCount; // stop handing out work
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	for (size_t t = 1; t < workerCount; t++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& t : threads)
+		t.join();
+
+	if (firstError)
+		std::rethrow_exception(firstError);
+}
+
+} // namespace pcu
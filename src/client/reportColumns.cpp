@@ -0,0 +1,73 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "reportColumns.h"
+
+#include <cmath>
+
+namespace {
+
+template <typename C, typename T>
+C& getColumn(std::vector<C>& columns, std::unordered_map<std::wstring, size_t>& indices, const std::wstring& key,
+             size_t rowCount, T missing) {
+	const auto inserted = indices.emplace(key, columns.size());
+	if (inserted.second) {
+		columns.emplace_back();
+		columns.back().key = key;
+		columns.back().values.assign(rowCount, missing);
+	}
+	return columns[inserted.first->second];
+}
+
+} // namespace
+
+namespace pcu {
+
+ReportColumns buildReportColumns(const std::vector<const Reports*>& rows) {
+	const size_t rowCount = rows.size();
+	ReportColumns columns;
+	std::unordered_map<std::wstring, size_t> boolIndices;
+	std::unordered_map<std::wstring, size_t> floatIndices;
+	std::unordered_map<std::wstring, size_t> stringIndices;
+
+	for (size_t r = 0; r < rowCount; r++) {
+		if (rows[r] == nullptr)
+			continue;
+		const Reports& reports = *rows[r];
+		for (size_t i = 0; i < reports.boolKeys.size(); i++)
+			getColumn(columns.bools, boolIndices, reports.boolKeys[i], rowCount, int8_t(-1)).values[r] =
+			        reports.boolValues[i] ? 1 : 0;
+		for (size_t i = 0; i < reports.floatKeys.size(); i++)
+			getColumn(columns.floats, floatIndices, reports.floatKeys[i], rowCount, std::nan("")).values[r] =
+			        reports.floatValues[i];
+		for (size_t i = 0; i < reports.stringKeys.size(); i++) {
+			const auto inserted = stringIndices.emplace(reports.stringKeys[i], columns.strings.size());
+			if (inserted.second) {
+				columns.strings.emplace_back();
+				columns.strings.back().key = reports.stringKeys[i];
+				columns.strings.back().codes.assign(rowCount, -1);
+			}
+			ReportColumns::StringColumn& column = columns.strings[inserted.first->second];
+			column.codes[r] = column.dictionary.encode(reports.stringValues[i]);
+		}
+	}
+	return columns;
+}
+
+} // namespace pcu
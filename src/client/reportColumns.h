@@ -0,0 +1,79 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "reports.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Maps each distinct string to a dense integer code in order of first appearance.
+ */
+class StringDictionary {
+public:
+	int32_t encode(const std::wstring& value) {
+		const auto inserted = mCodes.emplace(value, static_cast<int32_t>(mValues.size()));
+		if (inserted.second)
+			mValues.push_back(value);
+		return inserted.first->second;
+	}
+
+	const std::vector<std::wstring>& getValues() const {
+		return mValues;
+	}
+
+private:
+	std::unordered_map<std::wstring, int32_t> mCodes;
+	std::vector<std::wstring> mValues;
+};
+
+/**
+ * Report values of all rows (models) by key. Missing values are NaN for floats and -1 for bools and string codes,
+ * string values are dictionary encoded per key.
+ */
+struct ReportColumns {
+	template <typename T>
+	struct Column {
+		std::wstring key;
+		std::vector<T> values;
+	};
+	struct StringColumn {
+		std::wstring key;
+		std::vector<int32_t> codes;
+		StringDictionary dictionary;
+	};
+
+	std::vector<Column<int8_t>> bools;
+	std::vector<Column<double>> floats;
+	std::vector<StringColumn> strings;
+};
+
+/**
+ * One column per key in order of first appearance, if a key is reported more than once for a row the last value is
+ * kept. Rows may be null (no reports).
+ */
+ReportColumns buildReportColumns(const std::vector<const Reports*>& rows);
+
+} // namespace pcu
@@ -0,0 +1,45 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * CGA report values of one initial shape, kept natively until they are requested from Python or exported.
+ * Keys may repeat if the encoder reports more than once, later values take precedence.
+ */
+struct Reports {
+	std::vector<std::wstring> boolKeys;
+	std::vector<uint8_t> boolValues;
+	std::vector<std::wstring> floatKeys;
+	std::vector<double> floatValues;
+	std::vector<std::wstring> stringKeys;
+	std::vector<std::wstring> stringValues;
+
+	bool empty() const {
+		return boolKeys.empty() && floatKeys.empty() && stringKeys.empty();
+	}
+};
+
+} // namespace pcu
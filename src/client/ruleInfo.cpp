@@ -0,0 +1,282 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "ruleInfo.h"
+#include "logging.h"
+#include "rulePackage.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+const std::wstring DEFAULT_STYLE_PREFIX = L"Default$";
+const std::wstring RULE_FILE_EXTENSION = L".cgb";
+const wchar_t* ANNOT_START_RULE = L"@StartRule";
+
+template <typename F>
+std::vector<pcu::RuleAnnotation> readAnnotations(size_t count, F&& get) {
+	std::vector<pcu::RuleAnnotation> annotations(count);
+	for (size_t i = 0; i < count; i++) {
+		const prt::Annotation* an = get(i);
+		annotations[i].name = an->getName();
+		annotations[i].arguments.resize(an->getNumArguments());
+		for (size_t a = 0; a < an->getNumArguments(); a++) {
+			const prt::AnnotationArgument* arg = an->getArgument(a);
+			pcu::AnnotationArgument& argument = annotations[i].arguments[a];
+			argument.type = arg->getType();
+			if (arg->getKey() != nullptr)
+				argument.key = arg->getKey();
+			switch (argument.type) {
+				case prt::AAT_BOOL:
+					argument.boolValue = arg->getBool();
+					break;
+				case prt::AAT_FLOAT:
+					argument.floatValue = arg->getFloat();
+					break;
+				case prt::AAT_STR:
+					argument.stringValue = arg->getStr();
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	return annotations;
+}
+
+pcu::RuleEntry readEntry(const prt::RuleFileInfo::Entry& e) {
+	pcu::RuleEntry entry;
+	entry.name = e.getName();
+	entry.type = e.getReturnType();
+	entry.parameters.resize(e.getNumParameters());
+	for (size_t p = 0; p < e.getNumParameters(); p++) {
+		entry.parameters[p].name = e.getParameter(p)->getName();
+		entry.parameters[p].type = e.getParameter(p)->getType();
+	}
+	entry.annotations = readAnnotations(e.getNumAnnotations(), [&e](size_t i) { return e.getAnnotation(i); });
+	return entry;
+}
+
+bool endsWith(const std::wstring& s, const std::wstring& suffix) {
+	return s.size() >= suffix.size() && std::equal(suffix.rbegin(), suffix.rend(), s.rbegin());
+}
+
+} // namespace
+
+namespace pcu {
+
+bool RuleEntry::hasAnnotation(const wchar_t* annotationName) const {
+	return std::any_of(annotations.begin(), annotations.end(),
+	                   [annotationName](const RuleAnnotation& a) { return a.name == annotationName; });
+}
+
+const RuleEntry* RuleInfo::findAttribute(const std::wstring& name) const {
+	for (const std::wstring& candidate : {name, DEFAULT_STYLE_PREFIX + name}) {
+		const auto it = std::find_if(attributes.begin(), attributes.end(),
+		                             [&candidate](const RuleEntry& e) { return e.name == candidate; });
+		if (it != attributes.end())
+			return &*it;
+	}
+	return nullptr;
+}
+
+std::vector<std::wstring> RuleInfo::getStartRules() const {
+	std::vector<std::wstring> startRules;
+	for (const RuleEntry& rule : rules) {
+		if (rule.hasAnnotation(ANNOT_START_RULE))
+			startRules.push_back(rule.name);
+	}
+	return startRules;
+}
+
+RuleInfoPtr createRuleInfo(const prt::RuleFileInfo& info, const std::wstring& ruleFile) {
+	auto ruleInfo = std::make_shared<RuleInfo>();
+	ruleInfo->ruleFile = ruleFile;
+	for (size_t i = 0; i < info.getNumAttributes(); i++)
+		ruleInfo->attributes.push_back(readEntry(*info.getAttribute(i)));
+	for (size_t i = 0; i < info.getNumRules(); i++)
+		ruleInfo->rules.push_back(readEntry(*info.getRule(i)));
+	ruleInfo->annotations =
+	        readAnnotations(info.getNumAnnotations(), [&info](size_t i) { return info.getAnnotation(i); });
+	return ruleInfo;
+}
+
+std::wstring findRuleFile(const prt::ResolveMap& resolveMap) {
+	size_t keyCount = 0;
+	const wchar_t* const* keys = resolveMap.getKeys(&keyCount);
+	std::vector<std::wstring> ruleFiles;
+	for (size_t k = 0; k < keyCount; k++) {
+		if (endsWith(keys[k], RULE_FILE_EXTENSION))
+			ruleFiles.emplace_back(keys[k]);
+	}
+	if (ruleFiles.empty())
+		return {};
+	return *std::min_element(ruleFiles.begin(), ruleFiles.end());
+}
+
+RuleInfoPtr RuleInfoCache::get(const std::string& rulePackagePath, const std::wstring& ruleFile,
+                               const prt::ResolveMap* resolveMap, prt::Cache* cache) {
+	const auto key = std::make_pair(rulePackagePath, ruleFile);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto it = mEntries.find(key);
+		if (it != mEntries.end())
+			return it->second;
+	}
+
+	ResolveMapPtr ownResolveMap;
+	if (resolveMap == nullptr) {
+		prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+		ownResolveMap = loadResolveMap(rulePackagePath, &status);
+		if (!ownResolveMap || status != prt::STATUS_OK) {
+			LOG_ERR << "getting resolve map from '" << rulePackagePath << "' failed.";
+			return {};
+		}
+		resolveMap = ownResolveMap.get();
+	}
+
+	const std::wstring ruleFileKey = ruleFile.empty() ? findRuleFile(*resolveMap) : ruleFile;
+	prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+	const wchar_t* ruleFileURI = ruleFileKey.empty() ? nullptr : resolveMap->getString(ruleFileKey.c_str(), &status);
+	if (ruleFileURI == nullptr || status != prt::STATUS_OK) {
+		LOG_ERR << "rule file '" << ruleFileKey << "' not found in rule package " << rulePackagePath;
+		return {};
+	}
+
+	const RuleFileInfoPtr info(prt::createRuleFileInfo(ruleFileURI, cache, &status));
+	if (!info || status != prt::STATUS_OK) {
+		LOG_ERR << "could not read rule file info of " << ruleFileKey << ": " << prt::getStatusDescription(status);
+		return {};
+	}
+
+	RuleInfoPtr ruleInfo = createRuleInfo(*info, ruleFileKey);
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (ruleFile.empty())
+		mEntries.emplace(std::make_pair(rulePackagePath, ruleFileKey), ruleInfo);
+	return mEntries.emplace(key, std::move(ruleInfo)).first->second;
+}
+
+void RuleInfoCache::invalidate(const std::string& rulePackagePath) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto it = mEntries.begin(); it != mEntries.end();) {
+		if (it->first.first == rulePackagePath)
+			it = mEntries.erase(it);
+		else
+			++it;
+	}
+}
+
+void RuleInfoCache::clear() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.clear();
+}
+
+RuleInfoCache& getRuleInfoCache() {
+	static RuleInfoCache cache;
+	return cache;
+}
+
+std::wstring getTypeName(prt::AnnotationArgumentType type) {
+	switch (type) {
+		case prt::AAT_VOID:
+			return L"void";
+		case prt::AAT_BOOL:
+			return L"bool";
+		case prt::AAT_FLOAT:
+			return L"float";
+		case prt::AAT_STR:
+			return L"string";
+		case prt::AAT_INT:
+			return L"int";
+		case prt::AAT_BOOL_ARRAY:
+			return L"bool[]";
+		case prt::AAT_FLOAT_ARRAY:
+			return L"float[]";
+		case prt::AAT_STR_ARRAY:
+			return L"string[]";
+		default:
+			return L"unknown";
+	}
+}
+
+AttributeMapPtr coerceAttributeTypes(const prt::AttributeMap& attributes, const RuleInfo& info,
+                                     std::vector<std::wstring>& mismatches) {
+	const AttributeMapBuilderPtr builder(prt::AttributeMapBuilder::createFromAttributeMap(&attributes));
+
+	size_t keyCount = 0;
+	const wchar_t* const* keys = attributes.getKeys(&keyCount);
+	for (size_t k = 0; k < keyCount; k++) {
+		const wchar_t* key = keys[k];
+		const RuleEntry* attribute = info.findAttribute(key);
+		if (attribute == nullptr)
+			continue;
+
+		const prt::AttributeMap::PrimitiveType valueType = attributes.getType(key);
+		bool matches = true;
+		switch (attribute->type) {
+			case prt::AAT_FLOAT:
+				if (valueType == prt::AttributeMap::PT_INT)
+					builder->setFloat(key, attributes.getInt(key));
+				else
+					matches = (valueType == prt::AttributeMap::PT_FLOAT);
+				break;
+			case prt::AAT_BOOL:
+				if (valueType == prt::AttributeMap::PT_INT)
+					builder->setBool(key, attributes.getInt(key) != 0);
+				else
+					matches = (valueType == prt::AttributeMap::PT_BOOL);
+				break;
+			case prt::AAT_STR:
+				matches = (valueType == prt::AttributeMap::PT_STRING);
+				break;
+			case prt::AAT_FLOAT_ARRAY:
+				if (valueType == prt::AttributeMap::PT_INT_ARRAY) {
+					size_t count = 0;
+					const int32_t* values = attributes.getIntArray(key, &count);
+					const std::vector<double> converted(values, values + count);
+					builder->setFloatArray(key, converted.data(), converted.size());
+				}
+				else
+					matches = (valueType == prt::AttributeMap::PT_FLOAT_ARRAY);
+				break;
+			case prt::AAT_BOOL_ARRAY:
+				if (valueType == prt::AttributeMap::PT_INT_ARRAY) {
+					size_t count = 0;
+					const int32_t* values = attributes.getIntArray(key, &count);
+					const std::unique_ptr<bool[]> converted(new bool[count]);
+					std::transform(values, values + count, converted.get(), [](int32_t v) { return v != 0; });
+					builder->setBoolArray(key, converted.get(), count);
+				}
+				else
+					matches = (valueType == prt::AttributeMap::PT_BOOL_ARRAY);
+				break;
+			case prt::AAT_STR_ARRAY:
+				matches = (valueType == prt::AttributeMap::PT_STRING_ARRAY);
+				break;
+			default:
+				break;
+		}
+		if (!matches)
+			mismatches.emplace_back(key);
+	}
+	return AttributeMapPtr(builder->createAttributeMap());
+}
+
+} // namespace pcu
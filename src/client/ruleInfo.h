@@ -0,0 +1,121 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "utils.h"
+
+#include "prt/API.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pcu {
+
+struct AnnotationArgument {
+	std::wstring key; // empty for positional arguments
+	prt::AnnotationArgumentType type = prt::AAT_UNKNOWN;
+	bool boolValue = false;
+	double floatValue = 0.0;
+	std::wstring stringValue;
+};
+
+struct RuleAnnotation {
+	std::wstring name; // including the '@', e.g. "@Range"
+	std::vector<AnnotationArgument> arguments;
+};
+
+struct RuleParameter {
+	std::wstring name;
+	prt::AnnotationArgumentType type = prt::AAT_UNKNOWN;
+};
+
+/**
+ * attribute or rule of a rule file, names are fully qualified with the style (e.g. "Default$height")
+ */
+struct RuleEntry {
+	std::wstring name;
+	prt::AnnotationArgumentType type = prt::AAT_UNKNOWN; // return type
+	std::vector<RuleParameter> parameters;
+	std::vector<RuleAnnotation> annotations;
+
+	bool hasAnnotation(const wchar_t* annotationName) const;
+};
+
+/**
+ * plain copy of a prt::RuleFileInfo which stays valid independently of the PRT objects it was read from
+ */
+struct RuleInfo {
+	std::wstring ruleFile; // resolve map key of the compiled rule file, e.g. "bin/rule.cgb"
+	std::vector<RuleEntry> attributes;
+	std::vector<RuleEntry> rules;
+	std::vector<RuleAnnotation> annotations; // annotations of the rule file itself
+
+	// looks up the name as given and with the default style prefix ("height" finds "Default$height")
+	const RuleEntry* findAttribute(const std::wstring& name) const;
+	std::vector<std::wstring> getStartRules() const;
+};
+
+using RuleInfoPtr = std::shared_ptr<const RuleInfo>;
+
+RuleInfoPtr createRuleInfo(const prt::RuleFileInfo& info, const std::wstring& ruleFile);
+
+/**
+ * Returns the resolve map key of the compiled rule file of a rule package, the first one in key order if there are
+ * several. Returns an empty string if there is none.
+ */
+std::wstring findRuleFile(const prt::ResolveMap& resolveMap);
+
+/**
+ * Rule infos keyed by rule package and rule file. Reading the rule info requires the rule file to be decoded by PRT,
+ * this is only done on the first request for each pair. Thread-safe.
+ */
+class RuleInfoCache {
+public:
+	/**
+	 * An empty rule file selects the one found by findRuleFile. If no resolve map is given, one is created for the
+	 * rule package on a cache miss. Returns a null pointer (and logs the reason) if the rule info cannot be read.
+	 */
+	RuleInfoPtr get(const std::string& rulePackagePath, const std::wstring& ruleFile, const prt::ResolveMap* resolveMap,
+	                prt::Cache* cache);
+	void invalidate(const std::string& rulePackagePath);
+	void clear();
+
+private:
+	std::mutex mMutex;
+	std::map<std::pair<std::string, std::wstring>, RuleInfoPtr> mEntries;
+};
+
+RuleInfoCache& getRuleInfoCache();
+
+std::wstring getTypeName(prt::AnnotationArgumentType type);
+
+/**
+ * Returns a copy of the attributes with the values converted to the types declared by the rule, i.e. ints (also in
+ * arrays) are passed as floats or bools. Keys which are not rule attributes are copied unchanged. Values which cannot
+ * be converted (e.g. a string for a float attribute) are copied unchanged as well and their keys added to mismatches.
+ */
+AttributeMapPtr coerceAttributeTypes(const prt::AttributeMap& attributes, const RuleInfo& info,
+                                     std::vector<std::wstring>& mismatches);
+
+} // namespace pcu
@@ -0,0 +1,347 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "rulePackage.h"
+#include "logging.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cwctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// resolve map keys and the file paths relative to the extraction directory, tab separated, UTF-8 (not percent-encoded)
+const char* MANIFEST_FILE = "resolvemap.txt";
+
+std::string toGeneric(const fs::path& p) {
+	return pcu::toUTF8FromOSNarrow(p.generic_string());
+}
+
+fs::path fromUTF8(const std::string& s) {
+	return fs::u8path(s);
+}
+
+std::vector<std::pair<std::string, std::string>> readManifest(const fs::path& path) {
+	std::ifstream in(path, std::ios::binary);
+	std::vector<std::pair<std::string, std::string>> entries;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		const size_t tab = line.find('\t');
+		if (tab != std::string::npos)
+			entries.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+	}
+	return entries;
+}
+
+// every regular file with its path relative to the directory as key
+std::vector<std::pair<std::string, std::string>> listDirectory(const fs::path& directory) {
+	std::vector<std::pair<std::string, std::string>> entries;
+	for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+		if (!entry.is_regular_file())
+			continue;
+		const std::string relativePath = toGeneric(fs::relative(entry.path(), directory));
+		entries.emplace_back(relativePath, relativePath);
+	}
+	return entries;
+}
+
+pcu::ResolveMapPtr loadResolveMapFromDirectory(const fs::path& directory, prt::Status* status) {
+	const fs::path manifest = directory / MANIFEST_FILE;
+	const auto entries = fs::exists(manifest) ? readManifest(manifest) : listDirectory(directory);
+
+	const pcu::ResolveMapBuilderPtr builder{prt::ResolveMapBuilder::create()};
+	for (const auto& e : entries) {
+		const std::wstring key = pcu::toUTF16FromUTF8(e.first);
+		const std::string uri = pcu::toFileURI((directory / fromUTF8(e.second)).string());
+		builder->addEntry(key.c_str(), pcu::toUTF16FromUTF8(uri).c_str());
+	}
+	return pcu::ResolveMapPtr{builder->createResolveMap(status)};
+}
+
+std::string percentDecode(const std::string& s) {
+	std::string decoded;
+	decoded.reserve(s.size());
+	for (size_t i = 0; i < s.size(); i++) {
+		if (s[i] == '%' && i + 2 < s.size() && std::isxdigit(s[i + 1]) && std::isxdigit(s[i + 2])) {
+			decoded.push_back(static_cast<char>(std::stoi(s.substr(i + 1, 2), nullptr, 16)));
+			i += 2;
+		}
+		else
+			decoded.push_back(s[i]);
+	}
+	return decoded;
+}
+
+enum class AssetType { RULE_FILE, GEOMETRY, TEXTURE, OTHER };
+
+AssetType getAssetType(const std::wstring& key) {
+	const size_t dot = key.find_last_of(L'.');
+	if (dot == std::wstring::npos)
+		return AssetType::OTHER;
+	std::wstring extension = key.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
+
+	if (extension == L"cgb")
+		return AssetType::RULE_FILE;
+	for (const wchar_t* e : {L"obj", L"fbx", L"dae", L"gltf", L"glb"}) {
+		if (extension == e)
+			return AssetType::GEOMETRY;
+	}
+	for (const wchar_t* e : {L"jpg", L"jpeg", L"png", L"tif", L"tiff", L"tga", L"bmp", L"gif"}) {
+		if (extension == e)
+			return AssetType::TEXTURE;
+	}
+	return AssetType::OTHER;
+}
+
+prt::Status prefetchAsset(AssetType type, const wchar_t* uri, const prt::ResolveMap& resolveMap,
+                          prt::CacheObject& cache) {
+	prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+	switch (type) {
+		case AssetType::RULE_FILE: {
+			const pcu::RuleFileInfoPtr info{prt::createRuleFileInfo(uri, &cache, &status)};
+			break;
+		}
+		case AssetType::GEOMETRY: {
+			const pcu::InitialShapeBuilderPtr builder{prt::InitialShapeBuilder::create()};
+			status = builder->resolveGeometry(uri, &resolveMap, &cache);
+			break;
+		}
+		case AssetType::TEXTURE: {
+			const pcu::AttributeMapPtr metadata{prt::createTextureMetadata(uri, &cache, &status)};
+			break;
+		}
+		default:
+			status = prt::STATUS_OK;
+			break;
+	}
+	return status;
+}
+
+std::string getRandomSuffix() {
+	std::random_device rd;
+	char buffer[17];
+	std::snprintf(buffer, sizeof(buffer), "%08x%08x", rd(), rd());
+	return buffer;
+}
+
+} // namespace
+
+namespace pcu {
+
+std::string hashFileContent(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		throw std::runtime_error("cannot open " + path);
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	std::vector<char> buffer(1 << 20);
+	while (in) {
+		in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		const size_t n = static_cast<size_t>(in.gcount());
+		for (size_t i = 0; i < n; i++) {
+			hash ^= static_cast<uint8_t>(buffer[i]);
+			hash *= 0x100000001b3ull;
+		}
+	}
+	if (in.bad())
+		throw std::runtime_error("cannot read " + path);
+
+	char hex[17];
+	std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+	return hex;
+}
+
+ResolveMapPtr loadResolveMap(const std::string& rulePackagePath, prt::Status* status) {
+	if (fs::is_directory(rulePackagePath))
+		return loadResolveMapFromDirectory(rulePackagePath, status);
+
+	const std::string u8rpkURI = toFileURI(rulePackagePath);
+	return ResolveMapPtr{prt::createResolveMap(toUTF16FromUTF8(u8rpkURI).c_str(), nullptr, status)};
+}
+
+std::string extractRulePackage(const std::string& rulePackagePath, const std::string& cacheDirectory) {
+	const fs::path rpk(rulePackagePath);
+	const fs::path target = fs::path(cacheDirectory) / (rpk.stem().string() + "-" + hashFileContent(rulePackagePath));
+	if (fs::exists(target / MANIFEST_FILE))
+		return target.string();
+
+	fs::create_directories(cacheDirectory);
+	const fs::path unpackDirectory = target.string() + ".tmp-" + getRandomSuffix();
+	fs::create_directories(unpackDirectory);
+
+	try {
+		prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
+		const std::wstring rpkURI = toUTF16FromUTF8(toFileURI(rulePackagePath));
+		const std::wstring unpackPath = unpackDirectory.wstring();
+		const ResolveMapPtr resolveMap{prt::createResolveMap(rpkURI.c_str(), unpackPath.c_str(), &status)};
+		if (!resolveMap || status != prt::STATUS_OK)
+			throw std::runtime_error(std::string("cannot unpack rule package: ") + prt::getStatusDescription(status));
+
+		// the unpacked files are referenced relative to the directory so that it can be moved into place
+		const std::wstring unpackURI = toUTF16FromUTF8(toFileURI(unpackDirectory.string())) + L"/";
+		std::ofstream manifest(unpackDirectory / MANIFEST_FILE, std::ios::binary);
+		size_t keyCount = 0;
+		const wchar_t* const* keys = resolveMap->getKeys(&keyCount);
+		size_t entryCount = 0;
+		for (size_t k = 0; k < keyCount; k++) {
+			const std::wstring uri = resolveMap->getString(keys[k]);
+			std::string relativePath;
+			if (uri.compare(0, unpackURI.size(), unpackURI) == 0)
+				relativePath = percentDecode(toUTF8FromUTF16(uri.substr(unpackURI.size())));
+			else if (fs::is_regular_file(unpackDirectory / fs::path(keys[k])))
+				relativePath = toUTF8FromUTF16(keys[k]);
+			else {
+				LOG_WRN << "resolve map entry " << keys[k] << " is not part of the unpacked files, skipping it";
+				continue;
+			}
+			manifest << toUTF8FromUTF16(keys[k]) << '\t' << relativePath << '\n';
+			entryCount++;
+		}
+		manifest.close();
+		if (!manifest)
+			throw std::runtime_error("cannot write the manifest of " + unpackDirectory.string());
+		if (entryCount == 0 && keyCount > 0)
+			throw std::runtime_error("the rule package was not unpacked to " + unpackDirectory.string());
+
+		std::error_code ec;
+		fs::rename(unpackDirectory, target, ec);
+		if (ec) {
+			// another process was faster, its extraction is used
+			if (!fs::exists(target / MANIFEST_FILE))
+				throw std::runtime_error("cannot move the extracted rule package to " + target.string());
+			fs::remove_all(unpackDirectory, ec);
+		}
+	}
+	catch (...) {
+		std::error_code ec;
+		fs::remove_all(unpackDirectory, ec);
+		throw;
+	}
+	return target.string();
+}
+
+RulePackageVersionPtr loadRulePackageVersion(const std::string& rulePackagePath, prt::Status* status) {
+	auto version = std::make_shared<RulePackageVersion>();
+	version->path = rulePackagePath;
+	if (!fs::is_directory(rulePackagePath)) {
+		std::error_code ec;
+		version->fileSize = fs::file_size(rulePackagePath, ec);
+		version->writeTime = fs::last_write_time(rulePackagePath, ec);
+		try {
+			version->contentHash = hashFileContent(rulePackagePath);
+		}
+		catch (const std::exception& e) {
+			LOG_ERR << e.what();
+			if (status != nullptr)
+				*status = prt::STATUS_FILE_NOT_FOUND;
+			return {};
+		}
+	}
+
+	version->resolveMap = loadResolveMap(rulePackagePath, status);
+	if (!version->resolveMap)
+		return {};
+	return version;
+}
+
+bool isRulePackageModified(RulePackageVersion& version) {
+	if (version.contentHash.empty())
+		return false;
+
+	std::error_code ec;
+	const uintmax_t fileSize = fs::file_size(version.path, ec);
+	const fs::file_time_type writeTime = fs::last_write_time(version.path, ec);
+	if (ec) // e.g. replaced by a rename right now, checked again next time
+		return false;
+	if (fileSize == version.fileSize && writeTime == version.writeTime)
+		return false;
+
+	std::string contentHash;
+	try {
+		contentHash = hashFileContent(version.path);
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	if (contentHash != version.contentHash)
+		return true;
+	version.fileSize = fileSize;
+	version.writeTime = writeTime;
+	return false;
+}
+
+void flushCacheEntries(prt::CacheObject& cache, const prt::ResolveMap& resolveMap) {
+	size_t keyCount = 0;
+	const wchar_t* const* keys = resolveMap.getKeys(&keyCount);
+	for (size_t k = 0; k < keyCount; k++) {
+		const wchar_t* uri = resolveMap.getString(keys[k]);
+		if (uri != nullptr)
+			cache.flushEntry(uri);
+	}
+}
+
+AssetPrefetchStats prefetchAssets(const prt::ResolveMap& resolveMap, prt::CacheObject& cache) {
+	const auto start = std::chrono::steady_clock::now();
+
+	size_t keyCount = 0;
+	const wchar_t* const* keys = resolveMap.getKeys(&keyCount);
+	std::vector<AssetType> types(keyCount);
+	std::vector<const wchar_t*> uris(keyCount);
+	AssetPrefetchStats stats;
+	for (size_t k = 0; k < keyCount; k++) {
+		types[k] = getAssetType(keys[k]);
+		uris[k] = resolveMap.getString(keys[k]);
+		stats.ruleFileCount += (types[k] == AssetType::RULE_FILE) ? 1 : 0;
+		stats.geometryCount += (types[k] == AssetType::GEOMETRY) ? 1 : 0;
+		stats.textureCount += (types[k] == AssetType::TEXTURE) ? 1 : 0;
+		stats.skippedCount += (types[k] == AssetType::OTHER) ? 1 : 0;
+	}
+
+	std::vector<prt::Status> status(keyCount, prt::STATUS_OK);
+	parallelFor(keyCount, [&](size_t k) {
+		if (types[k] == AssetType::OTHER)
+			return;
+		status[k] = (uris[k] == nullptr) ? prt::STATUS_KEY_NOT_FOUND
+		                                 : prefetchAsset(types[k], uris[k], resolveMap, cache);
+	});
+
+	for (size_t k = 0; k < keyCount; k++) {
+		if (status[k] != prt::STATUS_OK)
+			stats.errors.emplace_back(keys[k], prt::getStatusDescription(status[k]));
+	}
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+} // namespace pcu
@@ -0,0 +1,102 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "utils.h"
+
+#include "prt/API.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * 64-bit FNV-1a hash of the file content as 16 hex digits, throws std::runtime_error if the file cannot be read
+ */
+std::string hashFileContent(const std::string& path);
+
+/**
+ * Creates the resolve map of a rule package. The path is either an RPK file or a directory with the extracted content
+ * of one. A directory written by extractRulePackage contains a manifest with the original resolve map keys, for other
+ * directories every file is added with its relative path as key. Returns a null pointer on failure.
+ */
+ResolveMapPtr loadResolveMap(const std::string& rulePackagePath, prt::Status* status = nullptr);
+
+/**
+ * Extracts an RPK once into the content-addressed directory <cacheDirectory>/<RPK name>-<content hash> and returns
+ * its path, an existing extraction is reused. Several processes can extract the same RPK concurrently: each unpacks
+ * into a private temporary directory which is then renamed into place, the first rename wins. Throws
+ * std::runtime_error if the RPK cannot be unpacked.
+ */
+std::string extractRulePackage(const std::string& rulePackagePath, const std::string& cacheDirectory);
+
+/**
+ * One loaded version of a rule package. Generations hold on to the version they started with, so a reload never
+ * pulls the resolve map from under them. Directories are content-addressed extractions (see extractRulePackage) and
+ * are never reported as modified.
+ */
+struct RulePackageVersion {
+	std::string path;
+	std::string contentHash; // empty for directories
+	uintmax_t fileSize = 0;
+	std::filesystem::file_time_type writeTime;
+	ResolveMapPtr resolveMap;
+};
+using RulePackageVersionPtr = std::shared_ptr<RulePackageVersion>;
+
+/**
+ * Loads the resolve map and records the content hash of the rule package, returns a null pointer on failure.
+ */
+RulePackageVersionPtr loadRulePackageVersion(const std::string& rulePackagePath, prt::Status* status = nullptr);
+
+/**
+ * True if the content of the rule package differs from the loaded version. The file is only hashed if its size or
+ * modification time changed, if the content turns out to be the same these are updated on the version.
+ */
+bool isRulePackageModified(RulePackageVersion& version);
+
+/**
+ * Removes the entries of all URIs of the resolve map (rule files, assets) from the cache, entries of other rule
+ * packages stay cached.
+ */
+void flushCacheEntries(prt::CacheObject& cache, const prt::ResolveMap& resolveMap);
+
+struct AssetPrefetchStats {
+	size_t ruleFileCount = 0;
+	size_t geometryCount = 0;
+	size_t textureCount = 0;
+	size_t skippedCount = 0; // entries of other types (e.g. CGA sources or data files)
+	double seconds = 0.0;
+	std::vector<std::pair<std::wstring, std::string>> errors; // resolve map key, status description
+};
+
+/**
+ * Resolves the rule files, geometry and texture assets of the resolve map into the cache on a pool of worker threads,
+ * so that the first generations do not pay for it. Rule files and geometries are fully decoded, for textures the
+ * metadata is read. Failures are collected, nothing is logged from the workers.
+ */
+AssetPrefetchStats prefetchAssets(const prt::ResolveMap& resolveMap, prt::CacheObject& cache);
+
+} // namespace pcu
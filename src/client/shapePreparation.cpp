@@ -0,0 +1,507 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "shapePreparation.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using Vec3 = std::array<double, 3>;
+
+// faces with more vertices are not checked for self-intersections (quadratic test)
+const size_t MAX_INTERSECTION_TEST_VERTICES = 4096;
+
+Vec3 getVertex(const pcu::MeshView& shape, uint32_t index) {
+	const double* v = shape.vertices + 3 * size_t(index);
+	return {v[0], v[1], v[2]};
+}
+
+bool isFinite(const Vec3& v) {
+	return std::isfinite(v[0]) && std::isfinite(v[1]) && std::isfinite(v[2]);
+}
+
+double squaredDistance(const Vec3& a, const Vec3& b) {
+	const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+// Newell's method, the length of the result is twice the face area
+Vec3 computeNormal(const std::vector<Vec3>& face) {
+	Vec3 n = {0.0, 0.0, 0.0};
+	for (size_t i = 0; i < face.size(); i++) {
+		const Vec3& a = face[i];
+		const Vec3& b = face[(i + 1) % face.size()];
+		n[0] += (a[1] - b[1]) * (a[2] + b[2]);
+		n[1] += (a[2] - b[2]) * (a[0] + b[0]);
+		n[2] += (a[0] - b[0]) * (a[1] + b[1]);
+	}
+	return n;
+}
+
+double orientation(const double* a, const double* b, const double* c) {
+	return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+bool onSegment(const double* a, const double* b, const double* p) {
+	return std::min(a[0], b[0]) <= p[0] && p[0] <= std::max(a[0], b[0]) && std::min(a[1], b[1]) <= p[1] &&
+	       p[1] <= std::max(a[1], b[1]);
+}
+
+bool segmentsIntersect(const double* a, const double* b, const double* c, const double* d) {
+	const double o1 = orientation(a, b, c);
+	const double o2 = orientation(a, b, d);
+	const double o3 = orientation(c, d, a);
+	const double o4 = orientation(c, d, b);
+	if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0)))
+		return true;
+	return (o1 == 0 && onSegment(a, b, c)) || (o2 == 0 && onSegment(a, b, d)) || (o3 == 0 && onSegment(c, d, a)) ||
+	       (o4 == 0 && onSegment(c, d, b));
+}
+
+/**
+ * tests all pairs of non-adjacent edges in the projection onto the plane most perpendicular to the normal
+ */
+bool isSelfIntersecting(const std::vector<Vec3>& face, const Vec3& normal) {
+	const size_t n = face.size();
+	if (n < 4 || n > MAX_INTERSECTION_TEST_VERTICES)
+		return false;
+
+	const Vec3 an = {std::abs(normal[0]), std::abs(normal[1]), std::abs(normal[2])};
+	const size_t dropAxis = (an[0] >= an[1] && an[0] >= an[2]) ? 0 : (an[1] >= an[2] ? 1 : 2);
+	const size_t u = (dropAxis + 1) % 3, v = (dropAxis + 2) % 3;
+
+	std::vector<double> p(2 * n);
+	for (size_t i = 0; i < n; i++) {
+		p[2 * i] = face[i][u];
+		p[2 * i + 1] = face[i][v];
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		const double* a = &p[2 * i];
+		const double* b = &p[2 * ((i + 1) % n)];
+		for (size_t j = i + 2; j < n; j++) {
+			if (i == 0 && j == n - 1)
+				continue; // adjacent via the closing edge
+			const double* c = &p[2 * j];
+			const double* d = &p[2 * ((j + 1) % n)];
+			if (segmentsIntersect(a, b, c, d))
+				return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * removes vertices which are no longer referenced by a face, keeps the order of the remaining ones
+ */
+void compactVertices(pcu::ShapeGeometry& g) {
+	const size_t vertexCount = g.getVertexCount();
+	std::vector<uint32_t> newIndex(vertexCount, 0);
+	for (uint32_t i : g.indices)
+		newIndex[i] = 1;
+
+	uint32_t next = 0;
+	for (size_t v = 0; v < vertexCount; v++) {
+		if (newIndex[v] == 0)
+			continue;
+		newIndex[v] = next;
+		std::copy_n(g.vertices.begin() + 3 * v, 3, g.vertices.begin() + 3 * size_t(next));
+		next++;
+	}
+	g.vertices.resize(3 * size_t(next));
+	for (uint32_t& i : g.indices)
+		i = newIndex[i];
+}
+
+double squaredSegmentDistance(const double* p, const double* a, const double* b) {
+	const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	const double ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+	const double len2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+	double t = (len2 > 0.0) ? (ap[0] * ab[0] + ap[1] * ab[1] + ap[2] * ab[2]) / len2 : 0.0;
+	t = std::max(0.0, std::min(1.0, t));
+	const double d[3] = {ap[0] - t * ab[0], ap[1] - t * ab[1], ap[2] - t * ab[2]};
+	return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+}
+
+/**
+ * Marks the vertices of the open chain ring[first..last] (positions modulo ring size) to keep. Iterative to avoid deep
+ * recursion on long rings.
+ */
+void simplifyChain(const pcu::MeshView& shape, const uint32_t* ring, size_t n, size_t first, size_t last,
+                   double tolerance2, std::vector<uint8_t>& keep, std::vector<std::pair<size_t, size_t>>& stack) {
+	stack.clear();
+	stack.emplace_back(first, last);
+	while (!stack.empty()) {
+		const size_t a = stack.back().first;
+		const size_t b = stack.back().second;
+		stack.pop_back();
+
+		const double* pa = shape.vertices + 3 * size_t(ring[a % n]);
+		const double* pb = shape.vertices + 3 * size_t(ring[b % n]);
+		double maxDistance2 = -1.0;
+		size_t farthest = a;
+		for (size_t i = a + 1; i < b; i++) {
+			const double d2 = squaredSegmentDistance(shape.vertices + 3 * size_t(ring[i % n]), pa, pb);
+			if (d2 > maxDistance2) {
+				maxDistance2 = d2;
+				farthest = i;
+			}
+		}
+		if (maxDistance2 > tolerance2) {
+			keep[farthest % n] = 1;
+			stack.emplace_back(a, farthest);
+			stack.emplace_back(farthest, b);
+		}
+	}
+}
+
+} // namespace
+
+namespace pcu {
+
+std::vector<std::string> ShapeDiagnostics::getIssueNames(uint32_t issues) {
+	static const std::pair<Issue, const char*> NAMES[] = {{INVALID_INDICES, "invalid_indices"},
+	                                                      {NON_FINITE_VERTICES, "non_finite_vertices"},
+	                                                      {DUPLICATE_VERTICES, "duplicate_vertices"},
+	                                                      {DEGENERATE_FACES, "degenerate_faces"},
+	                                                      {WRONG_WINDING, "wrong_winding"},
+	                                                      {SELF_INTERSECTIONS, "self_intersections"}};
+	std::vector<std::string> names;
+	for (const auto& n : NAMES) {
+		if ((issues & n.first) != 0)
+			names.push_back(n.second);
+	}
+	return names;
+}
+
+ShapeDiagnostics validateShape(const MeshView& shape, const PreparationOptions& options, ShapeGeometry& repaired,
+                               bool& modified) {
+	ShapeDiagnostics d;
+	d.checked = true;
+	modified = false;
+
+	size_t countSum = 0;
+	for (size_t f = 0; f < shape.faceCount; f++)
+		countSum += shape.faceCounts[f];
+	if (countSum != shape.indexCount) {
+		d.issues |= ShapeDiagnostics::INVALID_INDICES;
+		return d; // the face structure is unknown, nothing else can be checked
+	}
+
+	const double minDistance2 = options.tolerance * options.tolerance;
+	const size_t vertexCount = shape.getVertexCount();
+
+	ShapeGeometry out;
+	if (options.repair) {
+		out.vertices.assign(shape.vertices, shape.vertices + shape.vertexCoordCount);
+		out.indices.reserve(shape.indexCount);
+		out.faceCounts.reserve(shape.faceCount);
+	}
+
+	std::vector<uint32_t> faceIndices;
+	std::vector<Vec3> face;
+	size_t offset = 0;
+	for (size_t f = 0; f < shape.faceCount; offset += shape.faceCounts[f], f++) {
+		const uint32_t* idx = shape.indices + offset;
+		const size_t n = shape.faceCounts[f];
+
+		// structurally broken faces can only be dropped
+		uint32_t faceIssues = 0;
+		for (size_t i = 0; i < n; i++) {
+			if (idx[i] >= vertexCount)
+				faceIssues |= ShapeDiagnostics::INVALID_INDICES;
+			else if (!isFinite(getVertex(shape, idx[i])))
+				faceIssues |= ShapeDiagnostics::NON_FINITE_VERTICES;
+		}
+		if (faceIssues != 0) {
+			d.issues |= faceIssues;
+			d.removedFaces++;
+			d.removedVertices += n;
+			continue;
+		}
+
+		// merge consecutive duplicates, including the last vertex repeating the first one
+		faceIndices.clear();
+		face.clear();
+		for (size_t i = 0; i < n; i++) {
+			const Vec3 v = getVertex(shape, idx[i]);
+			if (!face.empty() && squaredDistance(face.back(), v) <= minDistance2)
+				continue;
+			faceIndices.push_back(idx[i]);
+			face.push_back(v);
+		}
+		while (face.size() > 1 && squaredDistance(face.front(), face.back()) <= minDistance2) {
+			faceIndices.pop_back();
+			face.pop_back();
+		}
+		if (face.size() < n) {
+			d.issues |= ShapeDiagnostics::DUPLICATE_VERTICES;
+			d.removedVertices += n - face.size();
+		}
+
+		const Vec3 normal = computeNormal(face);
+		const double area2 = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (face.size() < 3 || area2 <= 2.0 * minDistance2) {
+			d.issues |= ShapeDiagnostics::DEGENERATE_FACES;
+			d.removedFaces++;
+			d.removedVertices += face.size();
+			continue;
+		}
+
+		if (isSelfIntersecting(face, normal))
+			d.issues |= ShapeDiagnostics::SELF_INTERSECTIONS;
+
+		const bool downward =
+		        normal[1] < 0.0 && -normal[1] >= std::abs(normal[0]) && -normal[1] >= std::abs(normal[2]);
+		if (downward) {
+			d.issues |= ShapeDiagnostics::WRONG_WINDING;
+			d.flippedFaces++;
+		}
+
+		if (options.repair) {
+			if (downward)
+				std::reverse(faceIndices.begin(), faceIndices.end());
+			out.indices.insert(out.indices.end(), faceIndices.begin(), faceIndices.end());
+			out.faceCounts.push_back(static_cast<uint32_t>(faceIndices.size()));
+		}
+	}
+
+	const uint32_t repairable = ShapeDiagnostics::INVALID_INDICES | ShapeDiagnostics::NON_FINITE_VERTICES |
+	                            ShapeDiagnostics::DUPLICATE_VERTICES | ShapeDiagnostics::DEGENERATE_FACES |
+	                            ShapeDiagnostics::WRONG_WINDING;
+	if (options.repair && (d.issues & repairable) != 0 && !out.faceCounts.empty()) {
+		d.repaired = d.issues & repairable;
+		compactVertices(out);
+		repaired = std::move(out);
+		modified = true;
+	}
+	else {
+		d.removedVertices = 0;
+		d.removedFaces = 0;
+		d.flippedFaces = 0;
+	}
+	return d;
+}
+
+size_t simplifyShape(const MeshView& shape, double tolerance, ShapeGeometry& simplified) {
+	const size_t vertexCount = shape.getVertexCount();
+
+	// vertices used by more than one face are anchors
+	std::vector<uint8_t> useCount(vertexCount, 0);
+	for (size_t i = 0; i < shape.indexCount; i++) {
+		if (shape.indices[i] >= vertexCount)
+			return 0; // not simplifying broken input, see validateShape()
+		uint8_t& c = useCount[shape.indices[i]];
+		c = static_cast<uint8_t>(std::min(c + 1, 2));
+	}
+
+	const double tolerance2 = tolerance * tolerance;
+	ShapeGeometry out;
+	out.indices.reserve(shape.indexCount);
+	out.faceCounts.reserve(shape.faceCount);
+	std::vector<uint8_t> keep;
+	std::vector<size_t> anchors;
+	std::vector<std::pair<size_t, size_t>> stack;
+	size_t removed = 0;
+
+	size_t offset = 0;
+	for (size_t f = 0; f < shape.faceCount; offset += shape.faceCounts[f], f++) {
+		const uint32_t* ring = shape.indices + offset;
+		const size_t n = shape.faceCounts[f];
+		if (offset + n > shape.indexCount)
+			return 0;
+
+		keep.assign(n, 0);
+		anchors.clear();
+		for (size_t i = 0; i < n; i++) {
+			if (useCount[ring[i]] > 1) {
+				keep[i] = 1;
+				anchors.push_back(i);
+			}
+		}
+		if (n > 3) {
+			if (anchors.empty()) { // split the ring at vertex 0 and the vertex farthest from it
+				const double* p0 = shape.vertices + 3 * size_t(ring[0]);
+				size_t farthest = 0;
+				double maxDistance2 = -1.0;
+				for (size_t i = 1; i < n; i++) {
+					const double* p = shape.vertices + 3 * size_t(ring[i]);
+					const double d2 = (p[0] - p0[0]) * (p[0] - p0[0]) + (p[1] - p0[1]) * (p[1] - p0[1]) +
+					                  (p[2] - p0[2]) * (p[2] - p0[2]);
+					if (d2 > maxDistance2) {
+						maxDistance2 = d2;
+						farthest = i;
+					}
+				}
+				anchors = {0, farthest};
+				keep[0] = keep[farthest] = 1;
+			}
+			for (size_t a = 0; a < anchors.size(); a++) {
+				const size_t first = anchors[a];
+				const size_t last = (a + 1 < anchors.size()) ? anchors[a + 1] : anchors[0] + n;
+				simplifyChain(shape, ring, n, first, last, tolerance2, keep, stack);
+			}
+		}
+		else
+			keep.assign(n, 1);
+
+		size_t kept = 0;
+		for (size_t i = 0; i < n; i++)
+			kept += keep[i];
+		if (kept < 3) // keep the face unchanged rather than collapsing it
+			keep.assign(n, 1), kept = n;
+
+		for (size_t i = 0; i < n; i++) {
+			if (keep[i])
+				out.indices.push_back(ring[i]);
+		}
+		out.faceCounts.push_back(static_cast<uint32_t>(kept));
+		removed += n - kept;
+	}
+
+	if (removed > 0) {
+		out.vertices.assign(shape.vertices, shape.vertices + shape.vertexCoordCount);
+		compactVertices(out);
+		simplified = std::move(out);
+	}
+	return removed;
+}
+
+PreparedShapes prepareShapes(const std::vector<MeshView>& shapes, const PreparationOptions& options) {
+	PreparedShapes prepared;
+	prepared.diagnostics.resize(shapes.size());
+	prepared.geometries.resize(shapes.size());
+	prepared.modified.resize(shapes.size(), 0);
+
+	const bool transformStage = options.hasTransform || options.recenter != Recentering::NONE;
+	std::vector<double> bounds; // xz bounding box per shape for the recentering: minX, minZ, maxX, maxZ
+	if (options.recenter != Recentering::NONE) {
+		prepared.offsets.resize(3 * shapes.size(), 0.0);
+		bounds.resize(4 * shapes.size(), std::numeric_limits<double>::quiet_NaN());
+	}
+
+	parallelFor(
+	        shapes.size(),
+	        [&](size_t i) {
+		        if (shapes[i].vertices == nullptr)
+			        return;
+
+		        ShapeDiagnostics& diagnostics = prepared.diagnostics[i];
+		        ShapeGeometry& geometry = prepared.geometries[i];
+		        bool modified = false;
+
+		        if (options.validate || options.repair)
+			        diagnostics = validateShape(shapes[i], options, geometry, modified);
+
+		        if (options.simplifyTolerance > 0.0) {
+			        ShapeGeometry simplified;
+			        const MeshView current = modified ? geometry.getMeshView() : shapes[i];
+			        diagnostics.simplifiedVertices = simplifyShape(current, options.simplifyTolerance, simplified);
+			        if (diagnostics.simplifiedVertices > 0) {
+				        geometry = std::move(simplified);
+				        modified = true;
+			        }
+		        }
+
+		        if (transformStage) {
+			        if (!modified) {
+				        const MeshView& s = shapes[i];
+				        geometry.vertices.assign(s.vertices, s.vertices + s.vertexCoordCount);
+				        geometry.indices.assign(s.indices, s.indices + s.indexCount);
+				        geometry.faceCounts.assign(s.faceCounts, s.faceCounts + s.faceCount);
+				        modified = true;
+			        }
+			        if (options.hasTransform)
+				        transformVertices(geometry.vertices.data(), geometry.getVertexCount(),
+				                          options.transform.data());
+			        if (options.recenter != Recentering::NONE && geometry.getVertexCount() > 0) {
+				        double mn[3], mx[3];
+				        computeBounds(geometry.vertices.data(), geometry.getVertexCount(), mn, mx);
+				        bounds[4 * i] = mn[0];
+				        bounds[4 * i + 1] = mn[2];
+				        bounds[4 * i + 2] = mx[0];
+				        bounds[4 * i + 3] = mx[2];
+			        }
+		        }
+
+		        prepared.modified[i] = modified ? 1 : 0;
+	        },
+	        16);
+
+	if (options.recenter != Recentering::NONE) {
+		if (options.recenter == Recentering::BATCH) {
+			double mn[2] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+			double mx[2] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+			for (size_t i = 0; i < shapes.size(); i++) {
+				if (std::isnan(bounds[4 * i]))
+					continue;
+				mn[0] = std::min(mn[0], bounds[4 * i]);
+				mn[1] = std::min(mn[1], bounds[4 * i + 1]);
+				mx[0] = std::max(mx[0], bounds[4 * i + 2]);
+				mx[1] = std::max(mx[1], bounds[4 * i + 3]);
+			}
+			if (mn[0] <= mx[0]) {
+				const double center[3] = {0.5 * (mn[0] + mx[0]), 0.0, 0.5 * (mn[1] + mx[1])};
+				for (size_t i = 0; i < shapes.size(); i++) {
+					if (!std::isnan(bounds[4 * i]))
+						std::copy(center, center + 3, prepared.offsets.begin() + 3 * i);
+				}
+			}
+		}
+		else {
+			for (size_t i = 0; i < shapes.size(); i++) {
+				if (std::isnan(bounds[4 * i]))
+					continue;
+				prepared.offsets[3 * i] = 0.5 * (bounds[4 * i] + bounds[4 * i + 2]);
+				prepared.offsets[3 * i + 2] = 0.5 * (bounds[4 * i + 1] + bounds[4 * i + 3]);
+			}
+		}
+
+		parallelFor(
+		        shapes.size(),
+		        [&](size_t i) {
+			        const double negated[3] = {-prepared.offsets[3 * i], -prepared.offsets[3 * i + 1],
+			                                   -prepared.offsets[3 * i + 2]};
+			        ShapeGeometry& g = prepared.geometries[i];
+			        translateVertices(g.vertices.data(), g.getVertexCount(), negated);
+		        },
+		        64);
+	}
+
+	for (size_t i = 0; i < shapes.size(); i++) {
+		if (shapes[i].vertices == nullptr)
+			continue;
+		prepared.stats.shapeCount++;
+		prepared.stats.inputVertexCount += shapes[i].indexCount;
+		if (prepared.isModified(i)) {
+			prepared.stats.modifiedShapeCount++;
+			prepared.stats.outputVertexCount += prepared.geometries[i].indices.size();
+		}
+		else
+			prepared.stats.outputVertexCount += shapes[i].indexCount;
+	}
+	return prepared;
+}
+
+} // namespace pcu
@@ -0,0 +1,128 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Moves the shapes close to the origin to keep coordinates small (e.g. for projected coordinate systems). The offset
+ * is the center of the horizontal (xz) bounding box of the batch or of each shape, y is not changed.
+ */
+enum class Recentering { NONE, BATCH, SHAPE };
+
+/**
+ * native processing of initial shape geometry before it is handed to the initial shape builders
+ */
+struct PreparationOptions {
+	bool validate = false;
+	bool repair = false;     // implies validate
+	double tolerance = 1e-6; // distance below which consecutive face vertices are considered duplicates
+	double simplifyTolerance = 0.0; // maximum deviation of the Douglas-Peucker simplification, 0 to disable
+	bool hasTransform = false;
+	std::array<double, 12> transform = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}; // row-major 3x4 affine matrix
+	Recentering recenter = Recentering::NONE;
+
+	bool isEnabled() const {
+		return validate || repair || simplifyTolerance > 0.0 || hasTransform || recenter != Recentering::NONE;
+	}
+};
+
+struct ShapeDiagnostics {
+	enum Issue : uint32_t {
+		INVALID_INDICES = 1u << 0,     // index out of range or face counts not matching the index count
+		NON_FINITE_VERTICES = 1u << 1, // NaN or infinite coordinates
+		DUPLICATE_VERTICES = 1u << 2,  // consecutive face vertices closer than the tolerance
+		DEGENERATE_FACES = 1u << 3,    // less than 3 distinct vertices or zero area
+		WRONG_WINDING = 1u << 4,       // horizontal face with downward normal
+		SELF_INTERSECTIONS = 1u << 5   // non-adjacent face edges intersect (not repairable)
+	};
+
+	bool checked = false; // false for shapes which are not available natively (e.g. path based)
+	uint32_t issues = 0;   // issues found in the input geometry
+	uint32_t repaired = 0; // subset of the issues which were fixed
+	size_t removedVertices = 0;
+	size_t removedFaces = 0;
+	size_t flippedFaces = 0;
+	size_t simplifiedVertices = 0; // face vertices removed by the simplification
+
+	bool isValid() const {
+		return (issues & ~repaired) == 0;
+	}
+
+	static std::vector<std::string> getIssueNames(uint32_t issues);
+};
+
+/**
+ * totals over a batch, vertex counts are face vertices (i.e. index buffer entries)
+ */
+struct PreparationStats {
+	size_t shapeCount = 0;
+	size_t modifiedShapeCount = 0;
+	size_t inputVertexCount = 0;
+	size_t outputVertexCount = 0;
+};
+
+/**
+ * Result of the preparation of a batch of shapes. Only shapes which were changed have a geometry, the others keep
+ * using their original buffers.
+ */
+struct PreparedShapes {
+	PreparationStats stats;
+	std::vector<ShapeDiagnostics> diagnostics;
+	std::vector<ShapeGeometry> geometries;
+	std::vector<uint8_t> modified;
+	std::vector<double> offsets; // 3 per shape, subtracted by the recentering (empty if disabled)
+
+	bool isModified(size_t i) const {
+		return !modified.empty() && modified[i] != 0;
+	}
+};
+
+/**
+ * Validates (and if requested repairs) a single shape. The repaired geometry is only written if a fix was applied.
+ * Repairs drop faces with invalid indices or non-finite coordinates, merge duplicate consecutive vertices, drop
+ * degenerate faces and flip downward facing horizontal faces, unreferenced vertices are removed afterwards. A repair
+ * which would remove all faces is not applied.
+ */
+ShapeDiagnostics validateShape(const MeshView& shape, const PreparationOptions& options, ShapeGeometry& repaired,
+                               bool& modified);
+
+/**
+ * Douglas-Peucker simplification of each face ring with the given maximum deviation. Vertices shared by several faces
+ * are kept as fixed anchors so that adjacent faces stay connected, faces never drop below 3 vertices. Returns the
+ * number of removed face vertices, the simplified geometry is only written if vertices were removed.
+ */
+size_t simplifyShape(const MeshView& shape, double tolerance, ShapeGeometry& simplified);
+
+/**
+ * Runs the enabled preparation stages (validation/repair, simplification, affine transform, recentering) on all
+ * shapes in parallel, empty views (e.g. for path based initial shapes) are skipped. Recentered or transformed shapes
+ * are always returned as modified geometry.
+ */
+PreparedShapes prepareShapes(const std::vector<MeshView>& shapes, const PreparationOptions& options);
+
+} // namespace pcu
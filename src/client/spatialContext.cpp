@@ -0,0 +1,386 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "spatialContext.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace {
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+const double MAX_DOUBLE = std::numeric_limits<double>::max();
+
+struct Box {
+	double minX = MAX_DOUBLE, minZ = MAX_DOUBLE, maxX = -MAX_DOUBLE, maxZ = -MAX_DOUBLE;
+
+	bool isEmpty() const {
+		return minX > maxX;
+	}
+	void add(double x, double z) {
+		minX = std::min(minX, x);
+		minZ = std::min(minZ, z);
+		maxX = std::max(maxX, x);
+		maxZ = std::max(maxZ, z);
+	}
+	double distance(const Box& o) const {
+		const double dx = std::max(0.0, std::max(o.minX - maxX, minX - o.maxX));
+		const double dz = std::max(0.0, std::max(o.minZ - maxZ, minZ - o.maxZ));
+		return std::sqrt(dx * dx + dz * dz);
+	}
+};
+
+/**
+ * outline edges of all shapes as x0, z0, x1, z1 in one buffer, edgeOffsets has shapes + 1 entries
+ */
+struct Outlines {
+	std::vector<double> edges;
+	std::vector<size_t> edgeOffsets;
+	std::vector<Box> boxes;
+
+	size_t getEdgeCount(size_t shape) const {
+		return edgeOffsets[shape + 1] - edgeOffsets[shape];
+	}
+	const double* getEdge(size_t shape, size_t e) const {
+		return edges.data() + 4 * (edgeOffsets[shape] + e);
+	}
+};
+
+std::vector<std::pair<uint32_t, uint32_t>> getOutlineEdges(const pcu::MeshView& shape) {
+	std::vector<std::pair<uint32_t, uint32_t>> edges;
+	edges.reserve(shape.indexCount);
+	size_t offset = 0;
+	for (size_t f = 0; f < shape.faceCount; offset += shape.faceCounts[f], f++) {
+		const size_t n = shape.faceCounts[f];
+		if (offset + n > shape.indexCount)
+			break;
+		for (size_t i = 0; i < n; i++) {
+			const uint32_t a = shape.indices[offset + i];
+			const uint32_t b = shape.indices[offset + (i + 1) % n];
+			if (a != b && a < shape.getVertexCount() && b < shape.getVertexCount())
+				edges.emplace_back(a, b);
+		}
+	}
+	if (shape.faceCount < 2)
+		return edges;
+
+	// drop edges used by two faces (in any direction)
+	std::vector<std::pair<uint32_t, uint32_t>> keys(edges.size());
+	for (size_t e = 0; e < edges.size(); e++)
+		keys[e] = std::minmax(edges[e].first, edges[e].second);
+	std::vector<std::pair<uint32_t, uint32_t>> sorted = keys;
+	std::sort(sorted.begin(), sorted.end());
+
+	std::vector<std::pair<uint32_t, uint32_t>> outline;
+	for (size_t e = 0; e < edges.size(); e++) {
+		const auto range = std::equal_range(sorted.begin(), sorted.end(), keys[e]);
+		if (range.second - range.first == 1)
+			outline.push_back(edges[e]);
+	}
+	return outline;
+}
+
+Outlines buildOutlines(const std::vector<pcu::MeshView>& shapes, const double* offsets) {
+	std::vector<std::vector<double>> perShape(shapes.size());
+	pcu::parallelFor(
+	        shapes.size(),
+	        [&](size_t s) {
+		        if (shapes[s].vertices == nullptr)
+			        return;
+		        const double ox = (offsets != nullptr) ? offsets[3 * s] : 0.0;
+		        const double oz = (offsets != nullptr) ? offsets[3 * s + 2] : 0.0;
+		        for (const auto& e : getOutlineEdges(shapes[s])) {
+			        const double* a = shapes[s].vertices + 3 * size_t(e.first);
+			        const double* b = shapes[s].vertices + 3 * size_t(e.second);
+			        perShape[s].insert(perShape[s].end(), {a[0] + ox, a[2] + oz, b[0] + ox, b[2] + oz});
+		        }
+	        },
+	        64);
+
+	Outlines outlines;
+	outlines.edgeOffsets.resize(shapes.size() + 1, 0);
+	outlines.boxes.resize(shapes.size());
+	for (size_t s = 0; s < shapes.size(); s++)
+		outlines.edgeOffsets[s + 1] = outlines.edgeOffsets[s] + perShape[s].size() / 4;
+	outlines.edges.resize(4 * outlines.edgeOffsets.back());
+	for (size_t s = 0; s < shapes.size(); s++) {
+		std::copy(perShape[s].begin(), perShape[s].end(), outlines.edges.begin() + 4 * outlines.edgeOffsets[s]);
+		for (size_t i = 0; i < perShape[s].size(); i += 2)
+			outlines.boxes[s].add(perShape[s][i], perShape[s][i + 1]);
+	}
+	return outlines;
+}
+
+double pointSegmentDistance2(double px, double pz, const double* e) {
+	const double dx = e[2] - e[0], dz = e[3] - e[1];
+	const double len2 = dx * dx + dz * dz;
+	double t = (len2 > 0.0) ? ((px - e[0]) * dx + (pz - e[1]) * dz) / len2 : 0.0;
+	t = std::max(0.0, std::min(1.0, t));
+	const double qx = e[0] + t * dx - px, qz = e[1] + t * dz - pz;
+	return qx * qx + qz * qz;
+}
+
+bool segmentsCross(const double* a, const double* b) {
+	auto orient = [](double ax, double az, double bx, double bz, double cx, double cz) {
+		return (bx - ax) * (cz - az) - (bz - az) * (cx - ax);
+	};
+	const double o1 = orient(a[0], a[1], a[2], a[3], b[0], b[1]);
+	const double o2 = orient(a[0], a[1], a[2], a[3], b[2], b[3]);
+	const double o3 = orient(b[0], b[1], b[2], b[3], a[0], a[1]);
+	const double o4 = orient(b[0], b[1], b[2], b[3], a[2], a[3]);
+	return ((o1 > 0) != (o2 > 0)) && ((o3 > 0) != (o4 > 0)) && o1 != 0 && o2 != 0 && o3 != 0 && o4 != 0;
+}
+
+double segmentDistance2(const double* a, const double* b) {
+	if (segmentsCross(a, b))
+		return 0.0;
+	return std::min(std::min(pointSegmentDistance2(a[0], a[1], b), pointSegmentDistance2(a[2], a[3], b)),
+	                std::min(pointSegmentDistance2(b[0], b[1], a), pointSegmentDistance2(b[2], b[3], a)));
+}
+
+// minimum distance between the outlines of two shapes, stops early once below the limit
+double outlineDistance(const Outlines& o, size_t s, size_t t, double limit) {
+	double best2 = MAX_DOUBLE;
+	const double limit2 = limit * limit;
+	for (size_t i = 0; i < o.getEdgeCount(s); i++) {
+		for (size_t j = 0; j < o.getEdgeCount(t); j++) {
+			best2 = std::min(best2, segmentDistance2(o.getEdge(s, i), o.getEdge(t, j)));
+			if (best2 <= limit2)
+				return std::sqrt(best2);
+		}
+	}
+	return std::sqrt(best2);
+}
+
+/**
+ * uniform grid over the shape bounding boxes, each shape is registered in all cells it overlaps (CSR layout)
+ */
+class Grid {
+public:
+	Grid(const Outlines& outlines, double minCellSize) {
+		Box extent;
+		size_t shapeCount = 0;
+		double sumExtent = 0.0;
+		for (const Box& b : outlines.boxes) {
+			if (b.isEmpty())
+				continue;
+			extent.add(b.minX, b.minZ);
+			extent.add(b.maxX, b.maxZ);
+			sumExtent += std::max(b.maxX - b.minX, b.maxZ - b.minZ);
+			shapeCount++;
+		}
+		if (shapeCount == 0)
+			return;
+
+		// cells of about the size of a shape, but not more cells than shapes to keep memory bounded
+		const double width = extent.maxX - extent.minX, depth = extent.maxZ - extent.minZ;
+		mCellSize = std::max(minCellSize, sumExtent / shapeCount);
+		mCellSize = std::max(mCellSize, std::sqrt(width * depth / shapeCount));
+		mCellSize = std::max(mCellSize, std::max(width, depth) / 65536.0);
+		if (!(mCellSize > 0.0))
+			mCellSize = 1.0;
+		mMinX = extent.minX;
+		mMinZ = extent.minZ;
+		mCols = static_cast<size_t>(width / mCellSize) + 1;
+		mRows = static_cast<size_t>(depth / mCellSize) + 1;
+
+		mCellOffsets.assign(mCols * mRows + 1, 0);
+		forEachCell(outlines, [&](size_t cell, size_t) { mCellOffsets[cell + 1]++; });
+		for (size_t c = 0; c < mCols * mRows; c++)
+			mCellOffsets[c + 1] += mCellOffsets[c];
+		mItems.resize(mCellOffsets.back());
+		std::vector<size_t> fill(mCellOffsets.begin(), mCellOffsets.end() - 1);
+		forEachCell(outlines, [&](size_t cell, size_t s) { mItems[fill[cell]++] = static_cast<uint32_t>(s); });
+	}
+
+	bool isEmpty() const {
+		return mCols == 0;
+	}
+	double getCellSize() const {
+		return mCellSize;
+	}
+
+	// cell index range [c0, c1] x [r0, r1] covering the box expanded by margin
+	void getCellRange(const Box& b, double margin, long& c0, long& r0, long& c1, long& r1) const {
+		c0 = toCell(b.minX - margin - mMinX);
+		r0 = toCell(b.minZ - margin - mMinZ);
+		c1 = toCell(b.maxX + margin - mMinX);
+		r1 = toCell(b.maxZ + margin - mMinZ);
+	}
+
+	// calls func(shape) for all shapes registered in the cell, ignores cells outside the grid
+	template <typename F>
+	void visitCell(long col, long row, F&& func) const {
+		if (col < 0 || row < 0 || col >= static_cast<long>(mCols) || row >= static_cast<long>(mRows))
+			return;
+		const size_t cell = size_t(row) * mCols + size_t(col);
+		for (size_t i = mCellOffsets[cell]; i < mCellOffsets[cell + 1]; i++)
+			func(mItems[i]);
+	}
+
+	long getMaxRing() const {
+		return static_cast<long>(std::max(mCols, mRows));
+	}
+
+private:
+	long toCell(double d) const {
+		return static_cast<long>(std::floor(d / mCellSize));
+	}
+
+	template <typename F>
+	void forEachCell(const Outlines& outlines, F&& func) {
+		for (size_t s = 0; s < outlines.boxes.size(); s++) {
+			const Box& b = outlines.boxes[s];
+			if (b.isEmpty())
+				continue;
+			long c0, r0, c1, r1;
+			getCellRange(b, 0.0, c0, r0, c1, r1);
+			for (long r = std::max(0L, r0); r <= std::min(r1, long(mRows) - 1); r++)
+				for (long c = std::max(0L, c0); c <= std::min(c1, long(mCols) - 1); c++)
+					func(size_t(r) * mCols + size_t(c), s);
+		}
+	}
+
+	double mCellSize = 1.0;
+	double mMinX = 0.0, mMinZ = 0.0;
+	size_t mCols = 0, mRows = 0;
+	std::vector<size_t> mCellOffsets;
+	std::vector<uint32_t> mItems;
+};
+
+// unique shapes (other than s) in the cells around the box of s expanded by margin
+void collectCandidates(const Grid& grid, const Outlines& o, size_t s, double margin, std::vector<uint32_t>& out) {
+	out.clear();
+	long c0, r0, c1, r1;
+	grid.getCellRange(o.boxes[s], margin, c0, r0, c1, r1);
+	for (long r = r0; r <= r1; r++)
+		for (long c = c0; c <= c1; c++)
+			grid.visitCell(c, r, [&](uint32_t t) {
+				if (t != s)
+					out.push_back(t);
+			});
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+double findNearestDistance(const Grid& grid, const Outlines& o, size_t s) {
+	long c0, r0, c1, r1;
+	grid.getCellRange(o.boxes[s], 0.0, c0, r0, c1, r1);
+
+	double best = MAX_DOUBLE;
+	std::vector<uint32_t> visited;
+	auto test = [&](uint32_t t) {
+		if (t == s || std::find(visited.begin(), visited.end(), t) != visited.end())
+			return;
+		visited.push_back(t);
+		if (o.boxes[s].distance(o.boxes[t]) < best)
+			best = std::min(best, outlineDistance(o, s, t, 0.0));
+	};
+
+	// ring k are the cells at Chebyshev distance k from the cells covered by the shape
+	for (long k = 0; k <= grid.getMaxRing(); k++) {
+		if (k > 0 && double(k - 1) * grid.getCellSize() >= best)
+			break;
+		for (long r = r0 - k; r <= r1 + k; r++) {
+			const bool edgeRow = (r == r0 - k || r == r1 + k);
+			for (long c = c0 - k; c <= c1 + k; c += (edgeRow || k == 0) ? 1 : (c1 - c0 + 2 * k))
+				grid.visitCell(c, r, test);
+		}
+	}
+	return (best < MAX_DOUBLE) ? best : NaN;
+}
+
+double computeFrontage(const Grid& grid, const Outlines& o, size_t s, double tolerance,
+                       std::vector<uint32_t>& candidates) {
+	collectCandidates(grid, o, s, tolerance, candidates);
+	const double tolerance2 = tolerance * tolerance;
+	double frontage = 0.0;
+	for (size_t i = 0; i < o.getEdgeCount(s); i++) {
+		const double* e = o.getEdge(s, i);
+		const double mx = 0.5 * (e[0] + e[2]), mz = 0.5 * (e[1] + e[3]);
+		bool covered = false;
+		for (uint32_t t : candidates) {
+			const Box& b = o.boxes[t];
+			if (mx < b.minX - tolerance || mx > b.maxX + tolerance || mz < b.minZ - tolerance ||
+			    mz > b.maxZ + tolerance)
+				continue;
+			for (size_t j = 0; j < o.getEdgeCount(t) && !covered; j++)
+				covered = pointSegmentDistance2(mx, mz, o.getEdge(t, j)) <= tolerance2;
+			if (covered)
+				break;
+		}
+		if (!covered)
+			frontage += std::hypot(e[2] - e[0], e[3] - e[1]);
+	}
+	return frontage;
+}
+
+} // namespace
+
+namespace pcu {
+
+SpatialContext computeSpatialContext(const std::vector<MeshView>& shapes, const double* offsets,
+                                     const SpatialContextOptions& options) {
+	SpatialContext context;
+	if (!options.isEnabled())
+		return context;
+
+	const Outlines outlines = buildOutlines(shapes, offsets);
+	const Grid grid(outlines, std::max(options.neighborRadius, options.streetTolerance));
+
+	if (options.nearestNeighborDistance)
+		context.nearestNeighborDistance.resize(shapes.size(), NaN);
+	if (options.neighborCount)
+		context.neighborCount.resize(shapes.size(), NaN);
+	if (options.streetFrontage)
+		context.streetFrontage.resize(shapes.size(), NaN);
+
+	parallelFor(
+	        shapes.size(),
+	        [&](size_t s) {
+		        if (outlines.boxes[s].isEmpty())
+			        return;
+		        std::vector<uint32_t> candidates;
+
+		        if (options.nearestNeighborDistance)
+			        context.nearestNeighborDistance[s] = findNearestDistance(grid, outlines, s);
+
+		        if (options.neighborCount) {
+			        collectCandidates(grid, outlines, s, options.neighborRadius, candidates);
+			        size_t count = 0;
+			        for (uint32_t t : candidates) {
+				        if (outlines.boxes[s].distance(outlines.boxes[t]) <= options.neighborRadius &&
+				            outlineDistance(outlines, s, t, options.neighborRadius) <= options.neighborRadius)
+					        count++;
+			        }
+			        context.neighborCount[s] = static_cast<double>(count);
+		        }
+
+		        if (options.streetFrontage)
+			        context.streetFrontage[s] = computeFrontage(grid, outlines, s, options.streetTolerance, candidates);
+	        },
+	        16);
+	return context;
+}
+
+} // namespace pcu
@@ -0,0 +1,63 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * neighborhood metrics of the initial shapes, computed in the horizontal (xz) plane on the shape outlines
+ */
+struct SpatialContextOptions {
+	bool nearestNeighborDistance = false; // distance to the closest other shape (0 if touching)
+	bool neighborCount = false;           // number of other shapes within neighborRadius
+	bool streetFrontage = false;          // length of outline edges without another shape within streetTolerance
+	double neighborRadius = 50.0;
+	double streetTolerance = 1.0;
+
+	bool isEnabled() const {
+		return nearestNeighborDistance || neighborCount || streetFrontage;
+	}
+};
+
+/**
+ * one value per shape for each enabled metric (empty vectors for disabled ones), NaN for shapes without geometry
+ */
+struct SpatialContext {
+	std::vector<double> nearestNeighborDistance;
+	std::vector<double> neighborCount;
+	std::vector<double> streetFrontage;
+};
+
+/**
+ * Computes the enabled metrics for all shapes. The outline of a shape consists of the face edges which are not shared
+ * with another face of the same shape. Shapes are bucketed into a uniform grid over their bounding boxes, queries only
+ * visit the cells around a shape (nearest neighbor searches expand ring by ring). Edge frontage is decided at the edge
+ * midpoint. offsets (3 per shape, may be null) are added to the vertices, e.g. to undo per-shape recentering.
+ */
+SpatialContext computeSpatialContext(const std::vector<MeshView>& shapes, const double* offsets,
+                                     const SpatialContextOptions& options);
+
+} // namespace pcu
@@ -0,0 +1,154 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "surfaceSampling.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// SplitMix64, gives the same sequence on all platforms (unlike the distributions of <random>)
+class SampleRandom {
+public:
+	explicit SampleRandom(uint64_t seed) : mState(seed) {}
+
+	uint64_t next() {
+		uint64_t z = (mState += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// uniform in [0, 1)
+	double nextDouble() {
+		return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+private:
+	uint64_t mState;
+};
+
+struct FaceTriangle {
+	uint32_t face;
+	uint32_t a, b, c; // vertex indices
+};
+
+/**
+ * Splits the faces into triangles (see triangulateFace) and returns the running sum of the triangle areas (same
+ * length as triangles).
+ */
+std::vector<double> buildFaceTriangles(const pcu::MeshView& mesh, std::vector<FaceTriangle>& triangles) {
+	triangles.clear();
+	std::vector<double> cumulativeAreas;
+	std::vector<uint32_t> faceTriangles;
+	double area = 0.0;
+	size_t corner = 0;
+	for (size_t f = 0; f < mesh.faceCount; f++) {
+		const uint32_t count = mesh.faceCounts[f];
+		faceTriangles.clear();
+		pcu::triangulateFace(mesh.vertices, mesh.indices + corner, count, faceTriangles);
+		for (size_t i = 0; i < faceTriangles.size(); i += 3) {
+			const FaceTriangle t = {static_cast<uint32_t>(f), faceTriangles[i], faceTriangles[i + 1],
+			                        faceTriangles[i + 2]};
+			const double* pa = mesh.vertices + 3 * t.a;
+			const double* pb = mesh.vertices + 3 * t.b;
+			const double* pc = mesh.vertices + 3 * t.c;
+			const double u[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+			const double v[3] = {pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]};
+			const double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+			area += 0.5 * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			triangles.push_back(t);
+			cumulativeAreas.push_back(area);
+		}
+		corner += count;
+	}
+	return cumulativeAreas;
+}
+
+} // namespace
+
+namespace pcu {
+
+std::vector<size_t> computeSampleCounts(const std::vector<MeshView>& meshes, const SurfaceSamplingOptions& options) {
+	std::vector<size_t> counts(meshes.size(), 0);
+	parallelFor(meshes.size(), [&](size_t m) {
+		std::vector<FaceTriangle> triangles;
+		const std::vector<double> cumulativeAreas = buildFaceTriangles(meshes[m], triangles);
+		const double area = cumulativeAreas.empty() ? 0.0 : cumulativeAreas.back();
+		if (area <= 0.0)
+			return;
+		if (options.density > 0.0)
+			counts[m] = static_cast<size_t>(std::llround(area * options.density));
+		else
+			counts[m] = options.pointCount;
+	});
+	return counts;
+}
+
+void sampleSurfaces(const std::vector<MeshView>& meshes, const std::vector<uint64_t>& streamIds,
+                    const SurfaceSamplingOptions& options, const std::vector<size_t>& sampleOffsets, double* points,
+                    double* normals, uint32_t* faces) {
+	parallelFor(meshes.size(), [&](size_t m) {
+		const size_t first = sampleOffsets[m];
+		const size_t count = sampleOffsets[m + 1] - first;
+		if (count == 0)
+			return;
+
+		const MeshView& mesh = meshes[m];
+		std::vector<FaceTriangle> triangles;
+		const std::vector<double> cumulativeAreas = buildFaceTriangles(mesh, triangles);
+		if (cumulativeAreas.empty() || cumulativeAreas.back() <= 0.0)
+			return;
+		const double area = cumulativeAreas.back();
+
+		SampleRandom random(options.seed ^ SampleRandom(streamIds[m]).next());
+		for (size_t i = first; i < first + count; i++) {
+			// upper_bound never selects a triangle without area
+			const double target = random.nextDouble() * area;
+			const size_t t = std::min<size_t>(
+			        std::upper_bound(cumulativeAreas.begin(), cumulativeAreas.end(), target) - cumulativeAreas.begin(),
+			        triangles.size() - 1);
+			const FaceTriangle& tri = triangles[t];
+			const double* pa = mesh.vertices + 3 * tri.a;
+			const double* pb = mesh.vertices + 3 * tri.b;
+			const double* pc = mesh.vertices + 3 * tri.c;
+
+			// uniform barycentric coordinates
+			const double s = std::sqrt(random.nextDouble());
+			const double r = random.nextDouble();
+			const double wa = 1.0 - s, wb = s * (1.0 - r), wc = s * r;
+			for (size_t c = 0; c < 3; c++)
+				points[3 * i + c] = wa * pa[c] + wb * pb[c] + wc * pc[c];
+			faces[i] = tri.face;
+
+			if (normals != nullptr) {
+				const double u[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+				const double v[3] = {pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]};
+				const double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+				const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				for (size_t c = 0; c < 3; c++)
+					normals[3 * i + c] = n[c] / length;
+			}
+		}
+	});
+}
+
+} // namespace pcu
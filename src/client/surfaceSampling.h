@@ -0,0 +1,54 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcu {
+
+struct SurfaceSamplingOptions {
+	size_t pointCount = 0; // per mesh, used if density is 0
+	double density = 0.0;  // points per unit of surface area
+	uint64_t seed = 0;
+};
+
+/**
+ * Number of points sampled from each mesh: options.pointCount, or the surface area times options.density rounded to
+ * the nearest integer. Meshes without area get no points.
+ */
+std::vector<size_t> computeSampleCounts(const std::vector<MeshView>& meshes, const SurfaceSamplingOptions& options);
+
+/**
+ * Area weighted uniform sampling of points on the mesh surfaces, faces are split into triangles (see triangulateFace,
+ * points stay inside concave faces). Mesh m writes sampleCounts[m] points starting at point sampleOffsets[m]
+ * (meshes.size() + 1 prefix sums of the counts) into points (3 per point), normals (3 per point, unit normal of the
+ * sampled triangle, may be null) and faces (index of the sampled face). The random sequence of each mesh depends
+ * only on options.seed and streamIds[m], so the result is the same for any thread count and batch composition.
+ * Meshes are processed in parallel.
+ */
+void sampleSurfaces(const std::vector<MeshView>& meshes, const std::vector<uint64_t>& streamIds,
+                    const SurfaceSamplingOptions& options, const std::vector<size_t>& sampleOffsets, double* points,
+                    double* normals, uint32_t* faces);
+
+} // namespace pcu
@@ -22,8 +22,6 @@
 
 #include "prt/StringUtils.h"
 
-#include <pybind11/pybind11.h>
-
 #include <algorithm>
 #include <fstream>
 #include <functional>
@@ -57,121 +55,8 @@ void tokenize(const std::basic_string<C>& str, std::vector<std::basic_string<C>>
 
 } // namespace
 
-namespace py = pybind11;
-
 namespace pcu {
 
-/**
- * Helper function to convert a Python dictionary of "<key>:<value>" into a
- * prt::AttributeMap
- */
-AttributeMapPtr createAttributeMapFromPythonDict(py::dict args, prt::AttributeMapBuilder& bld) {
-	for (auto a : args) {
-
-		const std::wstring key = a.first.cast<std::wstring>();
-
-		if (py::isinstance<py::list>(a.second.ptr())) {
-			auto li = a.second.cast<py::list>();
-
-			if (py::isinstance<py::bool_>(li[0])) {
-				try {
-					size_t count = li.size();
-					std::unique_ptr<bool[]> v_arr(new bool[count]);
-
-					for (size_t i = 0; i < count; i++) {
-						bool item = li[i].cast<bool>();
-						v_arr[i] = item;
-					}
-
-					bld.setBoolArray(key.c_str(), v_arr.get(), count);
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set bool array attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::float_>(li[0])) {
-				try {
-					const size_t count = li.size();
-					std::vector<double> v_arr(count);
-					for (size_t i = 0; i < v_arr.size(); i++) {
-						double item = li[i].cast<double>();
-						v_arr[i] = item;
-					}
-
-					bld.setFloatArray(key.c_str(), v_arr.data(), v_arr.size());
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set float array attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::int_>(li[0])) {
-				try {
-					const size_t count = li.size();
-					std::vector<int32_t> v_arr(count);
-					for (size_t i = 0; i < v_arr.size(); i++) {
-						int32_t item = li[i].cast<int32_t>();
-						v_arr[i] = item;
-					}
-
-					bld.setIntArray(key.c_str(), v_arr.data(), v_arr.size());
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set int array attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::str>(li[0])) {
-				const size_t count = li.size();
-				std::vector<std::wstring> v_arr(count);
-				for (size_t i = 0; i < v_arr.size(); i++) {
-					std::wstring item = li[i].cast<std::wstring>();
-					v_arr[i] = item;
-				}
-
-				const auto v_arr_ptrs = toPtrVec(v_arr); // setStringArray requires contiguous array
-				bld.setStringArray(key.c_str(), v_arr_ptrs.data(), v_arr_ptrs.size());
-			}
-			else
-				std::cout << "Unknown array type." << std::endl;
-		}
-		else {
-			if (py::isinstance<py::bool_>(a.second.ptr())) { // check for boolean first!!
-				try {
-					bool val = a.second.cast<bool>();
-					bld.setBool(key.c_str(), val);
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set bool attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::float_>(a.second.ptr())) {
-				try {
-					double val = a.second.cast<double>();
-					bld.setFloat(key.c_str(), val);
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set float attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::int_>(a.second.ptr())) {
-				try {
-					int32_t val = a.second.cast<int32_t>();
-					bld.setInt(key.c_str(), val);
-				}
-				catch (std::exception& e) {
-					std::wcerr << L"cannot set int attribute " << key << ": " << e.what() << std::endl;
-				}
-			}
-			else if (py::isinstance<py::str>(a.second.ptr())) {
-				std::wstring val = a.second.cast<std::wstring>();
-				bld.setString(key.c_str(), val.c_str());
-			}
-			else
-				std::cout << "Unknown type." << std::endl;
-		}
-	}
-	return AttributeMapPtr{bld.createAttributeMap()};
-}
-
 /**
  * String conversion functions
  */
@@ -202,6 +87,10 @@ std::wstring toUTF16FromUTF8(const std::string& utf8String) {
 
 std::string toUTF8FromOSNarrow(const std::string& osString) {
 	std::wstring utf16String = toUTF16FromOSNarrow(osString);
+	return toUTF8FromUTF16(utf16String);
+}
+
+std::string toUTF8FromUTF16(const std::wstring& utf16String) {
 	return callAPI<wchar_t, char>(prt::StringUtils::toUTF8FromUTF16, utf16String);
 }
 
@@ -289,10 +178,10 @@ URI toFileURI(const std::string& p) {
 	return FILE_SCHEMA + u8PE;
 }
 
-AttributeMapPtr createValidatedOptions(const std::wstring& encID, const AttributeMapPtr& unvalidatedOptions) {
+AttributeMapPtr createValidatedOptions(const std::wstring& encID, const prt::AttributeMap* unvalidatedOptions) {
 	const EncoderInfoPtr encInfo{prt::createEncoderInfo(encID.c_str())};
 	const prt::AttributeMap* validatedOptions = nullptr;
-	encInfo->createValidatedOptionsAndStates(unvalidatedOptions.get(), &validatedOptions);
+	encInfo->createValidatedOptionsAndStates(unvalidatedOptions, &validatedOptions);
 	return AttributeMapPtr(validatedOptions);
 }
 
@@ -335,7 +224,20 @@ std::filesystem::path getLibraryPath(const void* func) {
 }
 
 std::filesystem::path getModuleDirectory() {
-	const auto p = getLibraryPath(reinterpret_cast<const void*>(getLibraryPath));
+	auto p = getLibraryPath(reinterpret_cast<const void*>(getLibraryPath));
+#ifndef _WIN32
+	// linked into an executable, dladdr reports the path it was started with: relative, or only its name if it was
+	// found on PATH
+	if (!p.is_absolute()) {
+#	ifdef __linux__
+		std::error_code ec;
+		const auto executablePath = std::filesystem::read_symlink("/proc/self/exe", ec);
+		p = ec ? std::filesystem::absolute(p) : executablePath;
+#	else
+		p = std::filesystem::absolute(p);
+#	endif
+	}
+#endif
 	return p.parent_path();
 }
 
@@ -25,16 +25,13 @@
 #include "prt/FileOutputCallbacks.h"
 #include "prt/LogHandler.h"
 
-#include <pybind11/pybind11.h>
-#include <pybind11/stl.h>
-
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
 #include <memory>
 #include <ostream>
 #include <string>
-
-namespace py = pybind11;
+#include <vector>
 
 namespace pcu {
 
@@ -53,10 +50,12 @@ struct PRTDestroyer {
 using ObjectPtr = std::unique_ptr<const prt::Object, PRTDestroyer>;
 using CachePtr = std::unique_ptr<prt::CacheObject, PRTDestroyer>;
 using ResolveMapPtr = std::unique_ptr<const prt::ResolveMap, PRTDestroyer>;
+using RuleFileInfoPtr = std::unique_ptr<const prt::RuleFileInfo, PRTDestroyer>;
 using InitialShapePtr = std::unique_ptr<const prt::InitialShape, PRTDestroyer>;
 using InitialShapeBuilderPtr = std::unique_ptr<prt::InitialShapeBuilder, PRTDestroyer>;
 using AttributeMapPtr = std::unique_ptr<const prt::AttributeMap, PRTDestroyer>;
 using AttributeMapBuilderPtr = std::unique_ptr<prt::AttributeMapBuilder, PRTDestroyer>;
+using ResolveMapBuilderPtr = std::unique_ptr<prt::ResolveMapBuilder, PRTDestroyer>;
 using FileOutputCallbacksPtr = std::unique_ptr<prt::FileOutputCallbacks, PRTDestroyer>;
 using ConsoleLogHandlerPtr = std::unique_ptr<prt::ConsoleLogHandler, PRTDestroyer>;
 using FileLogHandlerPtr = std::unique_ptr<prt::FileLogHandler, PRTDestroyer>;
@@ -68,8 +67,7 @@ using PyCallbacksPtr = std::unique_ptr<PyCallbacks>;
 /**
  * prt encoder options helpers
  */
-AttributeMapPtr createAttributeMapFromPythonDict(py::dict args, prt::AttributeMapBuilder& bld);
-AttributeMapPtr createValidatedOptions(const std::wstring& encID, const AttributeMapPtr& unvalidatedOptions);
+AttributeMapPtr createValidatedOptions(const std::wstring& encID, const prt::AttributeMap* unvalidatedOptions);
 
 /**
  * prt specific conversion functions
@@ -98,6 +96,7 @@ std::string toOSNarrowFromUTF16(const std::wstring& osWString);
 std::wstring toUTF16FromOSNarrow(const std::string& osString);
 std::wstring toUTF16FromUTF8(const std::string& utf8String);
 std::string toUTF8FromOSNarrow(const std::string& osString);
+std::string toUTF8FromUTF16(const std::wstring& utf16String);
 std::string percentEncode(const std::string& utf8String);
 URI toFileURI(const std::string& p);
 
@@ -0,0 +1,323 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "voxelization.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const size_t MAX_GRID_BYTES = size_t(1) << 32;
+
+struct Vec3 {
+	double x, y, z;
+};
+
+inline Vec3 sub(const Vec3& a, const Vec3& b) {
+	return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+inline Vec3 cross(const Vec3& a, const Vec3& b) {
+	return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+inline double dot(const Vec3& a, const Vec3& b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// separating axis test for the triangle (relative to the box center) projected onto axis
+bool overlapsOnAxis(const Vec3& axis, const Vec3 (&v)[3], const Vec3& halfSize) {
+	const double p0 = dot(axis, v[0]), p1 = dot(axis, v[1]), p2 = dot(axis, v[2]);
+	const double r = halfSize.x * std::abs(axis.x) + halfSize.y * std::abs(axis.y) + halfSize.z * std::abs(axis.z);
+	return std::min({p0, p1, p2}) <= r && std::max({p0, p1, p2}) >= -r;
+}
+
+/**
+ * Triangle/box overlap after Akenine-Moller: the box faces, the triangle plane and the nine cross products of box
+ * axes and triangle edges are the candidate separating axes. Touching counts as overlap.
+ */
+bool triangleOverlapsBox(const Vec3& center, const Vec3& halfSize, const Vec3 (&triangle)[3]) {
+	const Vec3 v[3] = {sub(triangle[0], center), sub(triangle[1], center), sub(triangle[2], center)};
+	const Vec3 edges[3] = {sub(v[1], v[0]), sub(v[2], v[1]), sub(v[0], v[2])};
+	const Vec3 boxAxes[3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+	for (const Vec3& a : boxAxes) {
+		if (!overlapsOnAxis(a, v, halfSize))
+			return false;
+		for (const Vec3& e : edges) {
+			if (!overlapsOnAxis(cross(a, e), v, halfSize))
+				return false;
+		}
+	}
+	return overlapsOnAxis(cross(edges[0], edges[1]), v, halfSize);
+}
+
+// voxel index range [first, last] covered by the interval [lo, hi] along one axis, false if it is outside the grid
+bool getVoxelRange(double lo, double hi, double origin, double voxelSize, size_t dim, size_t& first, size_t& last) {
+	const double f = std::floor((lo - origin) / voxelSize);
+	const double l = std::floor((hi - origin) / voxelSize);
+	if (dim == 0 || l < 0.0 || f >= static_cast<double>(dim))
+		return false;
+	first = static_cast<size_t>(std::max(f, 0.0));
+	last = static_cast<size_t>(std::min(l, static_cast<double>(dim - 1)));
+	return true;
+}
+
+// index range of the voxel centers inside [lo, hi] along one axis, false if there are none
+bool getCenterRange(double lo, double hi, double origin, double voxelSize, size_t dim, size_t& first, size_t& last) {
+	const double f = std::ceil((lo - origin) / voxelSize - 0.5);
+	const double l = std::floor((hi - origin) / voxelSize - 0.5);
+	if (dim == 0 || l < 0.0 || f >= static_cast<double>(dim) || f > l)
+		return false;
+	first = static_cast<size_t>(std::max(f, 0.0));
+	last = static_cast<size_t>(std::min(l, static_cast<double>(dim - 1)));
+	return true;
+}
+
+// the faces are split with triangulateFace, so concave faces do not cover voxels outside of them
+template <typename F>
+void forEachTriangle(const pcu::MeshView& mesh, F&& func) {
+	auto vertex = [&](uint32_t i) {
+		const double* p = mesh.vertices + 3 * i;
+		return Vec3{p[0], p[1], p[2]};
+	};
+	std::vector<uint32_t> triangles;
+	size_t corner = 0;
+	for (size_t f = 0; f < mesh.faceCount; f++) {
+		const uint32_t count = mesh.faceCounts[f];
+		triangles.clear();
+		pcu::triangulateFace(mesh.vertices, mesh.indices + corner, count, triangles);
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			const Vec3 triangle[3] = {vertex(triangles[i]), vertex(triangles[i + 1]), vertex(triangles[i + 2])};
+			func(triangle);
+		}
+		corner += count;
+	}
+}
+
+// true if the edge a -> b of a counter-clockwise triangle owns the points exactly on it (each shared edge once)
+inline bool ownsEdge(double du, double dv) {
+	return dv > 0.0 || (dv == 0.0 && du < 0.0);
+}
+
+/**
+ * Rasterizes the mesh into the layers [zBegin, zEnd) of the grid. For the solid fill the crossings of the y rays
+ * through the column centers are collected per mesh and filled pairwise.
+ */
+void rasterizeMesh(const pcu::MeshView& mesh, bool solid, size_t zBegin, size_t zEnd, pcu::VoxelGrid& grid) {
+	const double s = grid.voxelSize;
+	const Vec3 origin = {grid.origin[0], grid.origin[1], grid.origin[2]};
+	const Vec3 halfSize = {0.5 * s, 0.5 * s, 0.5 * s};
+
+	std::vector<std::pair<size_t, double>> crossings; // (column, y)
+
+	forEachTriangle(mesh, [&](const Vec3(&t)[3]) {
+		const double minX = std::min({t[0].x, t[1].x, t[2].x}), maxX = std::max({t[0].x, t[1].x, t[2].x});
+		const double minY = std::min({t[0].y, t[1].y, t[2].y}), maxY = std::max({t[0].y, t[1].y, t[2].y});
+		const double minZ = std::min({t[0].z, t[1].z, t[2].z}), maxZ = std::max({t[0].z, t[1].z, t[2].z});
+
+		size_t x0, x1, y0, y1, z0, z1;
+		if (!getVoxelRange(minX, maxX, origin.x, s, grid.dims[0], x0, x1) ||
+		    !getVoxelRange(minY, maxY, origin.y, s, grid.dims[1], y0, y1) ||
+		    !getVoxelRange(minZ, maxZ, origin.z, s, grid.dims[2], z0, z1))
+			return;
+		z0 = std::max(z0, zBegin);
+		z1 = std::min(z1, zEnd - 1);
+		if (z0 > z1)
+			return;
+
+		for (size_t z = z0; z <= z1; z++) {
+			for (size_t y = y0; y <= y1; y++) {
+				for (size_t x = x0; x <= x1; x++) {
+					const Vec3 center = {origin.x + (x + 0.5) * s, origin.y + (y + 0.5) * s, origin.z + (z + 0.5) * s};
+					if (triangleOverlapsBox(center, halfSize, t))
+						grid.setOccupied(x, y, z);
+				}
+			}
+		}
+
+		if (!solid)
+			return;
+
+		// crossings of the y rays, the triangle is projected to the xz plane (u = x, v = z)
+		Vec3 a = t[0], b = t[1], c = t[2];
+		double area2 = (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x);
+		if (area2 == 0.0)
+			return; // parallel to the rays
+		if (area2 < 0.0) {
+			std::swap(b, c);
+			area2 = -area2;
+		}
+		size_t cx0, cx1, cz0, cz1;
+		if (!getCenterRange(minX, maxX, origin.x, s, grid.dims[0], cx0, cx1) ||
+		    !getCenterRange(minZ, maxZ, origin.z, s, grid.dims[2], cz0, cz1))
+			return;
+		cz0 = std::max(cz0, zBegin);
+		cz1 = std::min(cz1, zEnd - 1);
+		for (size_t z = cz0; z <= cz1; z++) {
+			const double pv = origin.z + (z + 0.5) * s;
+			for (size_t x = cx0; x <= cx1; x++) {
+				const double pu = origin.x + (x + 0.5) * s;
+				auto edge = [&](const Vec3& p, const Vec3& q, double& w) {
+					const double du = q.x - p.x, dv = q.z - p.z;
+					w = du * (pv - p.z) - dv * (pu - p.x);
+					return w > 0.0 || (w == 0.0 && ownsEdge(du, dv));
+				};
+				double wa, wb, wc;
+				if (!edge(b, c, wa) || !edge(c, a, wb) || !edge(a, b, wc))
+					continue;
+				const double y = (wa * a.y + wb * b.y + wc * c.y) / area2;
+				crossings.emplace_back((z - zBegin) * grid.dims[0] + x, y);
+			}
+		}
+	});
+
+	if (!solid || crossings.empty())
+		return;
+
+	std::sort(crossings.begin(), crossings.end());
+	for (size_t i = 0; i + 1 < crossings.size();) {
+		const size_t column = crossings[i].first;
+		if (crossings[i + 1].first != column) {
+			i++; // odd number of crossings, the mesh is not closed along this column
+			continue;
+		}
+		size_t y0, y1;
+		if (getCenterRange(crossings[i].second, crossings[i + 1].second, origin.y, s, grid.dims[1], y0, y1)) {
+			const size_t z = zBegin + column / grid.dims[0];
+			const size_t x = column % grid.dims[0];
+			for (size_t y = y0; y <= y1; y++)
+				grid.setOccupied(x, y, z);
+		}
+		i += 2;
+	}
+}
+
+pcu::VoxelGrid createGrid(const std::array<double, 3>& origin, const std::array<size_t, 3>& dims, double voxelSize) {
+	pcu::VoxelGrid grid;
+	grid.origin = origin;
+	grid.dims = dims;
+	grid.voxelSize = voxelSize;
+	const size_t rowBytes = grid.getRowBytes();
+	if (dims[1] != 0 && dims[2] != 0 && rowBytes > MAX_GRID_BYTES / dims[1] / dims[2])
+		throw std::length_error("voxel grid exceeds the size limit, use a larger voxel size or smaller tiles.");
+	grid.bits.assign(rowBytes * dims[1] * dims[2], 0);
+	return grid;
+}
+
+} // namespace
+
+namespace pcu {
+
+size_t VoxelGrid::getOccupiedCount() const {
+	size_t count = 0;
+	for (uint8_t b : bits) {
+		for (; b != 0; b &= static_cast<uint8_t>(b - 1))
+			count++;
+	}
+	return count;
+}
+
+std::vector<uint32_t> VoxelGrid::getOccupiedVoxels() const {
+	std::vector<uint32_t> voxels;
+	voxels.reserve(3 * getOccupiedCount());
+	for (size_t z = 0; z < dims[2]; z++) {
+		for (size_t y = 0; y < dims[1]; y++) {
+			for (size_t x = 0; x < dims[0]; x++) {
+				if (isOccupied(x, y, z)) {
+					voxels.push_back(static_cast<uint32_t>(x));
+					voxels.push_back(static_cast<uint32_t>(y));
+					voxels.push_back(static_cast<uint32_t>(z));
+				}
+			}
+		}
+	}
+	return voxels;
+}
+
+VoxelGrid voxelizeMesh(const MeshView& mesh, const VoxelizationOptions& options) {
+	if (!(options.voxelSize > 0.0))
+		throw std::invalid_argument("voxel size must be positive.");
+
+	const double s = options.voxelSize;
+	std::array<double, 3> origin = {0.0, 0.0, 0.0};
+	std::array<size_t, 3> dims = {0, 0, 0};
+	if (mesh.getVertexCount() > 0) {
+		double minXYZ[3], maxXYZ[3];
+		computeBounds(mesh.vertices, mesh.getVertexCount(), minXYZ, maxXYZ);
+		for (size_t c = 0; c < 3; c++) {
+			const double first = std::floor(minXYZ[c] / s);
+			origin[c] = first * s;
+			dims[c] = static_cast<size_t>(std::floor(maxXYZ[c] / s) - first) + 1;
+		}
+	}
+
+	VoxelGrid grid = createGrid(origin, dims, s);
+	if (dims[2] > 0)
+		rasterizeMesh(mesh, options.solid, 0, dims[2], grid);
+	return grid;
+}
+
+std::vector<VoxelGrid> voxelizeMeshes(const std::vector<MeshView>& meshes, const VoxelizationOptions& options) {
+	std::vector<VoxelGrid> grids(meshes.size());
+	parallelFor(meshes.size(), [&](size_t m) { grids[m] = voxelizeMesh(meshes[m], options); });
+	return grids;
+}
+
+VoxelGrid voxelizeTile(const std::vector<MeshView>& meshes, const VoxelizationOptions& options,
+                       const std::array<double, 3>& origin, const std::array<size_t, 3>& dims) {
+	if (!(options.voxelSize > 0.0))
+		throw std::invalid_argument("voxel size must be positive.");
+
+	const double s = options.voxelSize;
+	VoxelGrid grid = createGrid(origin, dims, s);
+
+	// layers [first, last] touched by each mesh, computed once so the slabs skip the meshes outside of them
+	std::vector<std::pair<size_t, size_t>> layers(meshes.size(), {1, 0});
+	for (size_t m = 0; m < meshes.size(); m++) {
+		const MeshView& mesh = meshes[m];
+		if (mesh.getVertexCount() == 0)
+			continue;
+		double minXYZ[3], maxXYZ[3];
+		computeBounds(mesh.vertices, mesh.getVertexCount(), minXYZ, maxXYZ);
+		size_t first, last;
+		if (getVoxelRange(minXYZ[0], maxXYZ[0], origin[0], s, dims[0], first, last) &&
+		    getVoxelRange(minXYZ[1], maxXYZ[1], origin[1], s, dims[1], first, last) &&
+		    getVoxelRange(minXYZ[2], maxXYZ[2], origin[2], s, dims[2], first, last))
+			layers[m] = {first, last};
+	}
+
+	// slabs of whole layers write disjoint rows, several per worker to balance uneven geometry
+	const size_t slabCount = std::min(dims[2], 4 * getWorkerCount(dims[2]));
+	parallelFor(slabCount, [&](size_t slab) {
+		const size_t zBegin = slab * dims[2] / slabCount;
+		const size_t zEnd = (slab + 1) * dims[2] / slabCount;
+		if (zBegin == zEnd)
+			return;
+		for (size_t m = 0; m < meshes.size(); m++) {
+			if (layers[m].first > layers[m].second || layers[m].second < zBegin || layers[m].first >= zEnd)
+				continue;
+			rasterizeMesh(meshes[m], options.solid, zBegin, zEnd, grid);
+		}
+	});
+	return grid;
+}
+
+} // namespace pcu
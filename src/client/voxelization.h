@@ -0,0 +1,81 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcu {
+
+/**
+ * Occupancy of a regular grid of cubic voxels, voxel (x, y, z) spans origin + [x, x + 1) * voxelSize etc. The bits
+ * are stored in dims[2] * dims[1] rows (z slowest) of getRowBytes() bytes, voxel x is bit x % 8 (least significant
+ * first) of byte x / 8. This is the layout of numpy.packbits(..., axis=-1, bitorder='little') on a (z, y, x) array.
+ */
+struct VoxelGrid {
+	std::array<double, 3> origin = {0.0, 0.0, 0.0};
+	double voxelSize = 1.0;
+	std::array<size_t, 3> dims = {0, 0, 0};
+	std::vector<uint8_t> bits;
+
+	size_t getRowBytes() const {
+		return (dims[0] + 7) / 8;
+	}
+	bool isOccupied(size_t x, size_t y, size_t z) const {
+		return (bits[(z * dims[1] + y) * getRowBytes() + x / 8] >> (x % 8)) & 1u;
+	}
+	void setOccupied(size_t x, size_t y, size_t z) {
+		bits[(z * dims[1] + y) * getRowBytes() + x / 8] |= static_cast<uint8_t>(1u << (x % 8));
+	}
+
+	size_t getOccupiedCount() const;
+
+	// x, y and z index of each occupied voxel in storage order (sparse form of the grid)
+	std::vector<uint32_t> getOccupiedVoxels() const;
+};
+
+struct VoxelizationOptions {
+	double voxelSize = 1.0;
+	bool solid = false; // also fill the interior, only meaningful for closed meshes
+};
+
+/**
+ * Voxelizes the mesh into a grid that covers its bounding box. The grid origin is snapped to a multiple of the voxel
+ * size, so the grids of different models line up. Surface voxelization is conservative: every voxel touched by a
+ * face is occupied. The solid fill casts a ray along y through each voxel column center and fills between pairs of
+ * surface crossings. Throws std::length_error if the grid would exceed 4 GiB.
+ */
+VoxelGrid voxelizeMesh(const MeshView& mesh, const VoxelizationOptions& options);
+
+// one grid per mesh, the meshes are processed in parallel
+std::vector<VoxelGrid> voxelizeMeshes(const std::vector<MeshView>& meshes, const VoxelizationOptions& options);
+
+/**
+ * Voxelizes all meshes into one grid with the given origin and dimensions (a tile), geometry outside the tile is
+ * clipped. The grid is split into z slabs that are processed in parallel, the solid fill is done per mesh.
+ */
+VoxelGrid voxelizeTile(const std::vector<MeshView>& meshes, const VoxelizationOptions& options,
+                       const std::array<double, 3>& origin, const std::array<size_t, 3>& dims);
+
+} // namespace pcu
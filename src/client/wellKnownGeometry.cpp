@@ -0,0 +1,402 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "wellKnownGeometry.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const uint32_t WKB_POLYGON = 3;
+const uint32_t WKB_MULTIPOLYGON = 6;
+const uint32_t EWKB_Z_FLAG = 0x80000000;
+const uint32_t EWKB_M_FLAG = 0x40000000;
+const uint32_t EWKB_SRID_FLAG = 0x20000000;
+
+class ParseError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/**
+ * ring as read from the source, xyz per vertex (z = 0 for 2d geometries)
+ */
+using Ring = std::vector<double>;
+
+/**
+ * Appends the exterior ring as new face using the pyprt_arcgis conventions (see header).
+ */
+void appendExteriorRing(pcu::ShapeGeometry& geometry, Ring& ring) {
+	size_t n = ring.size() / 3;
+	if (n > 1 && std::equal(ring.begin(), ring.begin() + 3, ring.end() - 3))
+		n--; // drop closing vertex
+
+	if (n < 3)
+		throw ParseError("polygon ring has less than 3 distinct vertices");
+
+	double area2 = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		const size_t j = (i + 1) % n;
+		area2 += ring[3 * i] * ring[3 * j + 1] - ring[3 * j] * ring[3 * i + 1];
+	}
+	const bool reverse = area2 < 0.0; // make exterior ring counter-clockwise
+
+	const uint32_t base = static_cast<uint32_t>(geometry.getVertexCount());
+	geometry.vertices.reserve(geometry.vertices.size() + 3 * n);
+	for (size_t k = 0; k < n; k++) {
+		const size_t i = reverse ? n - 1 - k : k;
+		geometry.vertices.push_back(ring[3 * i]);
+		geometry.vertices.push_back(ring[3 * i + 2]);
+		geometry.vertices.push_back(-ring[3 * i + 1]);
+		geometry.indices.push_back(base + static_cast<uint32_t>(k));
+	}
+	geometry.faceCounts.push_back(static_cast<uint32_t>(n));
+}
+
+/**
+ * WKB
+ */
+
+class WKBReader {
+public:
+	WKBReader(const uint8_t* data, size_t size) : mPos(data), mEnd(data + size) {}
+
+	uint8_t readByte() {
+		require(1);
+		return *mPos++;
+	}
+
+	uint32_t readUInt32(bool littleEndian) {
+		uint8_t b[4];
+		readBytes(b, 4, littleEndian);
+		uint32_t v;
+		std::memcpy(&v, b, 4);
+		return v;
+	}
+
+	double readDouble(bool littleEndian) {
+		uint8_t b[8];
+		readBytes(b, 8, littleEndian);
+		double v;
+		std::memcpy(&v, b, 8);
+		return v;
+	}
+
+	void skip(size_t n) {
+		require(n);
+		mPos += n;
+	}
+
+	size_t remaining() const {
+		return static_cast<size_t>(mEnd - mPos);
+	}
+
+private:
+	void require(size_t n) const {
+		if (remaining() < n)
+			throw ParseError("unexpected end of WKB data");
+	}
+
+	// assumes a little endian host like all supported platforms
+	void readBytes(uint8_t* dst, size_t n, bool littleEndian) {
+		require(n);
+		if (littleEndian)
+			std::copy(mPos, mPos + n, dst);
+		else
+			std::reverse_copy(mPos, mPos + n, dst);
+		mPos += n;
+	}
+
+	const uint8_t* mPos;
+	const uint8_t* mEnd;
+};
+
+void readWKBPolygon(WKBReader& reader, bool littleEndian, size_t dims, pcu::ParsedShape& shape) {
+	const uint32_t ringCount = reader.readUInt32(littleEndian);
+	for (uint32_t r = 0; r < ringCount; r++) {
+		const uint32_t pointCount = reader.readUInt32(littleEndian);
+		if (static_cast<size_t>(pointCount) * dims * 8 > reader.remaining())
+			throw ParseError("WKB point count exceeds data size");
+
+		if (r > 0) { // holes are dropped
+			reader.skip(static_cast<size_t>(pointCount) * dims * 8);
+			shape.droppedHoles++;
+			continue;
+		}
+
+		Ring ring(3 * static_cast<size_t>(pointCount));
+		for (uint32_t p = 0; p < pointCount; p++) {
+			ring[3 * p] = reader.readDouble(littleEndian);
+			ring[3 * p + 1] = reader.readDouble(littleEndian);
+			ring[3 * p + 2] = (dims > 2) ? reader.readDouble(littleEndian) : 0.0;
+			if (dims > 3)
+				reader.skip(8);
+		}
+		appendExteriorRing(shape.geometry, ring);
+	}
+}
+
+void readWKBGeometry(WKBReader& reader, pcu::ParsedShape& shape, bool nested) {
+	const uint8_t byteOrder = reader.readByte();
+	if (byteOrder > 1)
+		throw ParseError("invalid WKB byte order marker");
+	const bool littleEndian = (byteOrder == 1);
+
+	uint32_t type = reader.readUInt32(littleEndian);
+	bool hasZ = (type & EWKB_Z_FLAG) != 0;
+	bool hasM = (type & EWKB_M_FLAG) != 0;
+	if ((type & EWKB_SRID_FLAG) != 0)
+		reader.readUInt32(littleEndian); // srid is not needed
+	type &= 0x0FFFFFFF;
+
+	// ISO SQL/MM dimension encoding
+	switch (type / 1000) {
+		case 1:
+			hasZ = true;
+			break;
+		case 2:
+			hasM = true;
+			break;
+		case 3:
+			hasZ = hasM = true;
+			break;
+		default:
+			break;
+	}
+	type %= 1000;
+	const size_t dims = 2 + (hasZ ? 1 : 0) + (hasM ? 1 : 0);
+
+	if (type == WKB_POLYGON)
+		readWKBPolygon(reader, littleEndian, dims, shape);
+	else if (type == WKB_MULTIPOLYGON && !nested) {
+		const uint32_t polygonCount = reader.readUInt32(littleEndian);
+		for (uint32_t p = 0; p < polygonCount; p++)
+			readWKBGeometry(reader, shape, true);
+	}
+	else
+		throw ParseError("unsupported WKB geometry type " + std::to_string(type) + ", expected (multi)polygon");
+}
+
+/**
+ * WKT
+ */
+
+class WKTReader {
+public:
+	explicit WKTReader(const std::string& text) : mText(text), mPos(0) {}
+
+	bool consume(char c) {
+		skipSpace();
+		if (mPos < mText.size() && mText[mPos] == c) {
+			mPos++;
+			return true;
+		}
+		return false;
+	}
+
+	void expect(char c) {
+		if (!consume(c))
+			throw ParseError(std::string("expected '") + c + "' at position " + std::to_string(mPos));
+	}
+
+	std::string readWord() {
+		skipSpace();
+		const size_t start = mPos;
+		while (mPos < mText.size() && std::isalpha(static_cast<unsigned char>(mText[mPos])))
+			mPos++;
+		std::string word = mText.substr(start, mPos - start);
+		std::transform(word.begin(), word.end(), word.begin(), [](char c) { return (char)std::toupper(c); });
+		return word;
+	}
+
+	bool peekNumber() {
+		skipSpace();
+		if (mPos >= mText.size())
+			return false;
+		const char c = mText[mPos];
+		return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+	}
+
+	double readNumber() {
+		skipSpace();
+		const char* begin = mText.c_str() + mPos;
+		char* end = nullptr;
+		const double v = std::strtod(begin, &end);
+		if (end == begin)
+			throw ParseError("expected number at position " + std::to_string(mPos));
+		mPos += static_cast<size_t>(end - begin);
+		return v;
+	}
+
+	void skipSRID() {
+		skipSpace();
+		if (mText.compare(mPos, 5, "SRID=") == 0 || mText.compare(mPos, 5, "srid=") == 0) {
+			const size_t semicolon = mText.find(';', mPos);
+			if (semicolon == std::string::npos)
+				throw ParseError("unterminated SRID prefix");
+			mPos = semicolon + 1;
+		}
+	}
+
+	size_t position() const {
+		return mPos;
+	}
+
+	bool atEnd() {
+		skipSpace();
+		return mPos == mText.size();
+	}
+
+	void rewind(size_t pos) {
+		mPos = pos;
+	}
+
+private:
+	void skipSpace() {
+		while (mPos < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPos])))
+			mPos++;
+	}
+
+	const std::string& mText;
+	size_t mPos;
+};
+
+/**
+ * reads "(x y [z [m]], ...)", dims is detected from the first point if unknown (0)
+ */
+Ring readWKTRing(WKTReader& reader, size_t& dims) {
+	Ring ring;
+	reader.expect('(');
+	do {
+		double v[4] = {0.0, 0.0, 0.0, 0.0};
+		size_t n = 0;
+		while (reader.peekNumber() && n < 4)
+			v[n++] = reader.readNumber();
+		if (n < 2 || (dims != 0 && n != dims))
+			throw ParseError("invalid coordinate at position " + std::to_string(reader.position()));
+		dims = n;
+		ring.insert(ring.end(), {v[0], v[1], v[2]});
+	} while (reader.consume(','));
+	reader.expect(')');
+	return ring;
+}
+
+void readWKTPolygon(WKTReader& reader, size_t& dims, bool hasZ, pcu::ParsedShape& shape) {
+	reader.expect('(');
+	size_t ringIndex = 0;
+	do {
+		Ring ring = readWKTRing(reader, dims);
+		if (ringIndex++ > 0) {
+			shape.droppedHoles++;
+			continue;
+		}
+		if (!hasZ) // "POLYGON M": third value is not a z coordinate
+			for (size_t i = 2; i < ring.size(); i += 3)
+				ring[i] = 0.0;
+		appendExteriorRing(shape.geometry, ring);
+	} while (reader.consume(','));
+	reader.expect(')');
+}
+
+void readWKTGeometry(const std::string& text, pcu::ParsedShape& shape) {
+	WKTReader reader(text);
+	reader.skipSRID();
+
+	const std::string type = reader.readWord();
+	if (type != "POLYGON" && type != "MULTIPOLYGON")
+		throw ParseError("unsupported WKT geometry type '" + type + "', expected (multi)polygon");
+
+	const size_t tagPos = reader.position();
+	const std::string tag = reader.readWord();
+	bool hasZ = false;
+	size_t dims = 0;
+	if (tag == "Z")
+		hasZ = true, dims = 3;
+	else if (tag == "M")
+		dims = 3;
+	else if (tag == "ZM")
+		hasZ = true, dims = 4;
+	else if (tag == "EMPTY")
+		throw ParseError("empty geometry");
+	else
+		reader.rewind(tagPos);
+
+	if (type == "POLYGON")
+		readWKTPolygon(reader, dims, hasZ || dims == 0, shape);
+	else {
+		reader.expect('(');
+		do {
+			const size_t partPos = reader.position();
+			if (reader.readWord() == "EMPTY")
+				continue;
+			reader.rewind(partPos);
+			readWKTPolygon(reader, dims, hasZ || dims == 0, shape);
+		} while (reader.consume(','));
+		reader.expect(')');
+	}
+
+	if (!reader.atEnd())
+		throw ParseError("unexpected trailing characters at position " + std::to_string(reader.position()));
+}
+
+template <typename F>
+void parseInto(pcu::ParsedShape& shape, F&& parse) {
+	try {
+		parse();
+		if (shape.geometry.faceCounts.empty())
+			throw ParseError("geometry has no polygons");
+	}
+	catch (const std::exception& e) {
+		shape.geometry = pcu::ShapeGeometry();
+		shape.error = e.what();
+	}
+}
+
+} // namespace
+
+namespace pcu {
+
+std::vector<ParsedShape> parseWKB(const std::vector<ByteRange>& geometries) {
+	std::vector<ParsedShape> shapes(geometries.size());
+	parallelFor(
+	        geometries.size(),
+	        [&](size_t i) {
+		        parseInto(shapes[i], [&]() {
+			        WKBReader reader(geometries[i].data, geometries[i].size);
+			        readWKBGeometry(reader, shapes[i], false);
+		        });
+	        },
+	        64);
+	return shapes;
+}
+
+std::vector<ParsedShape> parseWKT(const std::vector<std::string>& geometries) {
+	std::vector<ParsedShape> shapes(geometries.size());
+	parallelFor(
+	        geometries.size(),
+	        [&](size_t i) { parseInto(shapes[i], [&]() { readWKTGeometry(geometries[i], shapes[i]); }); }, 64);
+	return shapes;
+}
+
+} // namespace pcu
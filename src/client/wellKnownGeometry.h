@@ -0,0 +1,49 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include "meshUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcu {
+
+struct ByteRange {
+	const uint8_t* data;
+	size_t size;
+};
+
+/**
+ * Parsers for footprints in OGC well-known binary (WKB, including EWKB and ISO Z/M variants) and well-known text
+ * (WKT) representation. Supported are Polygon and MultiPolygon, each polygon becomes one face of the initial shape.
+ *
+ * The axis and ring conventions follow pyprt_arcgis: the closing vertex is removed, the exterior ring is oriented
+ * counter-clockwise in the xy plane and the coordinates are mapped to the PRT y-up frame as (x, 0, -y) or
+ * (x, z, -y) if the geometry has z values. Interior rings (holes) are not supported by the initial shapes and are
+ * dropped, M values are ignored.
+ *
+ * All geometries are parsed in parallel, the result has one entry per input.
+ */
+std::vector<ParsedShape> parseWKB(const std::vector<ByteRange>& geometries);
+std::vector<ParsedShape> parseWKT(const std::vector<std::string>& geometries);
+
+} // namespace pcu
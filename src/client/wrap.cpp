@@ -20,8 +20,18 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "PyCallbacks.h"
+#include "attributeColumns.h"
+#include "arrowWriter.h"
+#include "heightMap.h"
 #include "logging.h"
+#include "meshTopology.h"
+#include "meshWriters.h"
+#include "reportColumns.h"
+#include "ruleInfo.h"
+#include "rulePackage.h"
+#include "surfaceSampling.h"
 #include "utils.h"
+#include "voxelization.h"
 #include "wrap.h"
 
 #include "prt/API.h"
@@ -31,11 +41,14 @@
 
 #include <pybind11/complex.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
@@ -45,31 +58,23 @@
 #include <iterator>
 #include <map>
 #include <numeric>
+#include <set>
 #include <string>
 #include <vector>
 #ifdef _WIN32
 #	include <direct.h>
 #endif
 
-/**
- * commonly used constants
- */
-const wchar_t* FILE_CGA_REPORT = L"CGAReport.txt";
-const wchar_t* ENCODER_OPT_NAME = L"name";
-
-const std::wstring ENCODER_ID_CGA_REPORT = L"com.esri.prt.core.CGAReportEncoder";
-const std::wstring ENCODER_ID_CGA_PRINT = L"com.esri.prt.core.CGAPrintEncoder";
-const std::wstring ENCODER_ID_PYTHON = L"com.esri.pyprt.PyEncoder";
-
 PYBIND11_MAKE_OPAQUE(std::vector<GeneratedModel>);
 
 namespace {
 
-std::unique_ptr<PRTContext> prtCtx;
+PythonLogHandler pythonLogHandler; // outlives the PRT context
+std::unique_ptr<pcu::PRTContext> prtCtx;
 
 void initializePRT() {
 	if (!prtCtx)
-		prtCtx.reset(new PRTContext(prt::LOG_ERROR));
+		prtCtx.reset(new pcu::PRTContext(prt::LOG_ERROR, &pythonLogHandler));
 }
 
 bool isPRTInitialized() {
@@ -77,6 +82,7 @@ bool isPRTInitialized() {
 }
 
 void shutdownPRT() {
+	pcu::getRuleInfoCache().clear();
 	prtCtx.reset();
 }
 
@@ -84,291 +90,1031 @@ void shutdownPRT() {
 
 namespace py = pybind11;
 
-InitialShape::InitialShape(const std::vector<double>& vert) : mVertices(vert), mPathFlag(false) {
-	mIndices.resize(vert.size() / 3);
-	std::iota(std::begin(mIndices), std::end(mIndices), 0);
-	mFaceCounts.resize(1, (uint32_t)mIndices.size());
-}
+namespace {
 
-InitialShape::InitialShape(const std::vector<double>& vert, const std::vector<uint32_t>& ind,
-                           const std::vector<uint32_t>& faceCnt)
-    : mVertices(vert), mIndices(ind), mFaceCounts(faceCnt), mPathFlag(false) {}
+/**
+ * Helper function to convert a Python dictionary of "<key>:<value>" into a
+ * prt::AttributeMap
+ */
+pcu::AttributeMapPtr createAttributeMapFromPythonDict(py::dict args, prt::AttributeMapBuilder& bld) {
+	for (auto a : args) {
 
-InitialShape::InitialShape(const std::string& initShapePath) : mPath(initShapePath), mPathFlag(true) {}
+		const std::wstring key = a.first.cast<std::wstring>();
 
-GeneratedModel::GeneratedModel(const size_t& initShapeIdx, const std::vector<double>& vert,
-                               const std::vector<uint32_t>& indices, const std::vector<uint32_t>& face,
-                               const py::dict& rep)
-    : mInitialShapeIndex(initShapeIdx), mVertices(vert), mIndices(indices), mFaces(face), mReport(rep) {}
+		if (py::isinstance<py::list>(a.second.ptr())) {
+			auto li = a.second.cast<py::list>();
 
-namespace {
+			if (py::isinstance<py::bool_>(li[0])) {
+				try {
+					size_t count = li.size();
+					std::unique_ptr<bool[]> v_arr(new bool[count]);
+
+					for (size_t i = 0; i < count; i++) {
+						bool item = li[i].cast<bool>();
+						v_arr[i] = item;
+					}
 
-void extractMainShapeAttributes(const py::dict& shapeAttr, std::wstring& ruleFile, std::wstring& startRule,
-                                int32_t& seed, std::wstring& shapeName, pcu::AttributeMapPtr& convertShapeAttr) {
-	convertShapeAttr = pcu::createAttributeMapFromPythonDict(
-	        shapeAttr, *(pcu::AttributeMapBuilderPtr(prt::AttributeMapBuilder::create())));
-	if (convertShapeAttr) {
-		if (convertShapeAttr->hasKey(L"ruleFile") &&
-		    convertShapeAttr->getType(L"ruleFile") == prt::AttributeMap::PT_STRING)
-			ruleFile = convertShapeAttr->getString(L"ruleFile");
-		if (convertShapeAttr->hasKey(L"startRule") &&
-		    convertShapeAttr->getType(L"startRule") == prt::AttributeMap::PT_STRING)
-			startRule = convertShapeAttr->getString(L"startRule");
-		if (convertShapeAttr->hasKey(L"seed") && convertShapeAttr->getType(L"seed") == prt::AttributeMap::PT_INT)
-			seed = convertShapeAttr->getInt(L"seed");
-		if (convertShapeAttr->hasKey(L"shapeName") &&
-		    convertShapeAttr->getType(L"shapeName") == prt::AttributeMap::PT_STRING)
-			shapeName = convertShapeAttr->getString(L"shapeName");
-	}
-}
-
-ModelGenerator::ModelGenerator(const std::vector<InitialShape>& myGeo) {
-	mInitialShapesBuilders.resize(myGeo.size());
-
-	mCache = (pcu::CachePtr)prt::CacheObject::create(prt::CacheObject::CACHE_TYPE_DEFAULT);
-
-	// Initial shapes initializing
-	for (size_t ind = 0; ind < myGeo.size(); ind++) {
-
-		pcu::InitialShapeBuilderPtr isb{prt::InitialShapeBuilder::create()};
-
-		if (myGeo[ind].getPathFlag()) {
-			if (!pcu::toFileURI(myGeo[ind].getPath()).empty()) {
-				LOG_DBG << "trying to read initial shape geometry from " << pcu::toFileURI(myGeo[ind].getPath())
-				        << std::endl;
-				const prt::Status s =
-				        isb->resolveGeometry(pcu::toUTF16FromOSNarrow(pcu::toFileURI(myGeo[ind].getPath())).c_str(),
-				                             mResolveMap.get(), mCache.get());
-				if (s != prt::STATUS_OK) {
-					LOG_ERR << "could not resolve geometry from " << pcu::toFileURI(myGeo[ind].getPath());
-					mValid = false;
+					bld.setBoolArray(key.c_str(), v_arr.get(), count);
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set bool array attribute " << key << ": " << e.what() << std::endl;
 				}
 			}
-			else {
-				LOG_ERR << "could not read initial shape geometry, unvalid path";
-				mValid = false;
+			else if (py::isinstance<py::float_>(li[0])) {
+				try {
+					const size_t count = li.size();
+					std::vector<double> v_arr(count);
+					for (size_t i = 0; i < v_arr.size(); i++) {
+						double item = li[i].cast<double>();
+						v_arr[i] = item;
+					}
+
+					bld.setFloatArray(key.c_str(), v_arr.data(), v_arr.size());
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set float array attribute " << key << ": " << e.what() << std::endl;
+				}
 			}
+			else if (py::isinstance<py::int_>(li[0])) {
+				try {
+					const size_t count = li.size();
+					std::vector<int32_t> v_arr(count);
+					for (size_t i = 0; i < v_arr.size(); i++) {
+						int32_t item = li[i].cast<int32_t>();
+						v_arr[i] = item;
+					}
+
+					bld.setIntArray(key.c_str(), v_arr.data(), v_arr.size());
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set int array attribute " << key << ": " << e.what() << std::endl;
+				}
+			}
+			else if (py::isinstance<py::str>(li[0])) {
+				const size_t count = li.size();
+				std::vector<std::wstring> v_arr(count);
+				for (size_t i = 0; i < v_arr.size(); i++) {
+					std::wstring item = li[i].cast<std::wstring>();
+					v_arr[i] = item;
+				}
+
+				const auto v_arr_ptrs = pcu::toPtrVec(v_arr); // setStringArray requires contiguous array
+				bld.setStringArray(key.c_str(), v_arr_ptrs.data(), v_arr_ptrs.size());
+			}
+			else
+				std::cout << "Unknown array type." << std::endl;
 		}
 		else {
-			if (isb->setGeometry(myGeo[ind].getVertices(), myGeo[ind].getVertexCount(), myGeo[ind].getIndices(),
-			                     myGeo[ind].getIndexCount(), myGeo[ind].getFaceCounts(),
-			                     myGeo[ind].getFaceCountsCount()) != prt::STATUS_OK) {
-
-				LOG_ERR << "invalid initial geometry";
-				mValid = false;
+			if (py::isinstance<py::bool_>(a.second.ptr())) { // check for boolean first!!
+				try {
+					bool val = a.second.cast<bool>();
+					bld.setBool(key.c_str(), val);
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set bool attribute " << key << ": " << e.what() << std::endl;
+				}
+			}
+			else if (py::isinstance<py::float_>(a.second.ptr())) {
+				try {
+					double val = a.second.cast<double>();
+					bld.setFloat(key.c_str(), val);
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set float attribute " << key << ": " << e.what() << std::endl;
+				}
+			}
+			else if (py::isinstance<py::int_>(a.second.ptr())) {
+				try {
+					int32_t val = a.second.cast<int32_t>();
+					bld.setInt(key.c_str(), val);
+				}
+				catch (std::exception& e) {
+					std::wcerr << L"cannot set int attribute " << key << ": " << e.what() << std::endl;
+				}
+			}
+			else if (py::isinstance<py::str>(a.second.ptr())) {
+				std::wstring val = a.second.cast<std::wstring>();
+				bld.setString(key.c_str(), val.c_str());
 			}
+			else
+				std::cout << "Unknown type." << std::endl;
 		}
-
-		if (mValid)
-			mInitialShapesBuilders[ind] = std::move(isb);
 	}
+	return pcu::AttributeMapPtr{bld.createAttributeMap()};
 }
 
-void ModelGenerator::setAndCreateInitialShape(const std::vector<py::dict>& shapesAttr,
-                                              std::vector<const prt::InitialShape*>& initShapes,
-                                              std::vector<pcu::InitialShapePtr>& initShapePtrs,
-                                              std::vector<pcu::AttributeMapPtr>& convertedShapeAttr) {
-	for (size_t ind = 0; ind < mInitialShapesBuilders.size(); ind++) {
-		py::dict shapeAttr = shapesAttr[0];
-		if (shapesAttr.size() > ind)
-			shapeAttr = shapesAttr[ind];
+pcu::AttributeMapPtr createAttributeMapFromPythonDict(const py::dict& args) {
+	const pcu::AttributeMapBuilderPtr builder{prt::AttributeMapBuilder::create()};
+	return createAttributeMapFromPythonDict(args, *builder);
+}
 
-		std::wstring ruleF = mRuleFile;
-		std::wstring startR = mStartRule;
-		int32_t randomS = mSeed;
-		std::wstring shapeN = mShapeName;
-		extractMainShapeAttributes(shapeAttr, ruleF, startR, randomS, shapeN, convertedShapeAttr[ind]);
+std::vector<pcu::AttributeMapPtr> createAttributeMapsFromPythonDicts(const std::vector<py::dict>& args) {
+	std::vector<pcu::AttributeMapPtr> maps;
+	maps.reserve(args.size());
+	for (const auto& a : args)
+		maps.push_back(createAttributeMapFromPythonDict(a));
+	return maps;
+}
 
-		mInitialShapesBuilders[ind]->setAttributes(ruleF.c_str(), startR.c_str(), randomS, shapeN.c_str(),
-		                                           convertedShapeAttr[ind].get(), mResolveMap.get());
+/**
+ * converts the native report values into a Python dictionary
+ */
+py::dict getReport(const GeneratedModel& model) {
+	const pcu::Reports& reports = model.getReports();
+	py::dict report;
 
-		initShapePtrs[ind].reset(mInitialShapesBuilders[ind]->createInitialShape());
-		initShapes[ind] = initShapePtrs[ind].get();
-	}
-}
+	for (size_t i = 0; i < reports.boolKeys.size(); i++)
+		report[py::cast(reports.boolKeys[i])] = static_cast<bool>(reports.boolValues[i]);
 
-void ModelGenerator::initializeEncoderData(const std::wstring& encName, const py::dict& encOpt) {
-	mEncodersNames.clear();
-	mEncodersOptionsPtr.clear();
+	for (size_t i = 0; i < reports.floatKeys.size(); i++)
+		report[py::cast(reports.floatKeys[i])] = reports.floatValues[i];
 
-	mEncodersNames.push_back(encName);
-	const pcu::AttributeMapPtr encOptions{pcu::createAttributeMapFromPythonDict(encOpt, *mEncoderBuilder)};
-	mEncodersOptionsPtr.push_back(createValidatedOptions(encName.c_str(), encOptions));
+	for (size_t i = 0; i < reports.stringKeys.size(); i++)
+		report[py::cast(reports.stringKeys[i])] = reports.stringValues[i];
 
-	if (encName != ENCODER_ID_PYTHON) {
-		mEncodersNames.push_back(ENCODER_ID_CGA_REPORT);
-		mEncodersNames.push_back(ENCODER_ID_CGA_PRINT);
+	return report;
+}
 
-		const pcu::AttributeMapBuilderPtr optionsBuilder{prt::AttributeMapBuilder::create()};
-		optionsBuilder->setString(ENCODER_OPT_NAME, FILE_CGA_REPORT);
-		const pcu::AttributeMapPtr reportOptions{optionsBuilder->createAttributeMapAndReset()};
-		const pcu::AttributeMapPtr printOptions{optionsBuilder->createAttributeMapAndReset()};
+/**
+ * leaf attribute tuples as arrays per value type (shape_id, key_id, value) and the list of keys
+ */
+py::dict getLeafAttributes(const GeneratedModel& model) {
+	const pcu::LeafAttributes& leafAttributes = model.getLeafAttributes();
+	auto toArray = [](const auto& v) {
+		using T = typename std::decay_t<decltype(v)>::value_type;
+		return py::array_t<T>(static_cast<py::ssize_t>(v.size()), v.data());
+	};
+
+	py::dict boolValues;
+	boolValues["shape_id"] = toArray(leafAttributes.boolShapeIds);
+	boolValues["key_id"] = toArray(leafAttributes.boolKeyIndices);
+	py::array_t<bool> values(static_cast<py::ssize_t>(leafAttributes.boolValues.size()));
+	std::copy(leafAttributes.boolValues.begin(), leafAttributes.boolValues.end(), values.mutable_data());
+	boolValues["value"] = values;
+
+	py::dict floatValues;
+	floatValues["shape_id"] = toArray(leafAttributes.floatShapeIds);
+	floatValues["key_id"] = toArray(leafAttributes.floatKeyIndices);
+	floatValues["value"] = toArray(leafAttributes.floatValues);
+
+	py::dict stringValues;
+	stringValues["shape_id"] = toArray(leafAttributes.stringShapeIds);
+	stringValues["key_id"] = toArray(leafAttributes.stringKeyIndices);
+	stringValues["value"] = leafAttributes.stringValues;
+
+	py::dict result;
+	result["keys"] = leafAttributes.keys;
+	result["bool"] = boolValues;
+	result["float"] = floatValues;
+	result["string"] = stringValues;
+	return result;
+}
 
-		mEncodersOptionsPtr.push_back(createValidatedOptions(ENCODER_ID_CGA_REPORT, reportOptions));
-		mEncodersOptionsPtr.push_back(createValidatedOptions(ENCODER_ID_CGA_PRINT, printOptions));
+/**
+ * attribute columns as dict of numpy arrays (float and bool) and lists (strings and arrays), invalid entries are NaN,
+ * false or None
+ */
+py::object toPython(const pcu::AttributeColumn& column, size_t row) {
+	if (!column.valid[row])
+		return py::none();
+
+	const size_t begin = column.offsets[row];
+	const size_t end = column.offsets[row + 1];
+	switch (column.type) {
+		case pcu::ValueType::BOOL_ARRAY: {
+			py::array_t<bool> values(static_cast<py::ssize_t>(end - begin));
+			std::transform(column.floats.begin() + begin, column.floats.begin() + end, values.mutable_data(),
+			               [](double v) { return v != 0.0; });
+			return std::move(values);
+		}
+		case pcu::ValueType::FLOAT_ARRAY:
+			return py::array_t<double>(static_cast<py::ssize_t>(end - begin), column.floats.data() + begin);
+		default:
+			return py::cast(std::vector<std::wstring>(column.strings.begin() + begin, column.strings.begin() + end));
 	}
 }
 
-void ModelGenerator::getRawEncoderDataPointers(std::vector<const wchar_t*>& allEnc,
-                                               std::vector<const prt::AttributeMap*>& allEncOpt) {
-	if (mEncodersNames[0] == ENCODER_ID_PYTHON) {
-		allEnc.clear();
-		allEncOpt.clear();
-
-		allEnc.push_back(mEncodersNames[0].c_str());
-		allEncOpt.push_back(mEncodersOptionsPtr[0].get());
+py::dict toPython(const std::vector<pcu::AttributeColumn>& columns) {
+	py::dict dict;
+	for (const auto& column : columns) {
+		const py::ssize_t rowCount = static_cast<py::ssize_t>(column.valid.size());
+		if (column.type == pcu::ValueType::FLOAT) {
+			dict[py::cast(column.key)] = py::array_t<double>(rowCount, column.floats.data());
+		}
+		else if (column.type == pcu::ValueType::BOOL) {
+			py::array_t<bool> values(rowCount);
+			std::transform(column.floats.begin(), column.floats.end(), values.mutable_data(),
+			               [](double v) { return v != 0.0; });
+			dict[py::cast(column.key)] = values;
+		}
+		else {
+			py::list values;
+			for (size_t r = 0; r < column.valid.size(); r++) {
+				if (column.type == pcu::ValueType::STRING)
+					values.append(column.valid[r] ? py::cast(column.strings[r]) : py::none());
+				else
+					values.append(toPython(column, r));
+			}
+			dict[py::cast(column.key)] = values;
+		}
 	}
-	else {
-		allEnc.clear();
-		allEnc.push_back(mEncodersNames[0].c_str());
-		allEnc.push_back(mEncodersNames[1].c_str()); // an encoder to redirect CGA report to CGAReport.txt
-		allEnc.push_back(mEncodersNames[2].c_str()); // redirects CGA print output to the callback
+	return dict;
+}
 
-		allEncOpt.clear();
-		allEncOpt.push_back(mEncodersOptionsPtr[0].get());
-		allEncOpt.push_back(mEncodersOptionsPtr[1].get());
-		allEncOpt.push_back(mEncodersOptionsPtr[2].get());
+ModelGenerator::ModelGenerator(const std::vector<InitialShape>& myGeo, const py::dict& preparationOptions) {
+	createGenerator(myGeo, preparationOptions);
+}
+
+ModelGenerator::ModelGenerator(const InitialShapeBatch& batch, const py::dict& preparationOptions) {
+	createGenerator(batch.getShapes(), preparationOptions);
+}
+
+void ModelGenerator::createGenerator(const std::vector<InitialShape>& myGeo, const py::dict& preparationOptions) {
+	const pcu::AttributeMapPtr optionMap = createAttributeMapFromPythonDict(preparationOptions);
+	{
+		py::gil_scoped_release release;
+		mGenerator = std::make_unique<Generator>(myGeo, optionMap.get());
 	}
+
+	// CGA print and error messages go to the Python output like the log
+	mGenerator->setMessageHandler([](const std::wstring& message) {
+		py::gil_scoped_acquire acquire;
+		py::print(message);
+	});
 }
 
 std::vector<GeneratedModel> ModelGenerator::generateModel(const std::vector<py::dict>& shapeAttributes,
                                                           const std::string& rulePackagePath,
                                                           const std::wstring& geometryEncoderName,
                                                           const py::dict& geometryEncoderOptions) {
-	if (!mValid) {
-		LOG_ERR << "invalid ModelGenerator instance.";
+	if (!prtCtx) {
+		LOG_ERR << "prt has not been initialized.";
 		return {};
 	}
 
-	if ((shapeAttributes.size() != 1) &&
-	    (shapeAttributes.size() <
-	     mInitialShapesBuilders.size())) { // if one shape attribute dictionary, same apply to all initial shapes.
-		LOG_ERR << "not enough shape attributes dictionaries defined.";
+	const std::vector<pcu::AttributeMapPtr> shapeAttributeMaps = createAttributeMapsFromPythonDicts(shapeAttributes);
+	const pcu::AttributeMapPtr encoderOptions = createAttributeMapFromPythonDict(geometryEncoderOptions);
+
+	py::gil_scoped_release release;
+	return mGenerator->generateModel(shapeAttributeMaps, rulePackagePath, geometryEncoderName, encoderOptions.get());
+}
+
+std::vector<GeneratedModel> ModelGenerator::generateAnotherModel(const std::vector<py::dict>& shapeAttributes) {
+	if (!prtCtx) {
+		LOG_ERR << "prt has not been initialized.";
 		return {};
 	}
-	else if (shapeAttributes.size() > mInitialShapesBuilders.size()) {
-		LOG_WRN << "number of shape attributes dictionaries defined greater than number of initial shapes given."
-		        << std::endl;
+
+	const std::vector<pcu::AttributeMapPtr> shapeAttributeMaps = createAttributeMapsFromPythonDicts(shapeAttributes);
+
+	py::gil_scoped_release release;
+	return mGenerator->generateAnotherModel(shapeAttributeMaps);
+}
+
+py::dict ModelGenerator::evaluateAttributes(const std::vector<py::dict>& shapeAttributes,
+                                            const std::string& rulePackagePath) {
+	if (!prtCtx) {
+		LOG_ERR << "prt has not been initialized.";
+		return {};
 	}
 
-	std::vector<GeneratedModel> newGeneratedGeo;
-	newGeneratedGeo.reserve(mInitialShapesBuilders.size());
+	const std::vector<pcu::AttributeMapPtr> shapeAttributeMaps = createAttributeMapsFromPythonDicts(shapeAttributes);
 
-	try {
-		if (!prtCtx) {
-			LOG_ERR << "prt has not been initialized.";
-			return {};
+	std::vector<pcu::AttributeColumn> columns;
+	{
+		py::gil_scoped_release release;
+		columns = mGenerator->evaluateAttributes(shapeAttributeMaps, rulePackagePath);
+	}
+	return toPython(columns);
+}
+
+py::dict ModelGenerator::getPreparationStats() const {
+	const pcu::PreparationStats& preparationStats = mGenerator->getPreparationStats();
+	py::dict stats;
+	stats["shape_count"] = preparationStats.shapeCount;
+	stats["modified_shape_count"] = preparationStats.modifiedShapeCount;
+	stats["input_vertex_count"] = preparationStats.inputVertexCount;
+	stats["output_vertex_count"] = preparationStats.outputVertexCount;
+	return stats;
+}
+
+py::dict ModelGenerator::getContextAttributes() const {
+	py::dict attributes;
+	for (const auto& attribute : mGenerator->getContextAttributes())
+		attributes[py::cast(attribute.first)] = attribute.second;
+	return attributes;
+}
+
+bool ModelGenerator::setCategoricalAttributes(const py::dict& columns) {
+	std::vector<CategoricalAttribute> attributes;
+	for (const auto& item : columns) {
+		CategoricalAttribute attribute;
+		attribute.key = item.first.cast<std::wstring>();
+		const py::sequence column = item.second.cast<py::sequence>();
+		if (column.size() != 2) {
+			LOG_ERR << "categorical attribute " << attribute.key << " must be a pair of codes and categories";
+			return false;
 		}
+		const auto codes = column[0].cast<py::array_t<int32_t, py::array::c_style | py::array::forcecast>>();
+		attribute.codes.assign(codes.data(), codes.data() + codes.size());
+		attribute.categories = column[1].cast<std::vector<std::wstring>>();
+		attributes.push_back(std::move(attribute));
+	}
 
-		// Resolve Map
-		if (!rulePackagePath.empty()) {
-			LOG_INF << "using rule package " << rulePackagePath << std::endl;
+	// the generator lock is never waited for with the GIL held, a running generation may need it to log
+	py::gil_scoped_release release;
+	return mGenerator->setCategoricalAttributes(std::move(attributes));
+}
 
-			const std::string u8rpkURI = pcu::toFileURI(rulePackagePath);
-			prt::Status status = prt::STATUS_UNSPECIFIED_ERROR;
-			try {
-				mResolveMap.reset(prt::createResolveMap(pcu::toUTF16FromUTF8(u8rpkURI).c_str(), nullptr, &status));
-			}
-			catch (std::exception& e) {
-				pybind11::print("CAUGHT EXCEPTION:", e.what());
-			}
+py::dict ModelGenerator::prefetchAssets(const std::string& rulePackagePath) {
+	if (!prtCtx) {
+		LOG_ERR << "prt has not been initialized.";
+		return {};
+	}
 
-			if (mResolveMap && (status == prt::STATUS_OK)) {
-				LOG_DBG << "resolve map = " << pcu::objectToXML(mResolveMap.get()) << std::endl;
-			}
-			else {
-				LOG_ERR << "getting resolve map from '" << rulePackagePath << "' failed, aborting.";
-				return {};
-			}
+	pcu::AssetPrefetchStats stats;
+	bool prefetched = false;
+	{
+		py::gil_scoped_release release;
+		prefetched = mGenerator->prefetchAssets(rulePackagePath, stats);
+	}
+	if (!prefetched)
+		return {};
+
+	py::list errors;
+	for (const auto& e : stats.errors)
+		errors.append(py::make_tuple(e.first, e.second));
+	py::dict result;
+	result["rule_file_count"] = stats.ruleFileCount;
+	result["geometry_count"] = stats.geometryCount;
+	result["texture_count"] = stats.textureCount;
+	result["skipped_count"] = stats.skippedCount;
+	result["seconds"] = stats.seconds;
+	result["errors"] = errors;
+	return result;
+}
+
+bool ModelGenerator::reloadRulePackage(bool force) {
+	py::gil_scoped_release release;
+	return mGenerator->reloadRulePackage(force);
+}
+
+/**
+ * read-only numpy views onto the native buffers of a generated model, the model object is kept alive as base of the
+ * array
+ */
+template <typename T>
+py::array_t<T> makeReadOnly(py::array_t<T> a) {
+	a.attr("setflags")(py::arg("write") = false);
+	return a;
+}
+
+template <typename T>
+py::array_t<T> toArrayView(const std::vector<T>& v, py::handle base) {
+	return makeReadOnly(py::array_t<T>(static_cast<py::ssize_t>(v.size()), v.data(), base));
+}
+
+py::array_t<double> toVertexArrayView(const std::vector<double>& v, py::handle base) {
+	const std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(v.size() / 3), 3};
+	const std::vector<py::ssize_t> strides = {3 * sizeof(double), sizeof(double)};
+	return makeReadOnly(py::array_t<double>(shape, strides, v.data(), base));
+}
+
+template <typename T>
+py::array_t<T> toArray(const std::vector<size_t>& v) {
+	py::array_t<T> a(static_cast<py::ssize_t>(v.size()));
+	std::copy(v.begin(), v.end(), a.mutable_data());
+	return a;
+}
+
+/**
+ * Mesh view in the input coordinates: the vertices of a model with an offset (recentered and not restored) are
+ * translated into a copy in translated, which must outlive the view. All outputs of the batch functions (arrays,
+ * exports, sampled points, grids) are in the input coordinates. May convert the vertex layout of the model, so call it
+ * before releasing the GIL.
+ */
+pcu::MeshView getInputMeshView(const GeneratedModel& model, std::vector<double>& translated) {
+	pcu::MeshView view = model.getMeshView();
+	const std::array<double, 3>& offset = model.getOffset();
+	if (offset[0] != 0.0 || offset[1] != 0.0 || offset[2] != 0.0) {
+		translated.assign(view.vertices, view.vertices + view.vertexCoordCount);
+		pcu::translateVertices(translated.data(), view.getVertexCount(), offset.data());
+		view.vertices = translated.data();
+	}
+	return view;
+}
+
+std::vector<pcu::MeshView> getInputMeshViews(const std::vector<GeneratedModel>& models,
+                                             std::vector<std::vector<double>>& translated) {
+	translated.resize(models.size());
+	std::vector<pcu::MeshView> meshes;
+	meshes.reserve(models.size());
+	for (size_t i = 0; i < models.size(); i++)
+		meshes.push_back(getInputMeshView(models[i], translated[i]));
+	return meshes;
+}
+
+// same as getInputMeshView for the separate vertex components
+const pcu::VertexComponents& getInputVertexComponents(const GeneratedModel& model,
+                                                      pcu::VertexComponents& translated) {
+	const pcu::VertexComponents& components = model.getVertexComponents();
+	const std::array<double, 3>& offset = model.getOffset();
+	if (offset[0] == 0.0 && offset[1] == 0.0 && offset[2] == 0.0)
+		return components;
+	for (size_t c = 0; c < 3; c++) {
+		translated[c].resize(components[c].size());
+		std::transform(components[c].begin(), components[c].end(), translated[c].begin(),
+		               [&](double x) { return x + offset[c]; });
+	}
+	return translated;
+}
+
+// total face area per orientation class (faceClasses encoder option)
+py::dict getFaceClassAreas(const GeneratedModel& model) {
+	const std::array<double, FACE_CLASS_COUNT>& areas = model.getFaceClassAreas();
+	py::dict result;
+	result["roof"] = areas[FACE_CLASS_ROOF];
+	result["wall"] = areas[FACE_CLASS_WALL];
+	result["ground"] = areas[FACE_CLASS_GROUND];
+	return result;
+}
+
+/**
+ * report values of all models as one array per key, string reports as codes into a dictionary of the distinct values
+ * (missing values: NaN for floats, -1 for bools and codes)
+ */
+py::dict getReportColumns(const std::vector<GeneratedModel>& models) {
+	std::vector<const pcu::Reports*> rows;
+	rows.reserve(models.size());
+	for (const auto& m : models)
+		rows.push_back(&m.getReports());
+
+	pcu::ReportColumns columns;
+	{
+		py::gil_scoped_release release;
+		columns = pcu::buildReportColumns(rows);
+	}
+
+	const py::ssize_t rowCount = static_cast<py::ssize_t>(models.size());
+	py::dict bools;
+	for (const auto& c : columns.bools)
+		bools[py::cast(c.key)] = py::array_t<int8_t>(rowCount, c.values.data());
+	py::dict floats;
+	for (const auto& c : columns.floats)
+		floats[py::cast(c.key)] = py::array_t<double>(rowCount, c.values.data());
+	py::dict strings;
+	for (const auto& c : columns.strings) {
+		py::dict column;
+		column["codes"] = py::array_t<int32_t>(rowCount, c.codes.data());
+		column["dictionary"] = c.dictionary.getValues();
+		strings[py::cast(c.key)] = column;
+	}
+
+	py::dict result;
+	result["bool"] = bools;
+	result["float"] = floats;
+	result["string"] = strings;
+	return result;
+}
+
+/**
+ * concatenates the geometry of all models into contiguous arrays (one pass, parallel over models), the vertices either
+ * as one (n, 3) array ("aos") or as separate x, y and z arrays ("soa")
+ */
+py::dict getMeshArrays(const std::vector<GeneratedModel>& models, const std::string& vertexLayout) {
+	const bool separateComponents = (vertexLayout == "soa");
+	if (!separateComponents && vertexLayout != "aos") {
+		LOG_ERR << "unknown vertex layout '" << vertexLayout << "', expected 'aos' or 'soa'";
+		return {};
+	}
+
+	std::vector<pcu::MeshView> meshes;
+	std::vector<const pcu::VertexComponents*> vertexComponents;
+	std::vector<pcu::VertexComponents> translatedComponents;
+	std::vector<std::vector<double>> translated;
+	if (separateComponents) {
+		meshes.reserve(models.size());
+		vertexComponents.reserve(models.size());
+		translatedComponents.resize(models.size());
+		for (size_t i = 0; i < models.size(); i++) {
+			meshes.push_back(models[i].getTopologyView());
+			vertexComponents.push_back(&getInputVertexComponents(models[i], translatedComponents[i]));
 		}
+	}
+	else
+		meshes = getInputMeshViews(models, translated);
+
+	std::vector<size_t> initialShapeIndices;
+	initialShapeIndices.reserve(models.size());
+	for (const auto& m : models)
+		initialShapeIndices.push_back(m.getInitialShapeIndex());
+
+	const pcu::MergedMeshLayout layout = pcu::computeMergedLayout(meshes);
+
+	py::array_t<uint32_t> indices(static_cast<py::ssize_t>(layout.getIndexCount()));
+	py::array_t<uint64_t> faceOffsets(static_cast<py::ssize_t>(layout.getFaceCount() + 1));
+	uint32_t* indexData = indices.mutable_data();
+	uint64_t* faceOffsetData = faceOffsets.mutable_data();
+
+	py::dict arrays;
+	if (separateComponents) {
+		const py::ssize_t vertexCount = static_cast<py::ssize_t>(layout.getVertexCount());
+		py::array_t<double> x(vertexCount), y(vertexCount), z(vertexCount);
+		const std::array<double*, 3> xyz = {x.mutable_data(), y.mutable_data(), z.mutable_data()};
+		{
+			py::gil_scoped_release release;
+			pcu::mergeMeshes(meshes, vertexComponents, layout, xyz, indexData, faceOffsetData);
+		}
+		arrays["x"] = x;
+		arrays["y"] = y;
+		arrays["z"] = z;
+	}
+	else {
+		const std::vector<py::ssize_t> vertexShape = {static_cast<py::ssize_t>(layout.getVertexCount()), 3};
+		py::array_t<double> vertices(vertexShape);
+		double* vertexData = vertices.mutable_data();
+		{
+			py::gil_scoped_release release;
+			pcu::mergeMeshes(meshes, layout, vertexData, indexData, faceOffsetData);
+		}
+		arrays["vertices"] = vertices;
+	}
 
-		// Initial shapes
-		std::vector<const prt::InitialShape*> initialShapes(mInitialShapesBuilders.size());
-		std::vector<pcu::InitialShapePtr> initialShapePtrs(mInitialShapesBuilders.size());
-		std::vector<pcu::AttributeMapPtr> convertedShapeAttrVec(mInitialShapesBuilders.size());
-		setAndCreateInitialShape(shapeAttributes, initialShapes, initialShapePtrs, convertedShapeAttrVec);
+	arrays["indices"] = indices;
+	arrays["face_offsets"] = faceOffsets;
+	arrays["model_vertex_offsets"] = toArray<uint64_t>(layout.vertexOffsets);
+	arrays["model_face_offsets"] = toArray<uint64_t>(layout.faceOffsets);
+	arrays["initial_shape_indices"] = toArray<uint64_t>(initialShapeIndices);
+	return arrays;
+}
 
-		// Encoder info, encoder options
-		if (!mEncoderBuilder)
-			mEncoderBuilder.reset(prt::AttributeMapBuilder::create());
+py::dict toEdgeAdjacencyDict(const pcu::EdgeAdjacency& adjacency) {
+	const std::vector<py::ssize_t> pairShape = {static_cast<py::ssize_t>(adjacency.getEdgeCount()), 2};
+	py::dict result;
+	result["edge_vertices"] = py::array_t<uint32_t>(pairShape, adjacency.edgeVertices.data());
+	result["edge_faces"] = py::array_t<int32_t>(pairShape, adjacency.edgeFaces.data());
+	result["half_edge_edges"] = py::array_t<int32_t>(static_cast<py::ssize_t>(adjacency.halfEdgeEdges.size()),
+	                                                 adjacency.halfEdgeEdges.data());
+	result["welded_vertices"] = py::array_t<uint32_t>(static_cast<py::ssize_t>(adjacency.weldedVertices.size()),
+	                                                  adjacency.weldedVertices.data());
+	result["non_manifold_edge_count"] = adjacency.nonManifoldEdgeCount;
+	return result;
+}
 
-		if (!geometryEncoderName.empty())
-			initializeEncoderData(geometryEncoderName, geometryEncoderOptions);
+/**
+ * edge list with incident faces (-1 for boundary edges) and the edge of each half-edge, see pcu::EdgeAdjacency
+ */
+py::dict getEdgeAdjacency(const GeneratedModel& model, bool weld) {
+	std::vector<double> translated;
+	const pcu::MeshView mesh = getInputMeshView(model, translated);
+	pcu::EdgeAdjacency adjacency;
+	{
+		py::gil_scoped_release release;
+		adjacency = pcu::buildEdgeAdjacency(mesh, weld);
+	}
+	return toEdgeAdjacencyDict(adjacency);
+}
 
-		std::vector<const wchar_t*> encoders;
-		encoders.reserve(3);
-		std::vector<const prt::AttributeMap*> encodersOptions;
-		encodersOptions.reserve(3);
+py::list getEdgeAdjacencies(const std::vector<GeneratedModel>& models, bool weld) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	std::vector<pcu::EdgeAdjacency> adjacencies;
+	{
+		py::gil_scoped_release release;
+		adjacencies = pcu::buildEdgeAdjacencies(meshes, weld);
+	}
+	py::list result;
+	for (const auto& adjacency : adjacencies)
+		result.append(toEdgeAdjacencyDict(adjacency));
+	return result;
+}
 
-		getRawEncoderDataPointers(encoders, encodersOptions);
+/**
+ * area weighted random points on the model surfaces as contiguous arrays, face_classes is only included if all models
+ * were generated with the faceClasses encoder option
+ */
+py::dict samplePoints(const std::vector<const GeneratedModel*>& models, size_t count, double density, uint64_t seed,
+                      bool withNormals) {
+	std::vector<pcu::MeshView> meshes;
+	std::vector<uint64_t> streamIds;
+	std::vector<std::vector<double>> translated(models.size());
+	meshes.reserve(models.size());
+	streamIds.reserve(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		meshes.push_back(getInputMeshView(*models[i], translated[i]));
+		streamIds.push_back(models[i]->getInitialShapeIndex());
+	}
 
-		if (mEncodersNames[0] == ENCODER_ID_PYTHON) {
+	pcu::SurfaceSamplingOptions options;
+	options.pointCount = count;
+	options.density = density;
+	options.seed = seed;
 
-			pcu::PyCallbacksPtr foc{std::make_unique<PyCallbacks>(mInitialShapesBuilders.size())};
+	std::vector<size_t> sampleCounts;
+	{
+		py::gil_scoped_release release;
+		sampleCounts = pcu::computeSampleCounts(meshes, options);
+	}
+	std::vector<size_t> sampleOffsets(models.size() + 1, 0);
+	std::partial_sum(sampleCounts.begin(), sampleCounts.end(), sampleOffsets.begin() + 1);
+	const py::ssize_t pointCount = static_cast<py::ssize_t>(sampleOffsets.back());
+
+	const std::vector<py::ssize_t> pointShape = {pointCount, 3};
+	py::array_t<double> points(pointShape);
+	py::array_t<double> normals;
+	if (withNormals)
+		normals = py::array_t<double>(pointShape);
+	py::array_t<uint32_t> faces(pointCount);
+	double* pointData = points.mutable_data();
+	double* normalData = withNormals ? normals.mutable_data() : nullptr;
+	uint32_t* faceData = faces.mutable_data();
+	{
+		py::gil_scoped_release release;
+		pcu::sampleSurfaces(meshes, streamIds, options, sampleOffsets, pointData, normalData, faceData);
+	}
 
-			// Generate
-			const prt::Status genStat =
-			        prt::generate(initialShapes.data(), initialShapes.size(), nullptr, encoders.data(), encoders.size(),
-			                      encodersOptions.data(), foc.get(), mCache.get(), nullptr);
+	py::dict result;
+	result["points"] = points;
+	if (withNormals)
+		result["normals"] = normals;
+	result["faces"] = faces;
+
+	const bool withFaceClasses = std::all_of(models.begin(), models.end(), [](const GeneratedModel* m) {
+		return m->getFaceClasses().size() == m->getFaces().size();
+	});
+	if (withFaceClasses) {
+		py::array_t<uint8_t> faceClasses(pointCount);
+		uint8_t* faceClassData = faceClasses.mutable_data();
+		for (size_t m = 0; m < models.size(); m++) {
+			const std::vector<uint8_t>& classes = models[m]->getFaceClasses();
+			for (size_t i = sampleOffsets[m]; i < sampleOffsets[m + 1]; i++)
+				faceClassData[i] = classes[faceData[i]];
+		}
+		result["face_classes"] = faceClasses;
+	}
 
-			if (genStat != prt::STATUS_OK) {
-				LOG_ERR << "prt::generate() failed with status: '" << prt::getStatusDescription(genStat) << "' ("
-				        << genStat << ")";
-				return {};
-			}
+	result["model_point_offsets"] = toArray<uint64_t>(sampleOffsets);
+	return result;
+}
 
-			for (size_t idx = 0; idx < mInitialShapesBuilders.size(); idx++) {
-				newGeneratedGeo.emplace_back(idx, foc->getVertices(idx), foc->getIndices(idx), foc->getFaces(idx),
-				                             foc->getReport(idx));
-			}
+py::dict sampleModelPoints(const GeneratedModel& model, size_t count, double density, uint64_t seed,
+                           bool withNormals) {
+	return samplePoints({&model}, count, density, seed, withNormals);
+}
+
+py::dict sampleBatchPoints(const std::vector<GeneratedModel>& models, size_t count, double density, uint64_t seed,
+                           bool withNormals) {
+	std::vector<const GeneratedModel*> modelPtrs;
+	modelPtrs.reserve(models.size());
+	for (const auto& m : models)
+		modelPtrs.push_back(&m);
+	return samplePoints(modelPtrs, count, density, seed, withNormals);
+}
+
+/**
+ * world-space origin (min corner), voxel size and dimensions (x, y, z) of the grid plus either the occupied voxel
+ * indices as (n, 3) array or the bit-packed occupancy as (z, y, ceil(x / 8)) array, which
+ * numpy.unpackbits(occupancy, axis=-1, count=dims[0], bitorder='little') turns into a (z, y, x) bool grid
+ */
+py::dict toVoxelGridDict(const pcu::VoxelGrid& grid, bool sparse) {
+	py::dict result;
+	result["origin"] = py::make_tuple(grid.origin[0], grid.origin[1], grid.origin[2]);
+	result["voxel_size"] = grid.voxelSize;
+	result["dims"] = py::make_tuple(grid.dims[0], grid.dims[1], grid.dims[2]);
+	if (sparse) {
+		const std::vector<uint32_t> voxels = grid.getOccupiedVoxels();
+		const std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(voxels.size() / 3), 3};
+		result["voxels"] = py::array_t<uint32_t>(shape, voxels.data());
+	}
+	else {
+		const std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(grid.dims[2]),
+		                                        static_cast<py::ssize_t>(grid.dims[1]),
+		                                        static_cast<py::ssize_t>(grid.getRowBytes())};
+		result["occupancy"] = py::array_t<uint8_t>(shape, grid.bits.data());
+	}
+	return result;
+}
+
+py::dict voxelizeModel(const GeneratedModel& model, double voxelSize, bool solid, bool sparse) {
+	std::vector<double> translated;
+	const pcu::MeshView mesh = getInputMeshView(model, translated);
+	pcu::VoxelizationOptions options;
+	options.voxelSize = voxelSize;
+	options.solid = solid;
+	pcu::VoxelGrid grid;
+	{
+		py::gil_scoped_release release;
+		grid = pcu::voxelizeMesh(mesh, options);
+	}
+	return toVoxelGridDict(grid, sparse);
+}
+
+py::list voxelizeModels(const std::vector<GeneratedModel>& models, double voxelSize, bool solid, bool sparse) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	pcu::VoxelizationOptions options;
+	options.voxelSize = voxelSize;
+	options.solid = solid;
+	std::vector<pcu::VoxelGrid> grids;
+	{
+		py::gil_scoped_release release;
+		grids = pcu::voxelizeMeshes(meshes, options);
+	}
+	py::list result;
+	for (const auto& grid : grids)
+		result.append(toVoxelGridDict(grid, sparse));
+	return result;
+}
+
+py::dict voxelizeModelTile(const std::vector<GeneratedModel>& models, const std::array<double, 3>& origin,
+                           const std::array<size_t, 3>& dims, double voxelSize, bool solid, bool sparse) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	pcu::VoxelizationOptions options;
+	options.voxelSize = voxelSize;
+	options.solid = solid;
+	pcu::VoxelGrid grid;
+	{
+		py::gil_scoped_release release;
+		grid = pcu::voxelizeTile(meshes, options, origin, dims);
+	}
+	return toVoxelGridDict(grid, sparse);
+}
+
+/**
+ * DSM of the generated models on a (rows, columns) grid in the xz plane: the maximum height (y) at each cell center
+ * as float32 raster (NaN where there is no geometry) and optionally the initial shape index of the model defining it
+ * (-1 where there is none). Rows run along z starting at origin = (x, z).
+ */
+py::dict rasterizeHeightMap(const std::vector<GeneratedModel>& models, const std::array<double, 2>& origin,
+                            const std::array<size_t, 2>& dims, double cellSize, bool withIds) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	std::vector<int32_t> meshIds;
+	meshIds.reserve(models.size());
+	for (const auto& m : models)
+		meshIds.push_back(static_cast<int32_t>(m.getInitialShapeIndex()));
+
+	pcu::HeightMapSpec spec;
+	spec.origin = origin;
+	spec.cellSize = cellSize;
+	spec.rows = dims[0];
+	spec.columns = dims[1];
+
+	const std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(spec.rows),
+	                                        static_cast<py::ssize_t>(spec.columns)};
+	py::array_t<float> heights(shape);
+	py::array_t<int32_t> ids;
+	if (withIds)
+		ids = py::array_t<int32_t>(shape);
+	float* heightData = heights.mutable_data();
+	int32_t* idData = withIds ? ids.mutable_data() : nullptr;
+	{
+		py::gil_scoped_release release;
+		pcu::rasterizeHeightMap(meshes, meshIds, spec, heightData, idData);
+	}
+
+	py::dict result;
+	result["origin"] = py::make_tuple(origin[0], origin[1]);
+	result["cell_size"] = cellSize;
+	result["heights"] = heights;
+	if (withIds)
+		result["ids"] = ids;
+	return result;
+}
+
+/**
+ * native mesh export of generated models, the writers run without holding the GIL
+ */
+template <typename W>
+bool writeMeshes(const std::string& path, W&& writer) {
+	std::string error;
+	{
+		py::gil_scoped_release release;
+		try {
+			writer();
 		}
-		else {
-			const std::filesystem::path outputPath = geometryEncoderOptions["outputPath"].cast<std::string>();
-			LOG_DBG << "got outputPath = " << outputPath;
+		catch (const std::exception& e) {
+			error = e.what();
+		}
+	}
+	if (!error.empty()) {
+		LOG_ERR << error;
+		return false;
+	}
+	LOG_DBG << "wrote " << path;
+	return true;
+}
 
-			pcu::FileOutputCallbacksPtr foc;
-			if (std::filesystem::is_directory(outputPath) && std::filesystem::exists(outputPath)) {
-				foc.reset(prt::FileOutputCallbacks::create(outputPath.wstring().c_str()));
-			}
-			else {
-				LOG_ERR << "The directory specified by 'outputPath' is not valid or does not exist: " << outputPath
-				        << std::endl;
-				return {};
-			}
+bool writeOBJ(const std::vector<GeneratedModel>& models, const std::string& path, int precision) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	std::vector<std::string> names;
+	names.reserve(models.size());
+	for (const auto& m : models)
+		names.push_back("shape_" + std::to_string(m.getInitialShapeIndex()));
+	return writeMeshes(path, [&]() { pcu::writeOBJ(path, meshes, names, precision); });
+}
 
-			// Generate
-			const prt::Status genStat =
-			        prt::generate(initialShapes.data(), initialShapes.size(), nullptr, encoders.data(), encoders.size(),
-			                      encodersOptions.data(), foc.get(), mCache.get(), nullptr);
+bool writePLY(const std::vector<GeneratedModel>& models, const std::string& path) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	return writeMeshes(path, [&]() { pcu::writePLY(path, meshes); });
+}
 
-			if (genStat != prt::STATUS_OK) {
-				LOG_ERR << "prt::generate() failed with status: '" << prt::getStatusDescription(genStat) << "' ("
-				        << genStat << ")";
-				return {};
-			}
+bool writeSTL(const std::vector<GeneratedModel>& models, const std::string& path) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	return writeMeshes(path, [&]() { pcu::writeSTL(path, meshes); });
+}
 
-			return {};
+// translated keeps the vertices of the models with an offset, see getInputMeshView
+std::vector<pcu::ModelRecord> getModelRecords(const std::vector<GeneratedModel>& models,
+                                              std::vector<std::vector<double>>& translated) {
+	const std::vector<pcu::MeshView> meshes = getInputMeshViews(models, translated);
+	std::vector<pcu::ModelRecord> records(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		records[i].initialShapeIndex = models[i].getInitialShapeIndex();
+		records[i].mesh = meshes[i];
+		records[i].reports = &models[i].getReports();
+	}
+	return records;
+}
+
+void appendArrowRecords(pcu::ArrowWriter& writer, const std::vector<GeneratedModel>& models) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::ModelRecord> records = getModelRecords(models, translated);
+	py::gil_scoped_release release;
+	writer.write(records);
+}
+
+bool writeArrow(const std::vector<GeneratedModel>& models, const std::string& path, bool includeGeometry,
+                size_t batchSize) {
+	std::vector<std::vector<double>> translated;
+	const std::vector<pcu::ModelRecord> records = getModelRecords(models, translated);
+	pcu::ArrowWriter::Options options;
+	options.includeGeometry = includeGeometry;
+	options.batchSize = batchSize;
+	return writeMeshes(path, [&]() {
+		pcu::ArrowWriter writer(path, options);
+		writer.write(records);
+		writer.close();
+	});
+}
+
+/**
+ * rule file introspection, the rule info is read once per rule package and rule file and then served from the cache
+ */
+py::list toPython(const std::vector<pcu::RuleAnnotation>& annotations) {
+	py::list list;
+	for (const auto& an : annotations) {
+		py::list arguments;
+		for (const auto& arg : an.arguments) {
+			py::dict argument;
+			argument["key"] = arg.key;
+			if (arg.type == prt::AAT_BOOL)
+				argument["value"] = arg.boolValue;
+			else if (arg.type == prt::AAT_FLOAT)
+				argument["value"] = arg.floatValue;
+			else if (arg.type == prt::AAT_STR)
+				argument["value"] = arg.stringValue;
+			else
+				argument["value"] = py::none();
+			arguments.append(argument);
 		}
+		py::dict annotation;
+		annotation["name"] = an.name;
+		annotation["arguments"] = arguments;
+		list.append(annotation);
 	}
-	catch (const std::exception& e) {
-		LOG_ERR << "caught exception: " << e.what();
-		return {};
+	return list;
+}
+
+py::list toPython(const std::vector<pcu::RuleEntry>& entries) {
+	py::list list;
+	for (const auto& e : entries) {
+		py::list parameters;
+		for (const auto& p : e.parameters)
+			parameters.append(py::make_tuple(p.name, pcu::getTypeName(p.type)));
+		py::dict entry;
+		entry["name"] = e.name;
+		entry["type"] = pcu::getTypeName(e.type);
+		entry["parameters"] = parameters;
+		entry["annotations"] = toPython(e.annotations);
+		list.append(entry);
 	}
-	catch (...) {
-		LOG_ERR << "caught unknown exception.";
+	return list;
+}
+
+py::dict getRuleInfo(const std::string& rulePackagePath, const std::wstring& ruleFile) {
+	if (!isPRTInitialized()) {
+		LOG_ERR << "prt has not been initialized.";
 		return {};
 	}
+	const pcu::RuleInfoPtr info = pcu::getRuleInfoCache().get(rulePackagePath, ruleFile, nullptr, nullptr);
+	if (!info)
+		return {};
 
-	return newGeneratedGeo;
+	py::dict ruleInfo;
+	ruleInfo["rule_file"] = info->ruleFile;
+	ruleInfo["attributes"] = toPython(info->attributes);
+	ruleInfo["rules"] = toPython(info->rules);
+	ruleInfo["start_rules"] = info->getStartRules();
+	ruleInfo["annotations"] = toPython(info->annotations);
+	return ruleInfo;
 }
 
-std::vector<GeneratedModel> ModelGenerator::generateAnotherModel(const std::vector<py::dict>& shapeAttributes) {
-	if (!mResolveMap) {
-		LOG_ERR << "generate model with all required parameters";
+std::string extractRPK(const std::string& rulePackagePath, const std::string& cacheDirectory) {
+	if (!isPRTInitialized()) {
+		LOG_ERR << "prt has not been initialized.";
 		return {};
 	}
-	else
-		return generateModel(shapeAttributes, "", L"", {});
+
+	std::string extractedPath;
+	std::string error;
+	{
+		py::gil_scoped_release release;
+		try {
+			extractedPath = pcu::extractRulePackage(rulePackagePath, cacheDirectory);
+		}
+		catch (const std::exception& e) {
+			error = e.what();
+		}
+	}
+	if (!error.empty())
+		LOG_ERR << "could not extract rule package " << rulePackagePath << ": " << error;
+	return extractedPath;
+}
+
+/**
+ * bulk creation of initial shapes from well-known binary/text, the parsers run in parallel without holding the GIL
+ */
+InitialShapeBatch initialShapesFromWKB(const std::vector<py::buffer>& geometries) {
+	std::vector<py::buffer_info> buffers;
+	std::vector<pcu::ByteRange> ranges;
+	buffers.reserve(geometries.size());
+	ranges.reserve(geometries.size());
+	for (const auto& g : geometries) {
+		buffers.push_back(g.request());
+		const auto& b = buffers.back();
+		ranges.push_back({static_cast<const uint8_t*>(b.ptr), static_cast<size_t>(b.size * b.itemsize)});
+	}
+
+	std::vector<pcu::ParsedShape> shapes;
+	{
+		py::gil_scoped_release release;
+		shapes = pcu::parseWKB(ranges);
+	}
+	return InitialShapeBatch(std::move(shapes));
+}
+
+InitialShapeBatch initialShapesFromPackedWKB(const py::buffer& data, const py::array_t<uint64_t>& offsets) {
+	const py::buffer_info buffer = data.request();
+	const size_t dataSize = static_cast<size_t>(buffer.size * buffer.itemsize);
+	const uint8_t* dataPtr = static_cast<const uint8_t*>(buffer.ptr);
+
+	const auto o = offsets.unchecked<1>();
+	std::vector<pcu::ByteRange> ranges;
+	for (py::ssize_t i = 0; i + 1 < o.shape(0); i++) {
+		if (o(i) > o(i + 1) || o(i + 1) > dataSize) {
+			LOG_ERR << "invalid WKB offsets: entry " << i << " is out of range";
+			return InitialShapeBatch(std::vector<pcu::ParsedShape>());
+		}
+		ranges.push_back({dataPtr + o(i), static_cast<size_t>(o(i + 1) - o(i))});
+	}
+
+	std::vector<pcu::ParsedShape> shapes;
+	{
+		py::gil_scoped_release release;
+		shapes = pcu::parseWKB(ranges);
+	}
+	return InitialShapeBatch(std::move(shapes));
+}
+
+InitialShapeBatch initialShapesFromWKT(const std::vector<std::string>& geometries) {
+	std::vector<pcu::ParsedShape> shapes;
+	{
+		py::gil_scoped_release release;
+		shapes = pcu::parseWKT(geometries);
+	}
+	return InitialShapeBatch(std::move(shapes));
+}
+
+InitialShapeBatch initialShapesFromOBJ(const std::string& path, bool splitGroups) {
+	std::vector<pcu::ParsedShape> shapes;
+	std::string error;
+	{
+		py::gil_scoped_release release;
+		try {
+			shapes = pcu::parseOBJFile(path, splitGroups);
+		}
+		catch (const std::exception& e) {
+			error = e.what();
+		}
+	}
+	if (!error.empty())
+		LOG_ERR << "could not read initial shapes from " << path << ": " << error;
+	return InitialShapeBatch(std::move(shapes));
 }
 
 } // namespace
@@ -376,11 +1122,44 @@ std::vector<GeneratedModel> ModelGenerator::generateAnotherModel(const std::vect
 using namespace pybind11::literals;
 
 PYBIND11_MODULE(pyprt, m) {
-	py::bind_vector<std::vector<GeneratedModel>>(m, "GeneratedModelVector", py::module_local(false));
+	py::bind_vector<std::vector<GeneratedModel>>(m, "GeneratedModelVector", py::module_local(false))
+	        .def("get_mesh_arrays", &getMeshArrays, py::arg("vertexLayout") = "aos")
+	        .def("get_report_columns", &getReportColumns)
+	        .def("get_edge_adjacencies", &getEdgeAdjacencies, py::arg("weld") = true)
+	        .def("sample_points", &sampleBatchPoints, py::arg("count") = 0, py::arg("density") = 0.0,
+	             py::arg("seed") = 0, py::arg("normals") = false)
+	        .def("voxelize", &voxelizeModels, py::arg("voxelSize"), py::arg("solid") = false,
+	             py::arg("sparse") = false)
+	        .def("voxelize_tile", &voxelizeModelTile, py::arg("origin"), py::arg("dims"), py::arg("voxelSize"),
+	             py::arg("solid") = false, py::arg("sparse") = false)
+	        .def("rasterize_height_map", &rasterizeHeightMap, py::arg("origin"), py::arg("dims"), py::arg("cellSize"),
+	             py::arg("ids") = false);
 
 	m.def("initialize_prt", &initializePRT);
 	m.def("is_prt_initialized", &isPRTInitialized);
 	m.def("shutdown_prt", &shutdownPRT);
+	m.def("get_rule_info", &getRuleInfo, py::arg("rulePackagePath"), py::arg("ruleFile") = std::wstring());
+	m.def("extract_rpk", &extractRPK, py::arg("rulePackagePath"), py::arg("cacheDirectory"));
+
+	m.def("write_obj", &writeOBJ, py::arg("models"), py::arg("path"), py::arg("precision") = 6);
+	m.def("write_ply", &writePLY, py::arg("models"), py::arg("path"));
+	m.def("write_stl", &writeSTL, py::arg("models"), py::arg("path"));
+	m.def("write_arrow", &writeArrow, py::arg("models"), py::arg("path"), py::arg("includeGeometry") = false,
+	      py::arg("batchSize") = 4096);
+
+	py::class_<pcu::ArrowWriter>(m, "ArrowWriter")
+	        .def(py::init([](const std::string& path, bool includeGeometry, size_t batchSize) {
+		             pcu::ArrowWriter::Options options;
+		             options.includeGeometry = includeGeometry;
+		             options.batchSize = batchSize;
+		             return new pcu::ArrowWriter(path, options);
+	             }),
+	             py::arg("path"), py::arg("includeGeometry") = false, py::arg("batchSize") = 4096)
+	        .def("write", &appendArrowRecords, py::arg("models"))
+	        .def("close", &pcu::ArrowWriter::close)
+	        .def("get_row_count", &pcu::ArrowWriter::getRowCount)
+	        .def("__enter__", [](py::object self) { return self; })
+	        .def("__exit__", [](pcu::ArrowWriter& writer, py::args) { writer.close(); });
 
 	py::class_<InitialShape>(m, "InitialShape")
 	        .def(py::init<const std::vector<double>&>())
@@ -391,16 +1170,89 @@ PYBIND11_MODULE(pyprt, m) {
 	        .def("get_face_counts_count", &InitialShape::getFaceCountsCount)
 	        .def("get_path", &InitialShape::getPath);
 
+	m.def("initial_shapes_from_wkb", &initialShapesFromWKB, py::arg("geometries"));
+	m.def("initial_shapes_from_wkb", &initialShapesFromPackedWKB, py::arg("data"), py::arg("offsets"));
+	m.def("initial_shapes_from_wkt", &initialShapesFromWKT, py::arg("geometries"));
+	m.def("initial_shapes_from_obj", &initialShapesFromOBJ, py::arg("path"), py::arg("splitGroups") = false);
+
+	py::class_<InitialShapeBatch>(m, "InitialShapeBatch")
+	        .def("__len__", &InitialShapeBatch::size)
+	        .def("get_source_indices", &InitialShapeBatch::getSourceIndices)
+	        .def("get_names", &InitialShapeBatch::getNames)
+	        .def("get_errors", &InitialShapeBatch::getErrors)
+	        .def("get_dropped_hole_count", &InitialShapeBatch::getDroppedHoleCount);
+
+	py::class_<pcu::ShapeDiagnostics>(m, "ShapeDiagnostics")
+	        .def_readonly("checked", &pcu::ShapeDiagnostics::checked)
+	        .def_property_readonly("valid", &pcu::ShapeDiagnostics::isValid)
+	        .def_property_readonly("issues",
+	                               [](const pcu::ShapeDiagnostics& d) {
+		                               return pcu::ShapeDiagnostics::getIssueNames(d.issues);
+	                               })
+	        .def_property_readonly("repaired",
+	                               [](const pcu::ShapeDiagnostics& d) {
+		                               return pcu::ShapeDiagnostics::getIssueNames(d.repaired);
+	                               })
+	        .def_readonly("removed_vertices", &pcu::ShapeDiagnostics::removedVertices)
+	        .def_readonly("removed_faces", &pcu::ShapeDiagnostics::removedFaces)
+	        .def_readonly("flipped_faces", &pcu::ShapeDiagnostics::flippedFaces)
+	        .def_readonly("simplified_vertices", &pcu::ShapeDiagnostics::simplifiedVertices);
+
 	py::class_<ModelGenerator>(m, "ModelGenerator")
-	        .def(py::init<const std::vector<InitialShape>&>(), "initShape"_a)
+	        .def(py::init<const std::vector<InitialShape>&, const py::dict&>(), "initShape"_a,
+	             "preparationOptions"_a = py::dict())
+	        .def(py::init<const InitialShapeBatch&, const py::dict&>(), "initShapes"_a,
+	             "preparationOptions"_a = py::dict())
+	        .def("get_shape_diagnostics", &ModelGenerator::getShapeDiagnostics)
+	        .def("get_preparation_stats", &ModelGenerator::getPreparationStats)
+	        .def("get_context_attributes", &ModelGenerator::getContextAttributes)
+	        .def("set_categorical_attributes", &ModelGenerator::setCategoricalAttributes, py::arg("columns"))
 	        .def("generate_model", &ModelGenerator::generateModel, py::arg("shapeAttributes"),
 	             py::arg("rulePackagePath"), py::arg("geometryEncoderName"), py::arg("geometryEncoderOptions"))
-	        .def("generate_model", &ModelGenerator::generateAnotherModel, py::arg("shapeAttributes"));
+	        .def("generate_model", &ModelGenerator::generateAnotherModel, py::arg("shapeAttributes"))
+	        .def("evaluate_attributes", &ModelGenerator::evaluateAttributes, py::arg("shapeAttributes"),
+	             py::arg("rulePackagePath") = std::string())
+	        .def("prefetch_assets", &ModelGenerator::prefetchAssets, py::arg("rulePackagePath") = std::string())
+	        .def("reload_rule_package", &ModelGenerator::reloadRulePackage, py::arg("force") = false)
+	        .def("watch_rule_package", &ModelGenerator::watchRulePackage, py::arg("enabled") = true);
 
 	py::class_<GeneratedModel>(m, "GeneratedModel")
 	        .def("get_initial_shape_index", &GeneratedModel::getInitialShapeIndex)
 	        .def("get_vertices", &GeneratedModel::getVertices)
 	        .def("get_indices", &GeneratedModel::getIndices)
 	        .def("get_faces", &GeneratedModel::getFaces)
-	        .def("get_report", &GeneratedModel::getReport);
+	        .def("get_report", &getReport)
+	        .def("get_leaf_attributes", &getLeafAttributes)
+	        .def("get_offset", &GeneratedModel::getOffset)
+	        .def("get_face_class_areas", &getFaceClassAreas)
+	        .def("get_edge_adjacency", &getEdgeAdjacency, py::arg("weld") = true)
+	        .def("sample_points", &sampleModelPoints, py::arg("count") = 0, py::arg("density") = 0.0,
+	             py::arg("seed") = 0, py::arg("normals") = false)
+	        .def("voxelize", &voxelizeModel, py::arg("voxelSize"), py::arg("solid") = false, py::arg("sparse") = false)
+	        .def("get_vertices_array",
+	             [](py::object self) {
+		             return toVertexArrayView(self.cast<const GeneratedModel&>().getVertices(), self);
+	             })
+	        .def("get_vertex_component_arrays",
+	             [](py::object self) {
+		             const pcu::VertexComponents& c = self.cast<const GeneratedModel&>().getVertexComponents();
+		             return py::make_tuple(toArrayView(c[0], self), toArrayView(c[1], self),
+		                                   toArrayView(c[2], self));
+	             })
+	        .def("get_indices_array",
+	             [](py::object self) { return toArrayView(self.cast<const GeneratedModel&>().getIndices(), self); })
+	        .def("get_faces_array",
+	             [](py::object self) { return toArrayView(self.cast<const GeneratedModel&>().getFaces(), self); })
+	        .def("get_face_offsets",
+	             [](py::object self) {
+		             return toArrayView(self.cast<const GeneratedModel&>().getFaceOffsets(), self);
+	             })
+	        .def("get_face_classes_array",
+	             [](py::object self) {
+		             return toArrayView(self.cast<const GeneratedModel&>().getFaceClasses(), self);
+	             });
+
+	m.attr("FACE_CLASS_ROOF") = static_cast<int>(FACE_CLASS_ROOF);
+	m.attr("FACE_CLASS_WALL") = static_cast<int>(FACE_CLASS_WALL);
+	m.attr("FACE_CLASS_GROUND") = static_cast<int>(FACE_CLASS_GROUND);
 }
@@ -17,14 +17,13 @@
  * A copy of the license is available in the repository's LICENSE file.
  */
 
-#include "PyCallbacks.h"
+#include "generator.h"
 #include "logging.h"
-#include "utils.h"
+#include "objFootprints.h"
+#include "wellKnownGeometry.h"
 
 #include "prt/API.h"
-#include "prt/ContentType.h"
 #include "prt/LogLevel.h"
-#include "prt/prt.h"
 
 #include <pybind11/complex.h>
 #include <pybind11/functional.h>
@@ -34,13 +33,8 @@
 #include <array>
 #include <cstdio>
 #include <cstdlib>
-#include <filesystem>
-#include <fstream>
-#include <functional>
-#include <iostream>
-#include <iterator>
-#include <map>
-#include <numeric>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 #ifdef _WIN32
@@ -69,6 +63,8 @@ public:
 	virtual ~PythonLogHandler() = default;
 
 	virtual void handleLogEvent(const wchar_t* msg, prt::LogLevel /*level*/) {
+		// log events can come from native worker threads which do not hold the GIL
+		pybind11::gil_scoped_acquire acquire;
 		pybind11::print(L"[PRT]", msg);
 	}
 
@@ -101,117 +97,16 @@ private:
 	size_t mCount;
 };
 
-/**
- * Helper struct to manage PRT lifetime (e.g. the prt::init() call)
- */
-struct PRTContext {
-	PRTContext(prt::LogLevel minimalLogLevel) {
-		prt::addLogHandler(&mLogHandler);
-
-		// setup path for PRT extension libraries
-		const std::filesystem::path moduleRoot = pcu::getModuleDirectory().parent_path();
-		const auto prtExtensionPath = moduleRoot / "lib";
-
-		// initialize PRT with the path to its extension libraries, the default log
-		// level
-		const std::wstring wExtPath = prtExtensionPath.wstring();
-		const std::array<const wchar_t*, 1> extPaths = {wExtPath.c_str()};
-		mPRTHandle.reset(prt::init(extPaths.data(), extPaths.size(), minimalLogLevel));
-	}
-
-	~PRTContext() {
-		// shutdown PRT
-		mPRTHandle.reset();
-
-		// remove loggers
-		prt::removeLogHandler(&mLogHandler);
-	}
-
-	explicit operator bool() const {
-		return (bool)mPRTHandle;
-	}
-
-	PythonLogHandler mLogHandler;
-	pcu::ObjectPtr mPRTHandle;
-};
-
-class InitialShape {
-public:
-	InitialShape(const std::vector<double>& vert);
-	InitialShape(const std::vector<double>& vert, const std::vector<uint32_t>& ind,
-	             const std::vector<uint32_t>& faceCnt);
-	InitialShape(const std::string& path);
-	~InitialShape() {}
-
-	const double* getVertices() const {
-		return mVertices.data();
-	}
-	size_t getVertexCount() const {
-		return mVertices.size();
-	}
-	const uint32_t* getIndices() const {
-		return mIndices.data();
-	}
-	size_t getIndexCount() const {
-		return mIndices.size();
-	}
-	const uint32_t* getFaceCounts() const {
-		return mFaceCounts.data();
-	}
-	size_t getFaceCountsCount() const {
-		return mFaceCounts.size();
-	}
-	const std::string& getPath() const {
-		return mPath;
-	}
-	bool getPathFlag() const {
-		return mPathFlag;
-	}
-
-protected:
-	const std::vector<double> mVertices;
-	std::vector<uint32_t> mIndices;
-	std::vector<uint32_t> mFaceCounts;
-	const std::string mPath;
-	const bool mPathFlag;
-};
-
-class GeneratedModel {
-public:
-	GeneratedModel(const size_t& initialShapeIdx, const std::vector<double>& vert, const std::vector<uint32_t>& indices,
-	               const std::vector<uint32_t>& face, const py::dict& rep);
-	GeneratedModel() {}
-	~GeneratedModel() {}
-
-	size_t getInitialShapeIndex() const {
-		return mInitialShapeIndex;
-	}
-	const std::vector<double>& getVertices() const {
-		return mVertices;
-	}
-	const std::vector<uint32_t>& getIndices() const {
-		return mIndices;
-	}
-	const std::vector<uint32_t>& getFaces() const {
-		return mFaces;
-	}
-	const py::dict& getReport() const {
-		return mReport;
-	}
-
-private:
-	size_t mInitialShapeIndex;
-	std::vector<double> mVertices;
-	std::vector<uint32_t> mIndices;
-	std::vector<uint32_t> mFaces;
-	py::dict mReport;
-};
-
 namespace {
 
+/**
+ * Python front end of the native generator: converts the dictionaries into attribute maps and releases the GIL while
+ * the generator runs
+ */
 class ModelGenerator {
 public:
-	ModelGenerator(const std::vector<InitialShape>& myGeo);
+	ModelGenerator(const std::vector<InitialShape>& myGeo, const py::dict& preparationOptions = {});
+	ModelGenerator(const InitialShapeBatch& batch, const py::dict& preparationOptions = {});
 	~ModelGenerator() {}
 
 	std::vector<GeneratedModel> generateModel(const std::vector<py::dict>& shapeAttributes,
@@ -220,29 +115,36 @@ public:
 	                                          const py::dict& geometryEcoderOptions);
 	std::vector<GeneratedModel> generateAnotherModel(const std::vector<py::dict>& shapeAttributes);
 
+	// evaluated rule attributes per initial shape as columns (no geometry is generated)
+	py::dict evaluateAttributes(const std::vector<py::dict>& shapeAttributes, const std::string& rulePackagePath);
+
+	const std::vector<pcu::ShapeDiagnostics>& getShapeDiagnostics() const {
+		return mGenerator->getShapeDiagnostics();
+	}
+	// face vertex counts before and after the preparation stages
+	py::dict getPreparationStats() const;
+	// computed neighborhood metrics as {attribute name: value per shape}
+	py::dict getContextAttributes() const;
+
+	// string attributes as (codes, categories) per key, applied to all following generations
+	bool setCategoricalAttributes(const py::dict& columns);
+
+	// resolves the assets of the rule package into the cache before generating, returns counts, time and errors
+	py::dict prefetchAssets(const std::string& rulePackagePath);
+
+	// loads the current content of the rule package if it changed (or always if forced), true if a new version is used
+	// (waits for a running generation, which finishes with the version it started with)
+	bool reloadRulePackage(bool force);
+	// check for a changed rule package before each generation which reuses the loaded one
+	void watchRulePackage(bool enabled) {
+		py::gil_scoped_release release;
+		mGenerator->watchRulePackage(enabled);
+	}
+
 private:
-	pcu::ResolveMapPtr mResolveMap;
-	pcu::CachePtr mCache;
-
-	pcu::AttributeMapBuilderPtr mEncoderBuilder;
-	std::vector<pcu::AttributeMapPtr> mEncodersOptionsPtr;
-	std::vector<std::wstring> mEncodersNames;
-	std::vector<pcu::InitialShapeBuilderPtr> mInitialShapesBuilders;
-
-	std::wstring mRuleFile = L"bin/rule.cgb";
-	std::wstring mStartRule = L"default$init";
-	int32_t mSeed = 666;
-	std::wstring mShapeName = L"InitialShape";
-
-	bool mValid = true;
-
-	void setAndCreateInitialShape(const std::vector<py::dict>& shapeAttr,
-	                              std::vector<const prt::InitialShape*>& initShapes,
-	                              std::vector<pcu::InitialShapePtr>& initShapesPtrs,
-	                              std::vector<pcu::AttributeMapPtr>& convertShapeAttr);
-	void initializeEncoderData(const std::wstring& encName, const py::dict& encOpt);
-	void getRawEncoderDataPointers(std::vector<const wchar_t*>& allEnc,
-	                               std::vector<const prt::AttributeMap*>& allEncOpt);
+	std::unique_ptr<Generator> mGenerator;
+
+	void createGenerator(const std::vector<InitialShape>& myGeo, const py::dict& preparationOptions);
 };
 
 } // namespace
@@ -21,6 +21,11 @@
 
 #include "prt/Callbacks.h"
 
+#include <cstdint>
+
+// orientation classes of the faces reported with addFaceClasses
+enum FaceClass : uint8_t { FACE_CLASS_ROOF, FACE_CLASS_WALL, FACE_CLASS_GROUND, FACE_CLASS_COUNT };
+
 class IPyCallbacks : public prt::Callbacks {
 public:
 	virtual ~IPyCallbacks() override = default;
@@ -29,8 +34,39 @@ public:
 	                         const uint32_t* faceIndices, const size_t faceIndicesCount, const uint32_t* faceCounts,
 	                         const size_t faceCountsCount) = 0;
 
+	/**
+	 * Same as addGeometry, but the vertex coordinates are given as separate x, y and z arrays of vertexCount values
+	 * each (vertexLayout encoder option "soa").
+	 */
+	virtual void addGeometryComponents(const size_t initialShapeIndex, const double* x, const double* y,
+	                                   const double* z, const size_t vertexCount, const uint32_t* faceIndices,
+	                                   const size_t faceIndicesCount, const uint32_t* faceCounts,
+	                                   const size_t faceCountsCount) = 0;
+
+	/**
+	 * Orientation class of each face added with the preceding addGeometry call, and the total area of these faces per
+	 * class (FACE_CLASS_COUNT values). Only with the faceClasses encoder option.
+	 */
+	virtual void addFaceClasses(const size_t initialShapeIndex, const uint8_t* faceClasses, const size_t faceCount,
+	                            const double* classAreas) = 0;
+
 	virtual void addReports(const size_t initialShapeIndex, const wchar_t** stringReportKeys,
 	                        const wchar_t** stringReportValues, size_t stringReportCount,
 	                        const wchar_t** floatReportKeys, const double* floatReportValues, size_t floatReportCount,
 	                        const wchar_t** boolReportKeys, const bool* boolReportValues, size_t boolReportCount) = 0;
+
+	/**
+	 * Evaluated attributes of the leaf shapes, only for the keys requested with the leafAttributes encoder option.
+	 * Each value is reported as (shape ID, key index, value) tuple in the arrays of its type, the key index refers to
+	 * keys.
+	 */
+	virtual void addLeafAttributes(const size_t initialShapeIndex, const wchar_t* const* keys, size_t keyCount,
+	                               const int32_t* boolShapeIDs, const uint32_t* boolKeyIndices, const bool* boolValues,
+	                               size_t boolCount, const int32_t* floatShapeIDs, const uint32_t* floatKeyIndices,
+	                               const double* floatValues, size_t floatCount, const int32_t* stringShapeIDs,
+	                               const uint32_t* stringKeyIndices, const wchar_t* const* stringValues,
+	                               size_t stringCount) = 0;
+
+	// offset which was subtracted from the initial shape (recentering), nullptr if there is none
+	virtual const double* getOffset(const size_t initialShapeIndex) const = 0;
 };
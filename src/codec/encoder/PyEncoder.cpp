@@ -17,8 +17,10 @@
  * A copy of the license is available in the repository's LICENSE file.
  */
 
+#include "CpuDispatch.h"
 #include "IPyCallbacks.h"
 #include "PyEncoder.h"
+#include "vertexTransforms.h"
 
 #include "prtx/Attributable.h"
 #include "prtx/EncodeOptions.h"
@@ -32,8 +34,14 @@
 #include "prtx/ShapeIterator.h"
 #include "prtx/prtx.h"
 
+#include "prt/API.h"
+#include "prt/LogLevel.h"
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -45,6 +53,27 @@ const wchar_t* EO_ERROR_FALLBACK = L"errorFallback";
 const std::wstring ENCFILE_EXT = L".txt";
 const wchar_t* EO_EMIT_REPORT = L"emitReport";
 const wchar_t* EO_EMIT_GEOMETRY = L"emitGeometry";
+const wchar_t* EO_RESTORE_OFFSETS = L"restoreOffsets";
+const wchar_t* EO_LEAF_ATTRIBUTES = L"leafAttributes";
+const wchar_t* EO_TRIANGULATE = L"triangulate";
+const wchar_t* EO_VERTEX_LAYOUT = L"vertexLayout";
+const wchar_t* EO_FACE_CLASSES = L"faceClasses";
+const wchar_t* EO_FACE_CLASS_THRESHOLD = L"faceClassThreshold";
+const wchar_t* EO_MERGE_VERTICES = L"mergeVertices";
+const std::wstring VERTEX_LAYOUT_AOS = L"aos";
+const std::wstring VERTEX_LAYOUT_SOA = L"soa";
+
+// output options as bits of the encode kernel template parameter
+enum EncodeFlags : uint32_t {
+	EMIT_REPORT = 1u << 0,
+	EMIT_GEOMETRY = 1u << 1,
+	RESTORE_OFFSETS = 1u << 2,
+	LEAF_ATTRIBUTES = 1u << 3,
+	TRIANGULATE = 1u << 4,
+	SEPARATE_VERTEX_COMPONENTS = 1u << 5,
+	FACE_CLASSES = 1u << 6,
+	ENCODE_FLAG_COMBINATIONS = 1u << 7
+};
 
 const prtx::EncodePreparator::PreparationFlags ENC_PREP_FLAGS =
         prtx::EncodePreparator::PreparationFlags()
@@ -55,6 +84,226 @@ const prtx::EncodePreparator::PreparationFlags ENC_PREP_FLAGS =
                 .cleanupVertexNormals(false)
                 .mergeByMaterial(true); // if false, generation takes ages... 40 sec
                                         // instead of 1.5 sec
+
+// adds the recentering offset back to the separate x, y and z blocks of the "soa" vertex layout
+PYPRT_CPU_DISPATCH void translateVertexComponents(std::vector<double>& vertexCoords, const double* offset) {
+	const size_t vertexCount = vertexCoords.size() / 3;
+	for (size_t c = 0; c < 3; c++) {
+		const double o = offset[c];
+		double* v = vertexCoords.data() + c * vertexCount;
+		for (size_t i = 0; i < vertexCount; i++)
+			v[i] += o;
+	}
+}
+
+/**
+ * Classifies the faces by the y (up) component of their unit normal: above the threshold is roof, below the negative
+ * threshold ground, everything else wall. Normal and area come from the Newell vector of the face polygon (its length
+ * is twice the area), which also holds for non-planar and concave faces. Coordinate c of vertex v is read from
+ * vertices[v * vertexStride + c * componentStride] to support both vertex layouts, the indices are offset by
+ * indexBase. The area of each class is added to classAreas.
+ */
+PYPRT_CPU_DISPATCH void classifyFaces(const double* vertices, size_t vertexStride, size_t componentStride,
+                                      const uint32_t* faceIndices, const uint32_t* faceCounts, size_t faceCount,
+                                      uint32_t indexBase, double threshold, uint8_t* faceClasses,
+                                      double* classAreas) {
+	const double* xs = vertices;
+	const double* ys = vertices + componentStride;
+	const double* zs = vertices + 2 * componentStride;
+	for (size_t f = 0; f < faceCount; f++) {
+		const uint32_t count = faceCounts[f];
+		double nx = 0.0, ny = 0.0, nz = 0.0;
+		for (uint32_t i = 0; i < count; i++) {
+			const size_t a = (faceIndices[i] - indexBase) * vertexStride;
+			const size_t b = (faceIndices[i + 1 == count ? 0 : i + 1] - indexBase) * vertexStride;
+			nx += (ys[a] - ys[b]) * (zs[a] + zs[b]);
+			ny += (zs[a] - zs[b]) * (xs[a] + xs[b]);
+			nz += (xs[a] - xs[b]) * (ys[a] + ys[b]);
+		}
+		faceIndices += count;
+
+		const double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+		uint8_t faceClass = FACE_CLASS_WALL;
+		if (ny > threshold * length)
+			faceClass = FACE_CLASS_ROOF;
+		else if (ny < -threshold * length)
+			faceClass = FACE_CLASS_GROUND;
+		faceClasses[f] = faceClass;
+		classAreas[faceClass] += 0.5 * length;
+	}
+}
+
+/**
+ * Collects the values of the requested attributes on the leaf shapes of one initial shape. Only the requested keys
+ * are looked up, keys which are not set on a shape and array attributes are skipped.
+ */
+class LeafAttributeCollector {
+public:
+	explicit LeafAttributeCollector(const std::vector<std::wstring>& keys) : mKeys(keys) {}
+
+	void add(const prtx::Shape& shape) {
+		const int32_t shapeID = static_cast<int32_t>(shape.getID());
+		for (uint32_t k = 0; k < mKeys.size(); k++) {
+			switch (shape.getType(mKeys[k])) {
+				case prt::Attributable::PT_BOOL:
+					mBoolShapeIDs.push_back(shapeID);
+					mBoolKeyIndices.push_back(k);
+					mBoolValues.push_back(shape.getBool(mKeys[k]) != prtx::PRTX_FALSE);
+					break;
+				case prt::Attributable::PT_FLOAT:
+					mFloatShapeIDs.push_back(shapeID);
+					mFloatKeyIndices.push_back(k);
+					mFloatValues.push_back(shape.getFloat(mKeys[k]));
+					break;
+				case prt::Attributable::PT_STRING:
+					mStringShapeIDs.push_back(shapeID);
+					mStringKeyIndices.push_back(k);
+					mStringValues.push_back(shape.getString(mKeys[k]));
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	void emit(IPyCallbacks& cb, size_t initialShapeIndex) const {
+		std::vector<const wchar_t*> keys(mKeys.size());
+		for (size_t k = 0; k < mKeys.size(); k++)
+			keys[k] = mKeys[k].c_str();
+
+		const size_t boolCount = mBoolValues.size();
+		std::unique_ptr<bool[]> boolValues(new bool[boolCount]);
+		std::copy(mBoolValues.begin(), mBoolValues.end(), boolValues.get());
+
+		std::vector<const wchar_t*> stringValues(mStringValues.size());
+		for (size_t i = 0; i < mStringValues.size(); i++)
+			stringValues[i] = mStringValues[i].c_str();
+
+		cb.addLeafAttributes(initialShapeIndex, keys.data(), keys.size(), mBoolShapeIDs.data(),
+		                     mBoolKeyIndices.data(), boolValues.get(), boolCount, mFloatShapeIDs.data(),
+		                     mFloatKeyIndices.data(), mFloatValues.data(), mFloatValues.size(),
+		                     mStringShapeIDs.data(), mStringKeyIndices.data(), stringValues.data(),
+		                     stringValues.size());
+	}
+
+private:
+	const std::vector<std::wstring>& mKeys;
+	std::vector<int32_t> mBoolShapeIDs;
+	std::vector<uint32_t> mBoolKeyIndices;
+	std::vector<uint8_t> mBoolValues;
+	std::vector<int32_t> mFloatShapeIDs;
+	std::vector<uint32_t> mFloatKeyIndices;
+	std::vector<double> mFloatValues;
+	std::vector<int32_t> mStringShapeIDs;
+	std::vector<uint32_t> mStringKeyIndices;
+	std::vector<std::wstring> mStringValues;
+};
+
+void emitReports(IPyCallbacks& cb, prtx::GenerateContext& context, size_t initialShapeIndex) {
+	prtx::ReportsAccumulatorPtr reportsAccumulator{prtx::SummarizingReportsAccumulator::create()};
+	prtx::ReportingStrategyPtr reportsCollector{
+	        prtx::AllShapesReportingStrategy::create(context, initialShapeIndex, reportsAccumulator)};
+
+	prtx::ReportsPtr rep = reportsCollector->getReports();
+	if (!rep)
+		return;
+
+	const prtx::Shape::ReportBoolVect& boolReps = rep->mBools;
+	const size_t boolRepCount = boolReps.size();
+	std::vector<const wchar_t*> boolRepKeys(boolRepCount);
+	std::unique_ptr<bool[]> boolRepValues(new bool[boolRepCount]);
+
+	for (size_t i = 0; i < boolRepCount; i++) {
+		boolRepKeys[i] = boolReps[i].first->c_str();
+		boolRepValues[i] = boolReps[i].second;
+	}
+
+	const prtx::Shape::ReportFloatVect& floatReps = rep->mFloats;
+	const size_t floatRepCount = floatReps.size();
+	std::vector<const wchar_t*> floatRepKeys(floatRepCount);
+	std::vector<double> floatRepValues(floatRepCount);
+
+	for (size_t i = 0; i < floatRepCount; i++) {
+		floatRepKeys[i] = floatReps[i].first->c_str();
+		floatRepValues[i] = floatReps[i].second;
+	}
+
+	const prtx::Shape::ReportStringVect& stringReps = rep->mStrings;
+	const size_t stringRepCount = stringReps.size();
+	std::vector<const wchar_t*> stringRepKeys(stringRepCount);
+	std::vector<const wchar_t*> stringRepValues(stringRepCount);
+
+	for (size_t i = 0; i < stringRepCount; i++) {
+		stringRepKeys[i] = stringReps[i].first->c_str();
+		stringRepValues[i] = stringReps[i].second->c_str();
+	}
+
+	cb.addReports(initialShapeIndex, stringRepKeys.data(), stringRepValues.data(), stringRepCount,
+	              floatRepKeys.data(), floatRepValues.data(), floatRepCount, boolRepKeys.data(), boolRepValues.get(),
+	              boolRepCount);
+}
+
+/**
+ * Flattens the meshes of one finalized instance into the output buffers, which are sized once up front. Indices are
+ * offset by vertexIndexBase, which is advanced by the vertex count of the instance. With TRIANGLES the preparator
+ * has triangulated the meshes and all faces have three vertices. With SOA the coordinates are written as separate
+ * x, y and z blocks of the vertex count each instead of interleaved.
+ */
+template <bool TRIANGLES, bool SOA>
+void flattenMeshes(const prtx::MeshPtrVector& meshes, uint32_t& vertexIndexBase, std::vector<double>& vertexCoords,
+                   std::vector<uint32_t>& faceIndices, std::vector<uint32_t>& faceCounts) {
+	size_t vertexCoordCount = 0;
+	size_t faceCount = 0;
+	size_t indexCount = 0;
+	for (const auto& mesh : meshes) {
+		vertexCoordCount += mesh->getVertexCoords().size();
+		faceCount += mesh->getFaceCount();
+		if (!TRIANGLES) {
+			for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi)
+				indexCount += mesh->getFaceVertexCount(fi);
+		}
+	}
+	if (TRIANGLES)
+		indexCount = 3 * faceCount;
+
+	vertexCoords.resize(vertexCoordCount);
+	faceIndices.resize(indexCount);
+	faceCounts.resize(faceCount);
+
+	const size_t vertexCount = vertexCoordCount / 3;
+	double* const vertexOut = vertexCoords.data();
+	uint32_t* indexOut = faceIndices.data();
+	uint32_t* faceCountOut = faceCounts.data();
+	size_t vertexPos = 0;
+	for (const auto& mesh : meshes) {
+		const prtx::DoubleVector& verts = mesh->getVertexCoords();
+		const size_t meshVertexCount = verts.size() / 3;
+		if (SOA) {
+			double* x = vertexOut + vertexPos;
+			double* y = x + vertexCount;
+			double* z = y + vertexCount;
+			for (size_t vi = 0; vi < meshVertexCount; vi++) {
+				x[vi] = verts[3 * vi];
+				y[vi] = verts[3 * vi + 1];
+				z[vi] = verts[3 * vi + 2];
+			}
+		}
+		else
+			std::copy(verts.begin(), verts.end(), vertexOut + 3 * vertexPos);
+		vertexPos += meshVertexCount;
+
+		const uint32_t meshFaceCount = mesh->getFaceCount();
+		for (uint32_t fi = 0; fi < meshFaceCount; ++fi) {
+			const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
+			const uint32_t vtxCnt = TRIANGLES ? 3 : mesh->getFaceVertexCount(fi);
+			*faceCountOut++ = vtxCnt;
+			for (uint32_t vi = 0; vi < vtxCnt; vi++)
+				*indexOut++ = vtxIdx[vi] + vertexIndexBase;
+		}
+		vertexIndexBase += (uint32_t)meshVertexCount;
+	}
+}
+
 } // namespace
 
 const std::wstring PyEncoder::ID = L"com.esri.pyprt.PyEncoder";
@@ -64,75 +313,86 @@ const std::wstring PyEncoder::DESCRIPTION = L"Encodes geometry and CGA report fo
 /**
  * Setup two namespaces for mesh and material objects and initialize the encode
  * preprator. The namespaces are used to create unique names for all mesh and
- * material objects.
+ * material objects. The encode kernel for the output options is selected here.
  */
 void PyEncoder::init(prtx::GenerateContext& /*context*/) {
 	prtx::NamePreparator::NamespacePtr nsMaterials = mNamePreparator.newNamespace();
 	prtx::NamePreparator::NamespacePtr nsMeshes = mNamePreparator.newNamespace();
 	mEncodePreparator = prtx::EncodePreparator::create(true, mNamePreparator, nsMeshes, nsMaterials);
+
+	const prt::AttributeMap* options = getOptions();
+	mLeafAttributeKeys.clear();
+	size_t keyCount = 0;
+	const wchar_t* const* keys = options->getStringArray(EO_LEAF_ATTRIBUTES, &keyCount);
+	for (size_t k = 0; k < keyCount; k++) {
+		if (keys[k] != nullptr && keys[k][0] != L'\0')
+			mLeafAttributeKeys.emplace_back(keys[k]);
+	}
+
+	uint32_t flags = 0;
+	if (options->getBool(EO_EMIT_REPORT))
+		flags |= EMIT_REPORT;
+	if (!mLeafAttributeKeys.empty())
+		flags |= LEAF_ATTRIBUTES;
+	if (options->getBool(EO_EMIT_GEOMETRY)) {
+		flags |= EMIT_GEOMETRY;
+		if (options->getBool(EO_RESTORE_OFFSETS))
+			flags |= RESTORE_OFFSETS;
+		if (options->getBool(EO_TRIANGULATE))
+			flags |= TRIANGULATE;
+		const wchar_t* vertexLayout = options->getString(EO_VERTEX_LAYOUT);
+		if (vertexLayout != nullptr && VERTEX_LAYOUT_SOA == vertexLayout)
+			flags |= SEPARATE_VERTEX_COMPONENTS;
+		else if (vertexLayout != nullptr && VERTEX_LAYOUT_AOS != vertexLayout) {
+			const std::wstring msg = L"unknown vertex layout '" + std::wstring(vertexLayout) +
+			                         L"', expected 'aos' or 'soa', falling back to 'aos'";
+			prt::log(msg.c_str(), prt::LOG_ERROR);
+		}
+		if (options->getBool(EO_FACE_CLASSES))
+			flags |= FACE_CLASSES;
+	}
+	mFaceClassThreshold = options->getFloat(EO_FACE_CLASS_THRESHOLD);
+
+	mPreparationFlags = ENC_PREP_FLAGS;
+	mPreparationFlags.triangulate((flags & TRIANGULATE) != 0);
+	mPreparationFlags.mergeVertices(options->getBool(EO_MERGE_VERTICES));
+	mEncodeKernel = selectEncodeKernel(flags, std::make_index_sequence<ENCODE_FLAG_COMBINATIONS>());
 }
 
 /**
  * During encoding we collect the resulting shapes and reports with the encode
  * preparator. In case the shape generation fails, we collect the initial shape.
+ * The output options are template parameters, so the per shape and per face
+ * loops do not test them.
  */
-void PyEncoder::encode(prtx::GenerateContext& context, size_t initialShapeIndex) {
+template <uint32_t FLAGS>
+void PyEncoder::encodeKernel(prtx::GenerateContext& context, size_t initialShapeIndex) {
+	constexpr bool emitReport = (FLAGS & EMIT_REPORT) != 0;
+	constexpr bool emitGeometry = (FLAGS & EMIT_GEOMETRY) != 0;
+	constexpr bool restoreOffsets = (FLAGS & RESTORE_OFFSETS) != 0;
+	constexpr bool leafAttributesEnabled = (FLAGS & LEAF_ATTRIBUTES) != 0;
+	constexpr bool triangulate = (FLAGS & TRIANGULATE) != 0;
+	constexpr bool separateComponents = (FLAGS & SEPARATE_VERTEX_COMPONENTS) != 0;
+	constexpr bool faceClassesEnabled = (FLAGS & FACE_CLASSES) != 0;
 
 	const prtx::InitialShape* is = context.getInitialShape(initialShapeIndex);
 	auto* cb = dynamic_cast<IPyCallbacks*>(getCallbacks());
 	if (cb == nullptr)
 		throw prtx::StatusException(prt::STATUS_ILLEGAL_CALLBACK_OBJECT);
 
-	if (getOptions()->getBool(EO_EMIT_REPORT)) {
-		prtx::ReportsAccumulatorPtr reportsAccumulator{prtx::SummarizingReportsAccumulator::create()};
-		prtx::ReportingStrategyPtr reportsCollector{
-		        prtx::AllShapesReportingStrategy::create(context, initialShapeIndex, reportsAccumulator)};
-
-		prtx::ReportsPtr rep = reportsCollector->getReports();
-
-		if (rep) {
-			const prtx::Shape::ReportBoolVect& boolReps = rep->mBools;
-			const size_t boolRepCount = boolReps.size();
-			std::vector<const wchar_t*> boolRepKeys(boolRepCount);
-			std::unique_ptr<bool[]> boolRepValues(new bool[boolRepCount]);
-
-			for (size_t i = 0; i < boolRepCount; i++) {
-				boolRepKeys[i] = boolReps[i].first->c_str();
-				boolRepValues[i] = boolReps[i].second;
-			}
-
-			const prtx::Shape::ReportFloatVect& floatReps = rep->mFloats;
-			const size_t floatRepCount = floatReps.size();
-			std::vector<const wchar_t*> floatRepKeys(floatRepCount);
-			std::vector<double> floatRepValues(floatRepCount);
-
-			for (size_t i = 0; i < floatRepCount; i++) {
-				floatRepKeys[i] = floatReps[i].first->c_str();
-				floatRepValues[i] = floatReps[i].second;
-			}
-
-			const prtx::Shape::ReportStringVect& stringReps = rep->mStrings;
-			const size_t stringRepCount = stringReps.size();
-			std::vector<const wchar_t*> stringRepKeys(stringRepCount);
-			std::vector<const wchar_t*> stringRepValues(stringRepCount);
+	if (emitReport)
+		emitReports(*cb, context, initialShapeIndex);
 
-			for (size_t i = 0; i < stringRepCount; i++) {
-				stringRepKeys[i] = stringReps[i].first->c_str();
-				stringRepValues[i] = stringReps[i].second->c_str();
-			}
+	LeafAttributeCollector leafAttributes(mLeafAttributeKeys);
 
-			cb->addReports(initialShapeIndex, stringRepKeys.data(), stringRepValues.data(), stringRepCount,
-			               floatRepKeys.data(), floatRepValues.data(), floatRepCount, boolRepKeys.data(),
-			               boolRepValues.get(), boolRepCount);
-		}
-	}
-
-	if (getOptions()->getBool(EO_EMIT_GEOMETRY)) {
+	if (emitGeometry) {
 		try {
 			const prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
 
 			for (prtx::ShapePtr shape = li->getNext(); shape.get() != nullptr; shape = li->getNext()) {
 				mEncodePreparator->add(context.getCache(), shape, is->getAttributeMap());
+				if (leafAttributesEnabled)
+					leafAttributes.add(*shape);
 			}
 		}
 		catch (...) {
@@ -140,38 +400,80 @@ void PyEncoder::encode(prtx::GenerateContext& context, size_t initialShapeIndex)
 		}
 
 		std::vector<prtx::EncodePreparator::FinalizedInstance> finalizedInstances;
-		mEncodePreparator->fetchFinalizedInstances(finalizedInstances, ENC_PREP_FLAGS);
+		mEncodePreparator->fetchFinalizedInstances(finalizedInstances, mPreparationFlags);
+
+		// the callbacks append each instance to the buffers of its initial shape, so the indices continue over all
+		// instances
 		uint32_t vertexIndexBase = 0;
 
 		std::vector<double> vertexCoords;
 		std::vector<uint32_t> faceIndices;
 		std::vector<uint32_t> faceCounts;
+		std::vector<uint8_t> faceClasses;
 
 		for (const auto& instance : finalizedInstances) {
-			const prtx::MeshPtrVector& meshes = instance.getGeometry()->getMeshes();
-
-			vertexCoords.clear();
-			faceIndices.clear();
-			faceCounts.clear();
-
-			for (const auto& mesh : meshes) {
-				const prtx::DoubleVector& verts = mesh->getVertexCoords();
-				vertexCoords.insert(vertexCoords.end(), verts.begin(), verts.end());
-
-				for (uint32_t fi = 0; fi < mesh->getFaceCount(); ++fi) {
-					const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
-					const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
-					faceCounts.push_back(vtxCnt);
-					for (uint32_t vi = 0; vi < vtxCnt; vi++)
-						faceIndices.push_back(vtxIdx[vi] + vertexIndexBase);
+			const uint32_t instanceIndexBase = vertexIndexBase;
+			flattenMeshes<triangulate, separateComponents>(instance.getGeometry()->getMeshes(), vertexIndexBase,
+			                                               vertexCoords, faceIndices, faceCounts);
+
+			if (restoreOffsets) {
+				const double* offset = cb->getOffset(instance.getInitialShapeIndex());
+				if (offset != nullptr) {
+					if (separateComponents)
+						translateVertexComponents(vertexCoords, offset);
+					else
+						pcu::translateVertices(vertexCoords.data(), vertexCoords.size() / 3, offset);
 				}
-				vertexIndexBase += (uint32_t)verts.size() / 3;
 			}
 
-			cb->addGeometry(instance.getInitialShapeIndex(), vertexCoords.data(), vertexCoords.size(),
-			                faceIndices.data(), faceIndices.size(), faceCounts.data(), faceCounts.size());
+			if (separateComponents) {
+				const size_t vertexCount = vertexCoords.size() / 3;
+				const double* x = vertexCoords.data();
+				cb->addGeometryComponents(instance.getInitialShapeIndex(), x, x + vertexCount, x + 2 * vertexCount,
+				                          vertexCount, faceIndices.data(), faceIndices.size(), faceCounts.data(),
+				                          faceCounts.size());
+			}
+			else
+				cb->addGeometry(instance.getInitialShapeIndex(), vertexCoords.data(), vertexCoords.size(),
+				                faceIndices.data(), faceIndices.size(), faceCounts.data(), faceCounts.size());
+
+			if (faceClassesEnabled) {
+				const size_t vertexCount = vertexCoords.size() / 3;
+				const size_t vertexStride = separateComponents ? 1 : 3;
+				const size_t componentStride = separateComponents ? vertexCount : 1;
+				double classAreas[FACE_CLASS_COUNT] = {0.0, 0.0, 0.0};
+				faceClasses.resize(faceCounts.size());
+				classifyFaces(vertexCoords.data(), vertexStride, componentStride, faceIndices.data(),
+				              faceCounts.data(), faceCounts.size(), instanceIndexBase, mFaceClassThreshold,
+				              faceClasses.data(), classAreas);
+				cb->addFaceClasses(instance.getInitialShapeIndex(), faceClasses.data(), faceClasses.size(),
+				                   classAreas);
+			}
 		}
 	}
+	else if (leafAttributesEnabled) {
+		try {
+			const prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
+			for (prtx::ShapePtr shape = li->getNext(); shape.get() != nullptr; shape = li->getNext())
+				leafAttributes.add(*shape);
+		}
+		catch (...) {
+			// generation failed, there are no leaf shapes to report
+		}
+	}
+
+	if (leafAttributesEnabled)
+		leafAttributes.emit(*cb, initialShapeIndex);
+}
+
+template <size_t... FLAGS>
+PyEncoder::EncodeKernel PyEncoder::selectEncodeKernel(uint32_t flags, std::index_sequence<FLAGS...>) {
+	static const EncodeKernel kernels[] = {&PyEncoder::encodeKernel<FLAGS>...};
+	return kernels[flags];
+}
+
+void PyEncoder::encode(prtx::GenerateContext& context, size_t initialShapeIndex) {
+	(this->*mEncodeKernel)(context, initialShapeIndex);
 }
 
 void PyEncoder::finish(prtx::GenerateContext& /*context*/) {}
@@ -197,6 +499,14 @@ PyEncoderFactory* PyEncoderFactory::createInstance() {
 	amb->setBool(EO_ERROR_FALLBACK, prtx::PRTX_TRUE);  // required by CityEngine
 	amb->setBool(EO_EMIT_REPORT, prtx::PRTX_TRUE);
 	amb->setBool(EO_EMIT_GEOMETRY, prtx::PRTX_TRUE);
+	amb->setBool(EO_RESTORE_OFFSETS, prtx::PRTX_FALSE);
+	amb->setBool(EO_TRIANGULATE, prtx::PRTX_FALSE);    // triangle faces only
+	amb->setString(EO_VERTEX_LAYOUT, L"aos");          // "aos" (interleaved xyz) or "soa" (separate x, y and z)
+	amb->setBool(EO_FACE_CLASSES, prtx::PRTX_FALSE);   // roof, wall or ground per face
+	amb->setFloat(EO_FACE_CLASS_THRESHOLD, 0.25);      // y component of the unit normal that separates roofs and walls
+	amb->setBool(EO_MERGE_VERTICES, prtx::PRTX_FALSE); // faces share vertices at equal positions
+	const wchar_t* const noLeafAttributes[] = {L""};
+	amb->setStringArray(EO_LEAF_ATTRIBUTES, noLeafAttributes, 0); // keys of the leaf attributes to report
 	encoderInfoBuilder.setDefaultOptions(amb->createAttributeMap());
 
 	// CityEngine requires the following annotations to create an UI for an
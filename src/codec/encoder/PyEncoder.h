@@ -28,7 +28,10 @@
 #include "prt/AttributeMap.h"
 #include "prt/Callbacks.h"
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 // forward declare some classes to reduce header inclusion
 namespace prtx {
@@ -55,6 +58,19 @@ public:
 private:
 	prtx::DefaultNamePreparator mNamePreparator;
 	prtx::EncodePreparatorPtr mEncodePreparator;
+	prtx::EncodePreparator::PreparationFlags mPreparationFlags;
+	std::vector<std::wstring> mLeafAttributeKeys;
+	double mFaceClassThreshold = 0.0;
+
+	// encode function specialized for the combination of output options, selected once in init
+	using EncodeKernel = void (PyEncoder::*)(prtx::GenerateContext& context, size_t initialShapeIndex);
+	EncodeKernel mEncodeKernel = nullptr;
+
+	template <uint32_t FLAGS>
+	void encodeKernel(prtx::GenerateContext& context, size_t initialShapeIndex);
+
+	template <size_t... FLAGS>
+	static EncodeKernel selectEncodeKernel(uint32_t flags, std::index_sequence<FLAGS...>);
 };
 
 class PyEncoderFactory : public prtx::EncoderFactory, public prtx::Singleton<PyEncoderFactory> {
@@ -0,0 +1,31 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+/**
+ * Hot loops marked with PYPRT_CPU_DISPATCH are compiled for several instruction sets and the variant for the CPU is
+ * selected via CPUID when the library is loaded (GCC function multi-versioning). The default variant is built for the
+ * portable target (-march=nocona), it is also the only one for other compilers and platforms.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#	define PYPRT_CPU_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#	define PYPRT_CPU_DISPATCH
+#endif
@@ -0,0 +1,36 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#include "vertexTransforms.h"
+#include "CpuDispatch.h"
+
+namespace pcu {
+
+// straight loop over the interleaved coordinates to allow vectorization
+PYPRT_CPU_DISPATCH void translateVertices(double* vertices, size_t vertexCount, const double* offset) {
+	const double ox = offset[0], oy = offset[1], oz = offset[2];
+	for (size_t v = 0; v < vertexCount; v++) {
+		double* p = vertices + 3 * v;
+		p[0] += ox;
+		p[1] += oy;
+		p[2] += oz;
+	}
+}
+
+} // namespace pcu
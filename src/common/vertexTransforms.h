@@ -0,0 +1,32 @@
+/**
+ * CityEngine SDK Geometry Encoder for Python
+ *
+ * Copyright (c) 2012-2020 Esri R&D Center Zurich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * A copy of the license is available in the repository's LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace pcu {
+
+/**
+ * In-place v' = v + offset of vertexCount interleaved xyz vertices. Shared by the encoder (restoring the recentering
+ * offsets) and the client (shape preparation), both build it with CPU dispatch (see CpuDispatch.h).
+ */
+void translateVertices(double* vertices, size_t vertexCount, const double* offsetXYZ);
+
+} // namespace pcu
@@ -55,3 +55,50 @@ class ExporterTest(unittest.TestCase):
             asset_output_file('Unittest4SLPK.slpk')))
         self.assertGreater(
             os.stat(asset_output_file('CGAReport.txt')).st_size, 0)
+
+    def test_native_writers(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False})
+        os.makedirs(os.path.dirname(asset_output_file('')), exist_ok=True)
+
+        self.assertTrue(pyprt.write_obj(model, asset_output_file('native.obj')))
+        with open(asset_output_file('native.obj')) as obj:
+            lines = obj.read().splitlines()
+        vertex_count = len(model[0].get_vertices()) // 3
+        self.assertEqual(sum(1 for l in lines if l.startswith('v ')), 2 * vertex_count)
+        self.assertEqual(sum(1 for l in lines if l.startswith('f ')), 2 * len(model[0].get_faces()))
+
+        self.assertTrue(pyprt.write_ply(model, asset_output_file('native.ply')))
+        with open(asset_output_file('native.ply'), 'rb') as ply:
+            self.assertTrue(ply.read(3) == b'ply')
+
+        triangle_count = sum(f - 2 for f in model[0].get_faces())
+        self.assertTrue(pyprt.write_stl(model, asset_output_file('native.stl')))
+        self.assertEqual(os.stat(asset_output_file('native.stl')).st_size, 84 + 2 * 50 * triangle_count)
+
+    def test_arrow_writer(self):
+        rpk = asset_file('envelope2002.rpk')
+        attrs = {'ruleFile': 'rules/typology/envelope2002.cgb', 'startRule': 'Default$Lot',
+                 'report_but_not_display_green': True}
+        shape_geo_from_obj = pyprt.InitialShape(
+            asset_file('building_parcel.obj'))
+        m = pyprt.ModelGenerator([shape_geo_from_obj])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': True, 'emitGeometry': False})
+        os.makedirs(os.path.dirname(asset_output_file('')), exist_ok=True)
+
+        with pyprt.ArrowWriter(asset_output_file('reports.arrow')) as writer:
+            writer.write(model)
+            writer.write(model)
+            self.assertEqual(writer.get_row_count(), 2)
+        with open(asset_output_file('reports.arrow'), 'rb') as arrow:
+            content = arrow.read()
+        self.assertEqual(content[:6], b'ARROW1')
+        self.assertEqual(content[-6:], b'ARROW1')
+        self.assertIn(b'Floor area_sum', content)
@@ -14,6 +14,10 @@
 # A copy of the license is available in the repository's LICENSE file.
 
 import os
+import shutil
+import struct
+import subprocess
+import tempfile
 import unittest
 
 import pyprt
@@ -115,6 +119,22 @@ class GeometryTest(unittest.TestCase):
             cnt += f
         self.assertEqual(cnt, len(model[0].get_indices()))
 
+    def test_triangulate(self):
+        rpk = asset_file('candler.rpk')
+        attrs = {'ruleFile': 'bin/candler.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo_from_obj = pyprt.InitialShape(
+            asset_file('candler_footprint.obj'))
+        m = pyprt.ModelGenerator([shape_geo_from_obj])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False})
+        triangulated = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                        'emitReport': False, 'triangulate': True})
+        faces = triangulated[0].get_faces()
+        self.assertTrue(all(f == 3 for f in faces))
+        self.assertEqual(len(triangulated[0].get_indices()), 3*len(faces))
+        self.assertGreaterEqual(len(faces), len(model[0].get_faces()))
+
     def test_path_geometry_initshapes(self):
         rpk = asset_file('extrusion_rule.rpk')
         attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
@@ -138,3 +158,532 @@ class GeometryTest(unittest.TestCase):
                              model3[0].get_vertices())
         self.assertListEqual(model2[0].get_vertices(),
                              model3[1].get_vertices())
+
+    def test_geometry_arrays(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False})
+        vertices = model[0].get_vertices_array()
+        self.assertEqual(vertices.shape, (len(model[0].get_vertices()) // 3, 3))
+        self.assertListEqual(vertices.ravel().tolist(), model[0].get_vertices())
+        offsets = model[0].get_face_offsets()
+        self.assertEqual(len(offsets), len(model[0].get_faces()) + 1)
+        self.assertEqual(offsets[-1], len(model[0].get_indices_array()))
+
+        arrays = model.get_mesh_arrays()
+        self.assertEqual(arrays['vertices'].shape[0], 2 * vertices.shape[0])
+        self.assertEqual(arrays['face_offsets'][-1], len(arrays['indices']))
+        self.assertEqual(arrays['indices'].max(), arrays['vertices'].shape[0] - 1)
+        self.assertListEqual(arrays['model_vertex_offsets'].tolist(),
+                             [0, vertices.shape[0], 2 * vertices.shape[0]])
+
+    def test_vertex_layout_soa(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False})
+        model_soa = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                     'emitReport': False, 'vertexLayout': 'soa'})
+        x, y, z = model_soa[0].get_vertex_component_arrays()
+        vertices = model[0].get_vertices_array()
+        self.assertListEqual(x.tolist(), vertices[:, 0].tolist())
+        self.assertListEqual(y.tolist(), vertices[:, 1].tolist())
+        self.assertListEqual(z.tolist(), vertices[:, 2].tolist())
+        self.assertListEqual(model_soa[0].get_vertices(), model[0].get_vertices())
+        self.assertListEqual(model_soa[0].get_indices(), model[0].get_indices())
+
+        arrays = model.get_mesh_arrays()
+        arrays_soa = model_soa.get_mesh_arrays(vertexLayout='soa')
+        self.assertNotIn('vertices', arrays_soa)
+        for axis, key in enumerate(['x', 'y', 'z']):
+            self.assertListEqual(arrays_soa[key].tolist(), arrays['vertices'][:, axis].tolist())
+        self.assertListEqual(arrays_soa['indices'].tolist(), arrays['indices'].tolist())
+
+    def test_face_classes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        for layout in ['aos', 'soa']:
+            model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                     'emitReport': False, 'faceClasses': True, 'vertexLayout': layout})
+            classes = model[0].get_face_classes_array()
+            self.assertEqual(len(classes), len(model[0].get_faces()))
+            self.assertIn(pyprt.FACE_CLASS_ROOF, classes.tolist())
+            self.assertIn(pyprt.FACE_CLASS_WALL, classes.tolist())
+            areas = model[0].get_face_class_areas()
+            self.assertAlmostEqual(areas['roof'], 200.0)
+            self.assertGreater(areas['wall'], 0.0)
+
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        self.assertEqual(len(model[0].get_face_classes_array()), 0)
+
+    def test_edge_adjacency(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        adjacency = model[0].get_edge_adjacency()
+        edge_count = adjacency['edge_vertices'].shape[0]
+        self.assertEqual(adjacency['edge_faces'].shape, (edge_count, 2))
+        self.assertEqual(len(adjacency['half_edge_edges']), len(model[0].get_indices()))
+        self.assertEqual(len(adjacency['welded_vertices']), len(model[0].get_vertices()) // 3)
+        self.assertTrue((adjacency['half_edge_edges'] < edge_count).all())
+        self.assertTrue((adjacency['edge_faces'][:, 0] >= 0).all())
+        # the walls of the extrusion meet the roof and each other
+        self.assertGreater((adjacency['edge_faces'][:, 1] >= 0).sum(), 0)
+
+        merged = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                  'emitReport': False, 'mergeVertices': True})
+        merged_adjacency = merged[0].get_edge_adjacency()
+        self.assertEqual(merged_adjacency['edge_vertices'].shape[0], edge_count)
+
+        adjacencies = model.get_edge_adjacencies()
+        self.assertEqual(len(adjacencies), 2)
+        self.assertListEqual(adjacencies[1]['edge_faces'].tolist(), adjacency['edge_faces'].tolist())
+
+    def test_sample_points(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False, 'faceClasses': True})
+        samples = model[0].sample_points(count=500, seed=3, normals=True)
+        self.assertEqual(samples['points'].shape, (500, 3))
+        self.assertEqual(samples['normals'].shape, (500, 3))
+        self.assertEqual(len(samples['face_classes']), 500)
+        self.assertTrue((samples['faces'] < len(model[0].get_faces())).all())
+        vertices = model[0].get_vertices_array()
+        self.assertTrue((samples['points'] >= vertices.min(axis=0) - 1e-9).all())
+        self.assertTrue((samples['points'] <= vertices.max(axis=0) + 1e-9).all())
+
+        again = model[0].sample_points(count=500, seed=3, normals=True)
+        self.assertListEqual(again['points'].tolist(), samples['points'].tolist())
+
+        batch = model.sample_points(density=0.5, seed=3)
+        self.assertNotIn('normals', batch)
+        offsets = batch['model_point_offsets']
+        self.assertEqual(len(offsets), 3)
+        self.assertEqual(offsets[-1], batch['points'].shape[0])
+        self.assertEqual(offsets[1], offsets[2] - offsets[1])
+
+    def test_sample_points_concave(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb', 'startRule': 'Default$Footprint', 'minBuildingHeight': 10.0,
+                 'maxBuildingHeight': 10.0}
+        # L-shaped footprint, the notch is 10 < x < 20 and 10 < z < 20
+        shape_geo = pyprt.InitialShape(
+            [0.0, 0.0, 20.0, 0.0, 0.0, 0.0, 20.0, 0.0, 0.0, 20.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 20.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        self.assertIn(6, model[0].get_faces())  # the roof is not triangulated
+
+        points = model[0].sample_points(count=1000, seed=3)['points'].tolist()
+        in_notch = [p for p in points if p[0] > 10.0 + 1e-9 and p[2] > 10.0 + 1e-9]
+        self.assertListEqual(in_notch, [])
+
+    def test_voxelize(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb', 'startRule': 'Default$Footprint', 'minBuildingHeight': 20.0,
+                 'maxBuildingHeight': 20.0}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+
+        surface = model[0].voxelize(voxelSize=1.0)
+        self.assertEqual(surface['origin'][0], -10.0)
+        self.assertListEqual(list(surface['dims']), [21, 21, 11])
+        self.assertEqual(surface['occupancy'].shape, (surface['dims'][2], surface['dims'][1], 3))
+        sparse = model[0].voxelize(voxelSize=1.0, sparse=True)
+        surface_count = sum(bin(b).count('1') for b in surface['occupancy'].ravel().tolist())
+        self.assertEqual(sparse['voxels'].shape, (surface_count, 3))
+
+        solid = model[0].voxelize(voxelSize=1.0, solid=True, sparse=True)
+        self.assertGreater(len(solid['voxels']), surface_count)
+        self.assertEqual(len(solid['voxels']), 21 * 21 * 11)  # the closed box fills its whole grid
+
+        grids = model.voxelize(voxelSize=1.0, solid=True, sparse=True)
+        self.assertEqual(len(grids), 2)
+        self.assertListEqual(grids[1]['voxels'].tolist(), solid['voxels'].tolist())
+        tile = model.voxelize_tile(origin=solid['origin'], dims=solid['dims'], voxelSize=1.0, solid=True,
+                                   sparse=True)
+        self.assertListEqual(tile['voxels'].tolist(), solid['voxels'].tolist())
+
+    def test_height_map(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb', 'startRule': 'Default$Footprint', 'minBuildingHeight': 20.0,
+                 'maxBuildingHeight': 20.0}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+
+        dsm = model.rasterize_height_map(origin=(-15.0, -5.0), dims=(20, 30), cellSize=1.0, ids=True)
+        heights = dsm['heights'].tolist()
+        self.assertEqual(dsm['heights'].shape, (20, 30))
+        self.assertEqual(sum(h == 20.0 for row in heights for h in row), 200)
+        self.assertEqual(sum(h != h for row in heights for h in row), 400)
+        self.assertEqual(heights[10][15], 20.0)
+        self.assertEqual(dsm['ids'][10][15], 0)
+        self.assertEqual(dsm['ids'][0][0], -1)
+        self.assertNotIn('ids', model.rasterize_height_map(origin=(-15.0, -5.0), dims=(20, 30), cellSize=1.0))
+        with self.assertRaises(ValueError):
+            model.rasterize_height_map(origin=(-15.0, -5.0), dims=(20, 30), cellSize=0.0)
+
+    def test_height_map_concave(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb', 'startRule': 'Default$Footprint', 'minBuildingHeight': 10.0,
+                 'maxBuildingHeight': 10.0}
+        # L-shaped footprint, the notch is 10 < x < 20 and 10 < z < 20
+        shape_geo = pyprt.InitialShape(
+            [0.0, 0.0, 20.0, 0.0, 0.0, 0.0, 20.0, 0.0, 0.0, 20.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 20.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+
+        heights = model.rasterize_height_map(origin=(0.0, 0.0), dims=(20, 20), cellSize=1.0)['heights'].tolist()
+        self.assertEqual(sum(h == 10.0 for row in heights for h in row), 300)
+        self.assertTrue(all(h != h for row in heights[10:] for h in row[10:]))
+
+    def test_wkb_wkt_initshapes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        # the clockwise ring is reversed by the parser and starts at its last distinct vertex
+        shape_geo = pyprt.InitialShape(
+            [10.0, 0.0, 10.0, 10.0, 0.0, 0.0, -10.0, 0.0, 0.0, -10.0, 0.0, 10.0])
+        ring = [(-10.0, -10.0), (-10.0, 0.0), (10.0, 0.0), (10.0, -10.0), (-10.0, -10.0)]
+        wkb = struct.pack('<BII', 1, 3, 1) + struct.pack('<I', len(ring)) + \
+            b''.join(struct.pack('<dd', x, y) for x, y in ring)
+        wkt = 'POLYGON((' + ', '.join('{} {}'.format(x, y) for x, y in ring) + '))'
+
+        from_wkt = pyprt.initial_shapes_from_wkt([wkt, 'LINESTRING(0 0, 1 1)'])
+        from_wkb = pyprt.initial_shapes_from_wkb([wkb, wkb[:-8]])
+        self.assertEqual(len(from_wkt), 1)
+        self.assertListEqual(from_wkt.get_source_indices(), [0])
+        self.assertEqual(from_wkt.get_errors()[0][0], 1)
+        self.assertEqual(len(from_wkb), 1)
+        self.assertEqual(from_wkb.get_errors()[0][0], 1)
+
+        model_ref = pyprt.ModelGenerator([shape_geo]).generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        for shapes in [from_wkt, from_wkb]:
+            model = pyprt.ModelGenerator(shapes).generate_model(
+                [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+            self.assertListEqual(model[0].get_vertices(),
+                                 model_ref[0].get_vertices())
+
+    def test_obj_initshapes(self):
+        rpk = asset_file('envelope2002.rpk')
+        attrs = {'ruleFile': 'rules/typology/envelope2002.cgb',
+                 'startRule': 'Default$Lot'}
+        shapes = pyprt.initial_shapes_from_obj(
+            asset_file('building_parcel.obj'), splitGroups=True)
+        self.assertEqual(len(shapes), 1)
+        self.assertListEqual(shapes.get_names(), ['CityEngineShapeMaterial'])
+        self.assertEqual(len(pyprt.initial_shapes_from_obj(
+            asset_file('no_such_file.obj'))), 0)
+
+        shape_geo_from_obj = pyprt.InitialShape(
+            asset_file('building_parcel.obj'))
+        model_ref = pyprt.ModelGenerator([shape_geo_from_obj]).generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        model = pyprt.ModelGenerator(shapes).generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        self.assertListEqual(model[0].get_vertices(),
+                             model_ref[0].get_vertices())
+
+    def test_validate_repair_initshapes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 0.0, -10.0, 0.0, 0.0])
+        shape_geo_dup = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 0.0, -10.0, 0.0, 0.0, -10.0, 0.0, 10.0])
+
+        m_check = pyprt.ModelGenerator([shape_geo, shape_geo_dup], {'validate': True})
+        diagnostics = m_check.get_shape_diagnostics()
+        self.assertTrue(diagnostics[0].valid)
+        self.assertFalse(diagnostics[1].valid)
+        self.assertListEqual(diagnostics[1].issues, ['duplicate_vertices'])
+
+        m = pyprt.ModelGenerator([shape_geo, shape_geo_dup], {'repair': True})
+        diagnostics = m.get_shape_diagnostics()
+        self.assertTrue(diagnostics[1].valid)
+        self.assertEqual(diagnostics[1].removed_vertices, 2)
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': False})
+        self.assertListEqual(model[0].get_vertices(), model[1].get_vertices())
+
+    def test_simplify_initshapes(self):
+        vertices = []
+        for i in range(100):  # 100 collinear vertices along the first edge
+            vertices += [i * 0.1, 0.0, 0.0]
+        vertices += [10.0, 0.0, 0.0, 10.0, 0.0, -10.0, 0.0, 0.0, -10.0]
+        shape_geo = pyprt.InitialShape(vertices)
+
+        m = pyprt.ModelGenerator([shape_geo], {'simplifyTolerance': 0.01})
+        self.assertEqual(m.get_shape_diagnostics()[0].simplified_vertices, 99)
+        stats = m.get_preparation_stats()
+        self.assertEqual(stats['input_vertex_count'], 103)
+        self.assertEqual(stats['output_vertex_count'], 4)
+
+    def test_recenter_initshapes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [2600000.0, 0.0, 1200010.0, 2600020.0, 0.0, 1200010.0, 2600020.0, 0.0, 1200000.0, 2600000.0, 0.0, 1200000.0])
+
+        model_ref = pyprt.ModelGenerator([shape_geo]).generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        m = pyprt.ModelGenerator([shape_geo], {'recenter': 'shape'})
+        model_local = m.generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        self.assertListEqual(model_local[0].get_offset(), [2600010.0, 0.0, 1200005.0])
+        self.assertLessEqual(max(abs(c) for c in model_local[0].get_vertices()), 100.0)
+        grid = model_local[0].voxelize(voxelSize=1.0)
+        self.assertEqual((grid['origin'][0], grid['origin'][2]), (2600000.0, 1200000.0))
+        self.assertEqual((grid['dims'][0], grid['dims'][2]), (21, 11))
+        dsm = model_local.rasterize_height_map(origin=(2600000.0, 1200000.0), dims=(10, 20), cellSize=1.0)
+        self.assertFalse(any(h != h for row in dsm['heights'].tolist() for h in row))
+
+        model_restored = m.generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False, 'restoreOffsets': True})
+        self.assertListEqual(model_restored[0].get_offset(), [0.0, 0.0, 0.0])
+        self.assertListEqual(model_restored[0].get_vertices(), model_ref[0].get_vertices())
+
+        # the batch outputs are in the input coordinates
+        restored = model_restored[0].get_vertices()
+        self.assertListEqual(model_local.get_mesh_arrays()['vertices'].ravel().tolist(), restored)
+        soa = model_local.get_mesh_arrays(vertexLayout='soa')
+        self.assertListEqual(soa['x'].tolist(), restored[0::3])
+        points = model_local.sample_points(count=100, seed=3)['points']
+        self.assertTrue((points[:, 0] >= 2600000.0 - 1e-6).all())
+        self.assertTrue((points[:, 2] >= 1200000.0 - 1e-6).all())
+
+    def test_context_attributes_initshapes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo_1 = pyprt.InitialShape(
+            [0.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, 0.0, 0.0, 0.0, 0.0])
+        shape_geo_2 = pyprt.InitialShape(
+            [12.0, 0.0, 10.0, 22.0, 0.0, 10.0, 22.0, 0.0, 0.0, 12.0, 0.0, 0.0])
+
+        model_ref = pyprt.ModelGenerator([shape_geo_1, shape_geo_2]).generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        m = pyprt.ModelGenerator([shape_geo_1, shape_geo_2], {
+            'contextAttributes': ['nearestNeighborDistance', 'neighborCount', 'streetFrontage'],
+            'neighborRadius': 5.0, 'streetTolerance': 3.0})
+        model = m.generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'emitReport': False})
+        self.assertEqual(len(model), 2)
+
+        # the shapes are 2 apart, the facing edges are within the street tolerance
+        context = m.get_context_attributes()
+        self.assertListEqual(context['Default$nearestNeighborDistance'], [2.0, 2.0])
+        self.assertListEqual(context['Default$neighborCount'], [1.0, 1.0])
+        self.assertListEqual(context['Default$streetFrontage'], [30.0, 30.0])
+        self.assertListEqual(model[0].get_vertices(), model_ref[0].get_vertices())
+        self.assertListEqual(model[1].get_vertices(), model_ref[1].get_vertices())
+
+    def test_rule_info(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        info = pyprt.get_rule_info(rpk)
+        self.assertEqual(info['rule_file'], 'bin/extrusion_rule.cgb')
+        self.assertIn('Default$Footprint', [r['name'] for r in info['rules']])
+        for a in info['attributes']:
+            self.assertIn(a['type'], ['bool', 'float', 'string', 'bool[]', 'float[]', 'string[]'])
+        self.assertDictEqual(pyprt.get_rule_info(rpk, 'bin/extrusion_rule.cgb'), info)
+
+    def test_evaluate_attributes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        shape_geo_2 = pyprt.InitialShape(
+            [0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0, 0.0, 1.0, 1.0, 0.0, 0.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo_2])
+        attrs_2 = dict(attrs, minBuildingHeight=15.0)
+        values = m.evaluate_attributes([attrs, attrs_2], rpk)
+        info = pyprt.get_rule_info(rpk)
+        attribute_names = [a['name'] for a in info['attributes']]
+        self.assertGreater(len(values), 0)
+        for key, column in values.items():
+            self.assertIn(key, attribute_names)
+            self.assertEqual(len(column), 2)
+        self.assertListEqual(values['Default$minBuildingHeight'].tolist(), [10.0, 15.0])
+        self.assertListEqual(values['Default$maxBuildingHeight'].tolist(), [30.0, 30.0])
+        self.assertListEqual(values['Default$text'], ['salut', 'salut'])
+
+    def test_leaf_attributes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        keys = [a['name'] for a in pyprt.get_rule_info(rpk)['attributes']] or ['Default$height']
+        model = m.generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {'leafAttributes': keys})
+        leaf_attributes = model[0].get_leaf_attributes()
+        self.assertListEqual(leaf_attributes['keys'], keys)
+        for value_type in ['bool', 'float', 'string']:
+            columns = leaf_attributes[value_type]
+            self.assertEqual(len(columns['shape_id']), len(columns['value']))
+            self.assertEqual(len(columns['key_id']), len(columns['value']))
+
+        # the extrusion is the only leaf shape, it carries the rule attributes
+        model = m.generate_model([dict(attrs, minBuildingHeight=12.0)], rpk, 'com.esri.pyprt.PyEncoder',
+                                 {'leafAttributes': ['Default$minBuildingHeight', 'Default$text']})
+        leaf_attributes = model[0].get_leaf_attributes()
+        floats = leaf_attributes['float']
+        strings = leaf_attributes['string']
+        self.assertListEqual(floats['key_id'].tolist(), [0])
+        self.assertListEqual(floats['value'].tolist(), [12.0])
+        self.assertListEqual(strings['key_id'].tolist(), [1])
+        self.assertListEqual(strings['value'], ['salut'])
+        self.assertGreaterEqual(floats['shape_id'][0], 0)
+        self.assertEqual(strings['shape_id'][0], floats['shape_id'][0])
+
+    def test_extracted_rpk(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        with tempfile.TemporaryDirectory() as cache_dir:
+            extracted = pyprt.extract_rpk(rpk, cache_dir)
+            self.assertTrue(os.path.isdir(extracted))
+            self.assertEqual(pyprt.extract_rpk(rpk, cache_dir), extracted)
+            m = pyprt.ModelGenerator([shape_geo])
+            model = m.generate_model(
+                [attrs], rpk, 'com.esri.pyprt.PyEncoder', {})
+            model_extracted = m.generate_model(
+                [attrs], extracted, 'com.esri.pyprt.PyEncoder', {})
+            self.assertListEqual(
+                model_extracted[0].get_vertices(), model[0].get_vertices())
+
+    def test_reload_rpk(self):
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        with tempfile.TemporaryDirectory() as rpk_dir:
+            rpk = os.path.join(rpk_dir, 'published.rpk')
+            shutil.copyfile(asset_file('extrusion_rule.rpk'), rpk)
+            m = pyprt.ModelGenerator([shape_geo])
+            model = m.generate_model(
+                [attrs], rpk, 'com.esri.pyprt.PyEncoder', {})
+            self.assertFalse(m.reload_rule_package())
+            os.utime(rpk, (0, 0))
+            self.assertFalse(m.reload_rule_package())
+            shutil.copyfile(asset_file('candler.rpk'), rpk)
+            self.assertTrue(m.reload_rule_package())
+            self.assertFalse(m.reload_rule_package())
+            self.assertTrue(m.reload_rule_package(force=True))
+            self.assertGreater(len(model[0].get_vertices()), 0)
+
+            # the next generation uses the swapped content at the same path
+            candler_attrs = {'ruleFile': 'bin/candler.cgb', 'startRule': 'Default$Footprint'}
+            model_reloaded = m.generate_model([candler_attrs])
+            model_ref = pyprt.ModelGenerator([shape_geo]).generate_model(
+                [candler_attrs], asset_file('candler.rpk'), 'com.esri.pyprt.PyEncoder', {})
+            self.assertGreater(len(model_ref[0].get_vertices()), 0)
+            self.assertListEqual(model_reloaded[0].get_vertices(), model_ref[0].get_vertices())
+            self.assertNotEqual(model_reloaded[0].get_vertices(), model[0].get_vertices())
+
+    def test_prefetch_assets(self):
+        rpk = asset_file('candler.rpk')
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        m = pyprt.ModelGenerator([shape_geo])
+        stats = m.prefetch_assets(rpk)
+        self.assertGreaterEqual(stats['rule_file_count'], 1)
+        self.assertListEqual(stats['errors'], [])
+        self.assertGreaterEqual(stats['seconds'], 0.0)
+
+    def test_categorical_attributes(self):
+        rpk = asset_file('extrusion_rule.rpk')
+        attrs = {'ruleFile': 'bin/extrusion_rule.cgb',
+                 'startRule': 'Default$Footprint'}
+        shape_geo = pyprt.InitialShape(
+            [-10.0, 0.0, 10.0, -10.0, 0.0, 0.0, 10.0, 0.0, 0.0, 10.0, 0.0, 10.0])
+        shape_geo_2 = pyprt.InitialShape(
+            [0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0, 0.0, 1.0, 1.0, 0.0, 0.0])
+        m = pyprt.ModelGenerator([shape_geo, shape_geo_2])
+        self.assertFalse(m.set_categorical_attributes(
+            {'Default$text': ([0], ['R1'])}))
+        self.assertFalse(m.set_categorical_attributes(
+            {'Default$text': ([0, 1], ['R1'])}))
+        self.assertTrue(m.set_categorical_attributes(
+            {'Default$text': ([1, -1], ['R1', 'C2'])}))
+        model = m.generate_model(
+            [attrs], rpk, 'com.esri.pyprt.PyEncoder', {})
+        self.assertEqual(len(model), 2)
+
+        # the second shape has no code and keeps the rule default
+        values = m.evaluate_attributes([attrs])
+        self.assertListEqual(values['Default$text'], ['C2', 'salut'])
+
+    def test_report_columns(self):
+        rpk = asset_file('envelope2002.rpk')
+        attrs = {'ruleFile': 'rules/typology/envelope2002.cgb', 'startRule': 'Default$Lot',
+                 'report_but_not_display_green': True}
+        shape_geo_from_obj = pyprt.InitialShape(
+            asset_file('building_parcel.obj'))
+        m = pyprt.ModelGenerator([shape_geo_from_obj])
+        model = m.generate_model([attrs], rpk, 'com.esri.pyprt.PyEncoder', {
+                                 'emitReport': True, 'emitGeometry': False})
+        columns = model.get_report_columns()
+        rep = model[0].get_report()
+        for key, values in columns['float'].items():
+            self.assertEqual(len(values), 1)
+            self.assertAlmostEqual(values[0], rep[key])
+        for key, column in columns['string'].items():
+            self.assertEqual(column['dictionary'][column['codes'][0]], rep[key])
+
+    def test_batch_tool(self):
+        # installed next to the native module, see the install target of src/client/CMakeLists.txt
+        tool = os.path.join(os.path.dirname(pyprt.__file__), 'pyprt', 'bin', 'pyprt-batch')
+        if os.name == 'nt':
+            tool += '.exe'
+        self.assertTrue(os.path.exists(tool), 'pyprt-batch is missing from the installed build: ' + tool)
+
+        ring = [(-10.0, -10.0), (-10.0, 0.0), (10.0, 0.0), (10.0, -10.0), (-10.0, -10.0)]
+        wkt = 'POLYGON((' + ', '.join('{} {}'.format(x, y) for x, y in ring) + '))'
+        with tempfile.TemporaryDirectory() as work_dir:
+            wkt_file = os.path.join(work_dir, 'shapes.wkt')
+            with open(wkt_file, 'w') as f:
+                f.write(wkt + '\n' + 'LINESTRING(0 0, 1 1)\n' + wkt + '\n')
+            csv_file = os.path.join(work_dir, 'attributes.csv')
+            with open(csv_file, 'w') as f:
+                f.write('ruleFile,startRule\nbin/extrusion_rule.cgb,Default$Footprint\n,\n'
+                        'bin/extrusion_rule.cgb,Default$Footprint\n')
+            output = os.path.join(work_dir, 'models.obj')
+            result = subprocess.run([tool, '--rpk', asset_file('extrusion_rule.rpk'), '--wkt', wkt_file,
+                                     '--attributes', csv_file, '--output', output])
+            self.assertEqual(result.returncode, 0)
+            with open(output) as f:
+                groups = [line for line in f if line.startswith('o ')]
+            self.assertEqual(len(groups), 2)